@@ -0,0 +1,31 @@
+let Disruptor = require('..').Disruptor;
+let assert = require('assert');
+let d = new Disruptor('/example', 1024 * 64, 4, 1, 0, false, true);
+let seqs = d.sequences;
+let elements = d.elements;
+let num_elements = BigInt(1024 * 64);
+let i = 0;
+let start = new Date();
+
+while (i < 10000000)
+{
+    let seq = Atomics.load(seqs, 0);
+    let cursor = Atomics.load(seqs, 1);
+    let pos = Number(seq % num_elements);
+    let n = Number(cursor - seq);
+
+    for (let j = 0; j < n; j += 1)
+    {
+        assert.equal(elements.readUInt32LE(pos * 4, true), i++);
+        if (++pos === 1024 * 64)
+        {
+            pos = 0;
+        }
+    }
+
+    Atomics.store(seqs, 0, cursor);
+}
+
+let end = new Date();
+
+console.log(end - start);
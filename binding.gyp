@@ -2,7 +2,10 @@
   "targets": [
     {
       "target_name": "disruptor",
-      "sources": [ "src/disruptor.cc" ],
+      'variables': {
+        'trace%': 'false'
+      },
+      "sources": [ "src/disruptor.cc", "src/lz4.cc" ],
       "include_dirs": ["<!@(node -p \"require('node-addon-api').include\")"],
       "dependencies": ["<!(node -p \"require('node-addon-api').gyp\")"],
 
@@ -24,7 +27,13 @@
         [
           'OS == "linux"',
           {
-            'libraries': [ '-lrt' ],
+            'libraries': [ '-lrt', '-ldl' ],
+          }
+        ],
+        [
+          'trace == "true"',
+          {
+            'defines': [ 'DISRUPTOR_TRACE=1' ]
           }
         ],
         [
@@ -5,15 +5,32 @@
 
   @param {string} shm_name - Name of shared memory object to use (see {@link http://pubs.opengroup.org/onlinepubs/009695399/functions/shm_open.html|shm_open}).
   @param {integer} num_elements - Number of elements in the Disruptor (i.e. its capacity).
-  @param {integer} element_size - Size of each element in bytes.
+  @param {integer} element_size - Size of each element in bytes. This can be 0 when `options.columns` is given, in which case methods which copy, read or write element bytes ({@link Disruptor#produceSync|produceSync}, {@link Disruptor#produceManySync|produceManySync}, {@link Disruptor#produceFromSync|produceFromSync}, {@link Disruptor#consumeToSync|consumeToSync}, {@link Disruptor#produceCompressSync|produceCompressSync}, {@link Disruptor#consumeDecompressSync|consumeDecompressSync} and {@link Coalescer}) throw an error.
   @param {integer} num_consumers - Total number of objects that will be reading data from the Disruptor.
   @param {integer} consumer - Each object that reads data from the Disruptor must have a unique ID. This should be a number between 0 and `num_consumers - 1`. If the object is only going to write data, `consumer` can be anything.
   @param {boolean} init - Whether to create and initialize the shared memory backing the Disruptor. You should arrange your application so this is done once, at the start.
   @param {boolean} spin - If `true` then methods on this object which read from the Disruptor won't return to your application until a value is ready. Methods which write to the Disruptor won't return while the Disruptor is full. The `*Sync` methods will block Node's main thread and the asynchronous methods will repeatedly post tasks to the thread pool, in order to let other tasks get a look in. If you want to implement your own retry algorithm (or use some out-of-band notification mechanism), specify `spin` as `false` and check method return values.
+  @param {Object} [options] - Optional settings. Unless noted, every object using the same shared memory must pass the same settings.
+  @param {boolean} [options.overwrite=false] - If `true` then producers never wait for consumers. Instead, they overwrite the oldest elements, even if consumers haven't read them yet. Consumers which fall behind skip to the oldest element which hasn't been overwritten and the number of elements they skip is counted (see {@link Disruptor#dropped|dropped}). Use {@link Disruptor#consumeCheck|consumeCheck} to find out whether elements were overwritten while you were reading them.
+  @param {boolean} [options.pool=false] - If `true` then consumers share the work instead of each reading every element. Each element is returned to only one consumer, by whichever call to {@link Disruptor#consumeNew|consumeNew} (or similar) claims it first. Producers wait until the consumer which claimed an element commits it. Consumers which are idle must keep checking for new data (or be released with `mark_ignore`), otherwise producers will wait for them. Can't be used with `options.overwrite` or {@link Disruptor#consumeRewind|consumeRewind}.
+  @param {boolean} [options.share=false] - If `true` then objects in the same process (including in different worker threads) which pass `share` and the same `shm_name` use a single mapping of the shared memory, rather than each mapping it separately. The shared memory is unmapped once all of them have been {@link Disruptor#release|released}. Objects which pass `init` always make a new mapping. This can differ between objects. See also {@link Disruptor#handle|handle}.
+  @param {integer} [options.maxBatch=0] - Maximum number of elements returned by each call to {@link Disruptor#consumeNew|consumeNew} or {@link Disruptor#consumeNewSync|consumeNewSync}. Smaller batches are committed sooner so a consumer which has fallen behind holds up producers for less time. 0 means no limit. This can differ between objects.
+  @param {integer} [options.minBatch=1] - If fewer elements than this are available, wait up to `options.minWait` for more before returning them. This can differ between objects.
+  @param {integer} [options.minWait=0] - Maximum time in microseconds to wait for `options.minBatch` elements. While waiting, {@link Disruptor#consumeNew|consumeNew} and {@link Disruptor#consumeNewSync|consumeNewSync} behave as if no elements are available. This can differ between objects.
+  @param {boolean} [options.adaptive=false] - If `true`, measure how long it takes to process each element (from when they're returned to when they're committed) and limit batches to as many elements as can be processed in `options.targetLatency` (and no more than `options.maxBatch`). See {@link Disruptor#batchLimit|batchLimit}. This can differ between objects.
+  @param {integer} [options.targetLatency=1000] - Time in microseconds it should take to process each batch when `options.adaptive` is `true`. This can differ between objects.
+  @param {integer} [options.timeout=0] - If `spin` is `true`, the longest time in microseconds to wait for free elements when reserving or for new elements when reading. Once it's passed, methods return as if `spin` was `false`. 0 means wait forever. This doesn't apply to committing reserved elements, which always waits for other producers. See also {@link Disruptor#timeout|timeout}. This can differ between objects.
+  @param {boolean} [options.checksum=false] - If `true` then producers store a CRC32C checksum of each element (its bytes followed by its value in each of `options.columns`) when they commit it, and consumers check elements against their checksums when they're returned. Mismatches are counted in {@link Disruptor#checksumErrors|checksumErrors}. See also {@link Disruptor#verifyChecksums|verifyChecksums}. Checksums are calculated using SSE 4.2 or ARMv8 CRC instructions if available.
+  @param {boolean} [options.reclaim=false] - If `true` then a background thread gives the memory behind free elements back to the operating system, so a mostly idle Disruptor doesn't keep its peak memory use. Elements are free once every consumer has read them. Reclaimed elements read as zeros, so {@link Disruptor#readAt|readAt} won't return them and {@link Disruptor#verifyChecksums|verifyChecksums} won't check them. Producers treat elements the thread is working on as full, so they only wait for it if they'd wait for consumers (see `spin` and `options.timeout`). Producers stop waiting for an object which takes longer than a second (for example because its process died). {@link Disruptor#consumeRewind|consumeRewind} won't move consumers back onto reclaimed elements. Can't be used with `options.overwrite`. See {@link Disruptor#reclaimed|reclaimed}. This can differ between objects but typically only one object needs it.
+  @param {integer} [options.reclaimInterval=1000000] - How often in microseconds to look for free elements when `options.reclaim` is `true`.
+  @param {integer} [options.reclaimDistance=num_elements/2] - Number of free elements after the next one to be reserved which are kept when `options.reclaim` is `true`. Producers will use these soon, so giving them back would only mean allocating them again. Higher values reclaim less memory but avoid reclaiming during bursts.
+  @param {integer} [options.maxRecordSize=0] - Largest record in bytes (before compression) that {@link Disruptor#produceCompressSync|produceCompressSync} will write and {@link Disruptor#consumeDecompressSync|consumeDecompressSync} will decompress. Larger records are counted as corrupt, so a bad header can't make consumers allocate a huge buffer. 0 means records are only limited by how far LZ4 can expand their stored bytes (255 times). This can differ between objects.
+  @param {boolean} [options.resizable=false] - If `true` then the Disruptor can be replaced by a new generation with a different number of elements, without stopping producers or consumers. See {@link ResizableDisruptor}, which does this for you, and {@link Disruptor#setForward|setForward}.
+  @param {Object} [options.columns] - Store fields in columns as well as (or instead of) in `element_size` bytes per element. Maps each field's name to its type: `'int8'`, `'uint8'`, `'int16'`, `'uint16'`, `'int32'`, `'uint32'`, `'float32'`, `'float64'`, `'bigint64'` or `'biguint64'`. Each column holds one value for each element, in its own contiguous part of the shared memory, so scanning a single field touches only that field's values. See {@link Disruptor#columns|columns} and {@link Disruptor#columnsAt|columnsAt}. Field order matters: objects which list the fields in a different order (or with different types) from the one which initialised the shared memory throw an error.
  */
 class Disruptor
 {
-    constructor(shm_name, num_elements, element_size, num_consumers, consumer, init, spin)
+    constructor(shm_name, num_elements, element_size, num_consumers, consumer, init, spin, options)
     {
     }
 
@@ -127,9 +144,61 @@ class Disruptor
 
       A call to {@link Disruptor#consumeCommit|consumeCommit} is made before checking for new data.
 
-      @returns {Buffer[]} - Array of buffers containing new data ready to read from the Disruptor. If no new data was available and `spin` (see the {@link Disruptor|constructor}) is `false`, the array will be empty. Otherwise it will contain at least one buffer and each buffer will be a multiple of `element_size` in length. The buffers are backed by shared memory so may be overwritten after you call {@link Disruptor#consumeCommit|consumeCommit}.
+      @param {integer} [max] - Maximum number of elements to return. Any others are left for the next call. If omitted or 0, all new elements are returned.
+      @param {boolean} [spin] - Overrides `spin` (see the {@link Disruptor|constructor}) for this call.
+      @returns {Buffer[]} - Array of buffers containing new data ready to read from the Disruptor. If no new data was available and `spin` is `false`, the array will be empty. Otherwise it will contain at least one buffer and each buffer will be a multiple of `element_size` in length. The buffers are backed by shared memory so may be overwritten after you call {@link Disruptor#consumeCommit|consumeCommit}.
      */
-    consumeNewSync()
+    consumeNewSync(max, spin)
+    {
+    }
+
+    /**
+      Wait for new data without reading it. The thread pool checks for
+      elements written after those returned by the last call to
+      {@link Disruptor#consumeNew|consumeNew} or
+      {@link Disruptor#consumeNewSync|consumeNewSync} (or, if they've been
+      committed, after the last committed element), so you can start waiting
+      for the next batch while you're still processing the current one.
+      This waits regardless of `spin` and `options.timeout`. If
+      `options.minWait` is set, it waits for `options.minBatch` elements
+      or until `options.minWait` has passed since they started arriving, as
+      {@link Disruptor#consumeNewSync|consumeNewSync} would.
+
+      In `options.pool` mode, another consumer may read the new data first.
+
+      @returns {Promise} - Resolves to `true` when there's new data to read, or `false` if the object is released or {@link Disruptor#consumeWaitCancel|consumeWaitCancel} is called first.
+     */
+    consumeWait()
+    {
+    }
+
+    /**
+      Stop all waits started by {@link Disruptor#consumeWait|consumeWait} on this object.
+     */
+    consumeWaitCancel()
+    {
+    }
+
+    /**
+      Read new data using `for await`. Each batch is committed when you ask
+      for the next one, or when you leave the loop with `break` or `return`.
+      If the iterator's `throw()` method is called instead, the batch isn't
+      committed: call {@link Disruptor#consumeRewind|consumeRewind(0)} to
+      read it again (otherwise the next read commits it). Note a `for await`
+      loop ends with `return()` when its body throws, so catch errors inside
+      the loop if the batch shouldn't be committed. While you process each
+      batch, the thread pool waits for the next one (see
+      {@link Disruptor#consumeWait|consumeWait}), so the next batch is
+      often ready as soon as you ask for it.
+
+      Iterating over the Disruptor itself (`for await (const b of disruptor)`) does the same with no `max`.
+
+      Don't {@link Disruptor#release|release} the Disruptor while you're processing a batch. If it's released while waiting, the loop ends.
+
+      @param {integer} [max] - Maximum number of elements in each batch. If omitted or 0, there's no limit (other than `options.maxBatch`).
+      @returns {AsyncIterator<Object>} - Yields objects with `bufs` and `start` properties, as passed to {@link consumeNewCallback}.
+     */
+    batches(max)
     {
     }
 
@@ -147,6 +216,73 @@ class Disruptor
     {
     }
 
+    /**
+      Tell the Disruptor you've finished reading some of the data returned by
+      {@link Disruptor#consumeNew|consumeNew} or {@link Disruptor#consumeNewSync|consumeNewSync}.
+      Producers can then reuse the space while you carry on processing the
+      rest. Don't use the parts of the buffers you've committed again.
+
+      A later call to {@link Disruptor#consumeCommit|consumeCommit} commits the rest.
+
+      @param {integer} seq - The Disruptor maintains a strictly increasing count of the total number of elements consumed since it was created. Elements before this are committed. Must be no more than `start` plus the number of elements returned (see {@link consumeNewCallback}). If it's not more than the elements already committed, nothing happens.
+      @return {boolean} - Whether the Disruptor was in the expected state (see {@link Disruptor#consumeCommit|consumeCommit}).
+     */
+    consumeCommitUpTo(seq)
+    {
+    }
+
+    /**
+      Move this object's consumer back so it reads recently produced data again.
+      Use this when a consumer starts late and wants to warm up from data
+      already in the Disruptor.
+
+      The consumer won't be moved back past data the slowest other active
+      consumer hasn't read yet (or past data which may have been overwritten
+      or whose memory has been reclaimed - see `options.reclaim` in the
+      {@link Disruptor|constructor}). The new position is published before
+      it's checked again, so producers can't overwrite the data between the
+      check and this consumer holding it, even without other consumers.
+      It's never moved forwards, so data it hasn't read yet isn't skipped,
+      except in `options.overwrite` mode when producers have already
+      overwritten it (the skipped elements are counted in
+      {@link Disruptor#dropped|dropped}). In that mode producers don't wait
+      for the consumer, so use {@link Disruptor#consumeCheck|consumeCheck}
+      after reading rewound data.
+
+      Any data returned by a previous call to {@link Disruptor#consumeNew|consumeNew} or
+      {@link Disruptor#consumeNewSync|consumeNewSync} is forgotten and won't be committed.
+
+      @param {integer} n - Maximum number of elements before the last committed element to move back to.
+      @returns {integer} - The Disruptor maintains a strictly increasing count of the total number of elements consumed since it was created. This is how many elements the consumer is now considered to have consumed. The next call to {@link Disruptor#consumeNew|consumeNew} or {@link Disruptor#consumeNewSync|consumeNewSync} will return data from here.
+     */
+    consumeRewind(n)
+    {
+    }
+
+    /**
+      Read data from the Disruptor at a given position, without consuming it.
+
+      @param {integer} seq - The Disruptor maintains a strictly increasing count of the total number of elements produced since it was created. This is the number of elements produced before the first element you want to read.
+      @param {integer} [n=1] - Number of elements to read.
+      @returns {Buffer[]} - Array of buffers containing the data. If any of the elements haven't been committed yet, may have been overwritten or have been reclaimed (see `options.reclaim` in the {@link Disruptor|constructor}), the array will be empty. Otherwise it will contain at least one buffer and each buffer will be a multiple of `element_size` in length. The buffers are backed by shared memory and, unless a consumer hasn't read the data yet, may be overwritten at any time. Check {@link Disruptor#readAt|readAt} again after reading the data if you need to be sure it wasn't overwritten.
+     */
+    readAt(seq, n)
+    {
+    }
+
+    /**
+      Check whether data returned by the previous call to {@link Disruptor#consumeNew|consumeNew} or
+      {@link Disruptor#consumeNewSync|consumeNewSync} has been overwritten since.
+
+      Producers only overwrite unread data if `options.overwrite` was specified (see the {@link Disruptor|constructor}).
+      Call this after you've read the data and before you act on it.
+
+      @returns {integer} - Number of elements which have been overwritten (or are being overwritten). If this is zero, the data you read is consistent.
+     */
+    consumeCheck()
+    {
+    }
+
     /**
       Reserve elements you've reserved before.
 
@@ -157,6 +293,281 @@ class Disruptor
     {
     }
 
+    /**
+      Get the details needed to make another object which uses this Disruptor.
+      You can pass the result to a worker thread (e.g. using `postMessage` or
+      `workerData`) and call {@link Disruptor.fromHandle|fromHandle} there.
+      If this object was constructed with `options.share`, the new object
+      doesn't need to map the shared memory again.
+
+      @returns {Object} - Details of the Disruptor.
+     */
+    handle()
+    {
+    }
+
+    /**
+      Make an object which uses the same Disruptor as the one a handle was
+      obtained from. `options.share` is always set on the new object.
+
+      @param {Object} handle - Value returned by {@link Disruptor#handle|handle}.
+      @param {integer} consumer - Unique ID of the new object's consumer (see the {@link Disruptor|constructor}).
+      @returns {Disruptor} - New object.
+     */
+    static fromHandle(handle, consumer)
+    {
+    }
+
+    /**
+      Remove the name of a shared memory object, so its memory is freed once
+      every object which has it open releases it. Objects using it carry on
+      working but no new ones can open it.
+
+      @param {string} shm_name - Name of the shared memory object.
+      @returns {boolean} - Whether the name was removed. `false` if it didn't exist.
+     */
+    static unlink(shm_name)
+    {
+    }
+
+    /**
+      Write a value to the Disruptor in one call, instead of calling
+      {@link Disruptor#produceClaimSync|produceClaimSync}, writing to the
+      buffer it returns and then calling {@link Disruptor#produceCommitSync|produceCommitSync}.
+
+      The value takes up as many elements as it needs (at least one). The
+      rest of the last element is filled with zeros.
+
+      @param {Buffer|TypedArray|ArrayBuffer|string} data - Value to write. Strings are written as UTF-8.
+      @returns {boolean} - Whether the value was written. If the Disruptor is full and `spin` (see the {@link Disruptor|constructor}) is `false`, or if every consumer has been released with `mark_ignore` (see {@link Disruptor#release|release}), this will be `false`. Check {@link Disruptor#allConsumersIgnoring|allConsumersIgnoring} to tell these apart. Throws an error if the value won't fit in the Disruptor, or if elements reserved by this object haven't been committed yet. Once elements have been reserved, this waits for other producers to commit elements reserved before them, regardless of `spin`. If `options.timeout` passes first, it throws an error and leaves the elements to be committed by {@link Disruptor#produceCommitSync|produceCommitSync}.
+     */
+    produceSync(data)
+    {
+    }
+
+    /**
+      Write many values to the Disruptor in one call. Like {@link Disruptor#produceSync|produceSync}, but the values are written to consecutive elements and made available to consumers together.
+
+      @param {Array<Buffer|TypedArray|ArrayBuffer|string>} data - Values to write. Each one starts in a new element.
+      @returns {boolean} - Whether the values were written. Either all of them are written or none of them are. Throws an error if they won't all fit in the Disruptor.
+     */
+    produceManySync(data)
+    {
+    }
+
+    /**
+      Read data from a file descriptor (such as a file, pipe or socket)
+      straight into the Disruptor. Free elements are reserved (as
+      {@link Disruptor#produceClaimAvailSync|produceClaimAvailSync} does),
+      a single read fills as many of them as it can and they're committed,
+      without copying the data anywhere else.
+
+      If the read ends part of the way through an element, more is read to
+      finish it if it's already available and, at the end of the file, the
+      rest of the element is filled with zeros. This never waits for data if
+      `fd` is non-blocking. Elements which weren't read into are given back.
+
+      Elements are only committed once they're filled. If an element is
+      left partly read (because `fd` has no more data yet), or elements
+      can't be given back because another producer has reserved elements
+      after them in the meantime, they stay reserved from
+      {@link Disruptor#prevClaimStart|prevClaimStart} to
+      {@link Disruptor#prevClaimEnd|prevClaimEnd}. Get them using
+      {@link Disruptor#produceRecover|produceRecover}, fill them (the first
+      already holds the last `bytes % element_size` bytes read) and commit
+      them using {@link Disruptor#produceCommitSync|produceCommitSync}.
+      Until you do, this throws an error. Use a single producer to avoid
+      the second case.
+
+      @param {integer} fd - File descriptor to read from.
+      @param {integer} [max] - Maximum number of elements to fill. If omitted or 0, up to `num_elements`.
+      @returns {integer} - Number of bytes read. 0 means the end of the file was reached. -1 means no bytes were read because the Disruptor is full (and `spin` is `false` or `options.timeout` passed), every consumer has been released with `mark_ignore` or `fd` is non-blocking and has no data. Throws an error if the read fails.
+     */
+    produceFromSync(fd, max)
+    {
+    }
+
+    /**
+      Write new data from the Disruptor straight to a file descriptor (such
+      as a file, pipe or socket), without copying it anywhere else. Elements
+      are read (as {@link Disruptor#consumeNewSync|consumeNewSync} does) and
+      those written are committed.
+
+      This never waits if `fd` is non-blocking. If the write ends part of
+      the way through an element, the elements written are committed and
+      the next call carries on from where this one stopped, without
+      writing the start of the element again. Elements which weren't
+      written are returned again by the next read. In `options.pool` mode
+      no other consumer will read them, so the next call writes them
+      before reading any more.
+
+      @param {integer} fd - File descriptor to write to.
+      @param {integer} [max] - Maximum number of elements to write. If omitted or 0, all new elements are written.
+      @returns {integer} - Number of bytes written. 0 if there was no new data or `fd` is non-blocking and can't be written to. Throws an error if the write fails.
+     */
+    consumeToSync(fd, max)
+    {
+    }
+
+    /**
+      Compress data and produce it as a single record, so the Disruptor can
+      hold more data when it compresses well.
+
+      The data is compressed using the [LZ4 block format](https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md) and stored after an 8 byte header, starting at the next free element and padded to a whole number of elements. Data which doesn't compress is stored as it is. Read records using {@link Disruptor#consumeDecompressSync|consumeDecompressSync}. Don't mix them with data produced by other methods.
+
+      @param {Buffer|TypedArray|ArrayBuffer|string} data - Data to compress.
+      @returns {boolean} - Whether the record was produced. `false` means the Disruptor is full (and `spin` is `false` or `options.timeout` passed) or every consumer has been released with `mark_ignore`. Throws an error if the record is larger than the Disruptor.
+     */
+    produceCompressSync(data)
+    {
+    }
+
+    /**
+      Read new records produced by {@link Disruptor#produceCompressSync|produceCompressSync} and decompress them.
+
+      The records are copied out so their elements are committed straight away. Records are never split: if `max`, `options.maxBatch` or `options.adaptive` would end the read part of the way through a record, the rest of it is read too. In `options.pool` mode, this means each worker gets whole records.
+
+      A corrupt record is counted in {@link Disruptor#corruptRecords|corruptRecords}. The records before it are returned and the rest of the elements read are skipped, since there's no way to tell where the next record starts.
+
+      @param {integer} [max] - Maximum number of elements to read, unless the first record is bigger. If omitted or 0, there's no limit (other than `options.maxBatch`).
+      @returns {Buffer[]} - Decompressed records. Empty if there are no new records.
+     */
+    consumeDecompressSync(max)
+    {
+    }
+
+    /**
+      Count, sum and find the minimum and maximum of a field over the
+      elements returned by the previous call to
+      {@link Disruptor#consumeNew|consumeNew},
+      {@link Disruptor#consumeNewSync|consumeNewSync} or
+      {@link Disruptor#consumeAggregateSync|consumeAggregateSync}, including
+      where they wrap around the end of the ring. This runs natively, using
+      vector instructions where the CPU has them.
+
+      @param {string|Object} field - Name of a column (see `options.columns` in the {@link Disruptor|constructor}), or:
+      @param {integer} [field.offset=0] - Byte offset of the field in each element.
+      @param {string} field.type - Type of the field, as for `options.columns`. Values are read in the machine's byte order.
+      @param {Object} [filter] - Only aggregate values which match:
+      @param {string} filter.op - `'eq'`, `'ne'`, `'lt'`, `'le'`, `'gt'` or `'ge'`.
+      @param {number|bigint} filter.value - Value to compare against. It must be representable in the field's type (and be a `BigInt` for 64-bit integers).
+      @returns {Object} - `elements` is the number of elements looked at, `count` is how many of them matched, `sum` is the total of the matching values (integers wrap around at 64 bits) and `min` and `max` are the smallest and largest of them (`null` if none matched). `sum`, `min` and `max` are `BigInt`s for 64-bit integer fields.
+     */
+    aggregate(field, filter)
+    {
+    }
+
+    /**
+      Reserve new elements for reading, like {@link Disruptor#consumeNewSync|consumeNewSync}, but aggregate a field over them (see {@link Disruptor#aggregate|aggregate}) instead of returning them. Buffers aren't made for the elements, which makes this cheaper for monitoring.
+
+      The elements are committed the next time you call a `consumeNew` method or {@link Disruptor#consumeCommit|consumeCommit}.
+
+      @param {string|Object} field - Field to aggregate, as for {@link Disruptor#aggregate|aggregate}.
+      @param {Object} [filter] - Only aggregate values which match, as for {@link Disruptor#aggregate|aggregate}.
+      @param {integer} [max] - Maximum number of elements to reserve. If omitted or 0, there's no limit (other than `options.maxBatch`).
+      @returns {Object} - As for {@link Disruptor#aggregate|aggregate}. `elements` is 0 if there was nothing new to read.
+     */
+    consumeAggregateSync(field, filter, max)
+    {
+    }
+
+    /**
+      Consume elements on a native thread instead of in JavaScript. The
+      thread repeatedly reserves new elements, passes them to a function
+      in a shared object and commits them.
+
+      The function must have C linkage and the signature
+      `int on_batch(const uint8_t *ptr, size_t len, uint64_t seq)`. `ptr` points to `len` bytes of elements starting with element `seq`. Elements which wrap around the end of the Disruptor are passed in a second call. Return 0 to carry on. Anything else stops the thread. The elements from the failed call are left to be read again, except in `options.pool` mode, where they're committed because other consumers can't see them.
+
+      Don't read from this object while a handler is attached: its methods which read or commit elements (such as {@link Disruptor#consumeNewSync|consumeNewSync}, {@link Disruptor#consumeCommit|consumeCommit} and {@link Disruptor#consumeWait|consumeWait}) throw an error until you call {@link Disruptor#detachHandler|detachHandler}.
+
+      @param {string} path - Path of the shared object, passed to `dlopen`.
+      @param {string} [symbol='on_batch'] - Name of the function to call.
+      @param {Object} [options] - Options:
+      @param {integer} [options.idle=100] - Time in microseconds to sleep when there are no new elements. 0 means yield the CPU and check again.
+     */
+    attachHandler(path, symbol, options)
+    {
+    }
+
+    /**
+      Stop the native handler started by {@link Disruptor#attachHandler|attachHandler}, waiting for the current call to it to return, and unload it. This also happens when you call {@link Disruptor#release|release}.
+
+      @returns {?Object} - Final {@link Disruptor#handlerStats|handlerStats}, or `null` if no handler was attached.
+     */
+    detachHandler()
+    {
+    }
+
+    /**
+      Reserve the right to replace this Disruptor with a new generation (see `options.resizable` in the {@link Disruptor|constructor}). Only one caller succeeds. It should then create the new generation and call {@link Disruptor#seal|seal}. {@link ResizableDisruptor} does this for you.
+
+      @param {integer} generation - Generation number of the replacement, used to name its shared memory.
+      @param {integer} num_elements - Number of elements in the replacement.
+      @returns {boolean} - Whether this caller won. `false` if another one already has.
+     */
+    setForward(generation, num_elements)
+    {
+    }
+
+    /**
+      Stop producers reserving elements in this Disruptor, after calling {@link Disruptor#setForward|setForward}. Reservations fail as if the Disruptor was full, so producers should then follow {@link Disruptor#forward|forward}. Elements already reserved can still be committed, and consumers stop waiting once they've all been committed.
+
+      @returns {integer} - Sequence number of the first element which wasn't reserved. This is the same as `forward.boundary`.
+     */
+    seal()
+    {
+    }
+
+    /**
+      Check elements against the checksums their producers stored (see `options.checksum` in the {@link Disruptor|constructor}). Consumers already do this when elements are returned, so use this to find out which elements didn't match, or to check them again.
+
+      @param {integer} [seq] - First element to check. If omitted, checks the elements returned by the previous call to {@link Disruptor#consumeNew|consumeNew} or {@link Disruptor#consumeNewSync|consumeNewSync}.
+      @param {integer} [n=1] - Number of elements to check. Throws an error if they haven't all been committed or some have since been reused or reclaimed.
+      @returns {integer} - Number of elements whose data doesn't match their checksum.
+     */
+    verifyChecksums(seq, n)
+    {
+    }
+
+    /**
+      Get told when the Disruptor is filling up, so you can stop producing
+      data (or throw some away) before producers have to wait.
+
+      {@link Disruptor#fill|fill} is checked periodically. `cb` is called with
+      `true` when it reaches `options.high` and then with `false` when it
+      drops back to `options.low`.
+
+      Calling this again replaces the previous settings. Call it without
+      `cb` to stop checking. Checking also stops when you call
+      {@link Disruptor#release|release}.
+
+      @param {Object} [options] - Options:
+      @param {integer} options.high - Fill level at which to call `cb` with `true`.
+      @param {integer} [options.low=0] - Fill level at which to call `cb` with `false`.
+      @param {integer} [options.interval=10] - How often to check the fill level, in milliseconds. The timer doesn't keep your application running.
+      @param {watermarksCallback} [cb] - Called when the fill level crosses `options.high` or `options.low`.
+     */
+    watermarks(options, cb)
+    {
+    }
+
+    /**
+      Get views of each column (see `options.columns` in the
+      {@link Disruptor|constructor}) over a range of elements, for example
+      ones you've just read or reserved.
+
+      Elements wrap around the end of the columns, so each field may need two
+      views.
+
+      @param {integer} start - Element to start at, for example {@link Disruptor#prevConsumeStart|prevConsumeStart} or {@link Disruptor#prevClaimStart|prevClaimStart}.
+      @param {integer} n - Number of elements, for example the number of buffers returned by {@link Disruptor#consumeNewSync|consumeNewSync}.
+      @returns {Object} - Maps each field's name to an array of one or two typed arrays holding its values for the elements, in order.
+     */
+    columnsAt(start, n)
+    {
+    }
+
     /**
       Detaches from the shared memory backing the Disruptor.
 
@@ -185,6 +596,13 @@ class Disruptor
     {
     }
 
+    /**
+      @returns {boolean} - Whether every consumer was ignored (see `mark_ignore` in {@link Disruptor#release|release}) when elements were last reserved, including by {@link Disruptor#produceSync|produceSync} and {@link Disruptor#produceManySync|produceManySync}.
+     */
+    get allConsumersIgnoring()
+    {
+    }
+
     /**
       @returns {integer} - The Disruptor maintains a strictly increasing count of the total number of elements consumed since it was created. This is the how many elements were consumed _before_ the previous call to {@link Disruptor#consumeNew|consumeNew} or {@link Disruptor#consumeNewSync|consumeNewSync}.
      */
@@ -192,6 +610,90 @@ class Disruptor
     {
     }
 
+    /**
+      @returns {integer} - Total number of elements this object's consumer has skipped because producers overwrote them before they were read. This is only non-zero if `options.overwrite` was specified (see the {@link Disruptor|constructor}).
+     */
+    get dropped()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of elements produced which this object's consumer hasn't committed yet.
+     */
+    get lag()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of elements reserved by producers which the slowest consumer hasn't committed yet, up to `num_elements`. Producers have to wait when this reaches `num_elements` (unless `options.overwrite` was specified). Consumers released with `mark_ignore` aren't counted. See also {@link Disruptor#watermarks|watermarks}.
+     */
+    get fill()
+    {
+    }
+
+    /**
+      @returns {integer} - Longest time in microseconds methods on this object wait when `spin` is `true` (see `options.timeout` in the {@link Disruptor|constructor}). You can change this between calls. Asynchronous calls already waiting aren't affected.
+     */
+    get timeout()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of elements returned to this object's consumer whose data didn't match their checksum (see `options.checksum` in the {@link Disruptor|constructor}). The elements are still returned.
+     */
+    get checksumErrors()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of corrupt records {@link Disruptor#consumeDecompressSync|consumeDecompressSync} has skipped on this object.
+     */
+    get corruptRecords()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of bytes of free elements this object has given back to the operating system (see `options.reclaim` in the {@link Disruptor|constructor}). Only whole pages are given back.
+     */
+    get reclaimed()
+    {
+    }
+
+    /**
+      @returns {?Object} - `null` if no native handler is attached (see {@link Disruptor#attachHandler|attachHandler}). Otherwise `running` is whether its thread is still going, `batches` and `elements` count what it's committed and `result` is the non-zero value it returned if it stopped.
+     */
+    get handlerStats()
+    {
+    }
+
+    /**
+      @returns {?Object} - `null` unless the Disruptor has been sealed (see {@link Disruptor#seal|seal}). Otherwise `generation` and `numElements` describe the new generation and `boundary` is the sequence number of the first element which wasn't reserved. Once the {@link Disruptor#cursor|cursor} reaches `boundary` and this object's consumer has read everything, it can move to the new generation.
+     */
+    get forward()
+    {
+    }
+
+    /**
+      @returns {boolean} - Whether the Disruptor has been sealed (see {@link Disruptor#seal|seal}), all its elements have been committed and every consumer has read them (or is ignored). Nobody needs it any more, so its shared memory can be removed with {@link Disruptor.unlink|unlink}.
+     */
+    get drained()
+    {
+    }
+
+    /**
+      @returns {Object} - Maps each field's name in `options.columns` (see the {@link Disruptor|constructor}) to a typed array over its whole column. Element `seq` is at index `seq % num_elements`. Empty if there are no columns.
+     */
+    get columns()
+    {
+    }
+
+    /**
+      @returns {number} - Maximum number of elements the next call to {@link Disruptor#consumeNew|consumeNew} or {@link Disruptor#consumeNewSync|consumeNewSync} will return, given `options.maxBatch` and, if `options.adaptive` is `true`, the time taken to process previous elements (see the {@link Disruptor|constructor}). `Infinity` if there's no limit.
+     */
+    get batchLimit()
+    {
+    }
+
     /**
       @returns {integer} - Size of each element in the Disruptor in bytes.
      */
@@ -205,6 +707,50 @@ class Disruptor
     get spin()
     {
     }
+
+    /**
+      Direct access to the Disruptor's sequence numbers, so JavaScript code
+      can read (or write) data without calling into the native code for
+      every batch.
+
+      Use `Atomics.load` and `Atomics.store` to access the values. These are
+      sequentially consistent, like the native code's accesses. The array
+      isn't backed by a `SharedArrayBuffer` (Node can't make one over shared
+      memory), so `Atomics.wait` and `Atomics.notify` can't be used; poll
+      instead (e.g. on `setImmediate`).
+
+      Each element with sequence number `seq` is stored at byte offset
+      `(seq % num_elements) * element_size` in {@link Disruptor#elements|elements}.
+
+      To consume as consumer `c`: wait until `Atomics.load(sequences, num_consumers)`
+      (the cursor) is greater than `Atomics.load(sequences, c)`. Elements
+      between the two (including the consumer's value but not the cursor)
+      are ready to read. Once you've read them, `Atomics.store` the cursor
+      value you read into `sequences[c]`.
+
+      To produce: `Atomics.compareExchange` `sequences[num_consumers + 1]`
+      (next) from its current value `n` to `n + count`, retrying if it
+      changed. Wait until `n + count` is no more than `num_elements` greater than
+      every consumer's value (consumers set to `2n ** 64n - 1n` are ignored).
+      Write the elements, wait until the cursor equals `n` and then
+      `Atomics.store` `n + count` into the cursor.
+
+      Don't mix this with {@link Disruptor#consumeNew|consumeNew} (or similar)
+      on the same object between commits. Not supported if `options.overwrite`
+      was specified (see the {@link Disruptor|constructor}).
+
+      @returns {BigUint64Array} - One value for each consumer, followed by the cursor (next element to be committed) and next (next element to be claimed).
+     */
+    get sequences()
+    {
+    }
+
+    /**
+      @returns {Buffer} - The Disruptor's elements, backed by shared memory.
+     */
+    get elements()
+    {
+    }
 }
 
 /**
@@ -252,6 +798,584 @@ function consumeNewCallback(err, bufs, start)
 {
 }
 
+/**
+  Callback type for fill level changes.
+
+  @param {boolean} high - `true` if the fill level has reached `options.high` and `false` if it has dropped back to `options.low` (see {@link Disruptor#watermarks|watermarks}).
+  @param {integer} fill - The fill level (see {@link Disruptor#fill|fill}).
+ */
+function watermarksCallback(high, fill)
+{
+}
+
+/**
+  Creates an object which stores the latest value for each of a fixed number
+  of keys in shared memory. Use it alongside a {@link Disruptor} so new
+  processes can get the current state without replaying the Disruptor.
+
+  Each value has a version number which is incremented when the value is
+  written. Readers retry until they get a copy of a value which wasn't
+  changed while they were reading it, so writers never wait for readers.
+
+  Each key must have only one writer at a time. Writers don't wait for each
+  other, so a writer which dies part way through doesn't hold anyone up:
+  the next write to the key just replaces the value.
+
+  @param {string} shm_name - Name of shared memory object to use (see {@link http://pubs.opengroup.org/onlinepubs/009695399/functions/shm_open.html|shm_open}).
+  @param {integer} num_keys - Number of keys in the table. Keys are numbers between 0 and `num_keys - 1`.
+  @param {integer} value_size - Size of each value in bytes.
+  @param {boolean} init - Whether to create and initialize the shared memory backing the table. You should arrange your application so this is done once, at the start.
+  @param {Object} [options] - Options:
+  @param {integer} [options.retries=1000] - Most times {@link SnapshotTable#read|read} tries again to get a consistent copy of a value which is being written. This stops a writer which died part way through from hanging readers. 0 means retry forever.
+ */
+class SnapshotTable
+{
+    constructor(shm_name, num_keys, value_size, init, options)
+    {
+    }
+
+    /**
+      Replace the value for a key.
+
+      @param {integer} key - Key to write.
+      @param {Buffer} data - New value. If it's shorter than `value_size`, the rest of the value is filled with zeros. If it's longer, only the first `value_size` bytes are written.
+      @returns {integer} - New version of the value.
+     */
+    write(key, data)
+    {
+    }
+
+    /**
+      Read the value for a key.
+
+      @param {integer} key - Key to read.
+      @param {integer} [retries=options.retries] - Most times to try again if the value is being written (see the {@link SnapshotTable|constructor}).
+      @returns {?Buffer|undefined} - Copy of the value, `value_size` bytes long, or `null` if it's never been written. `undefined` if a consistent copy couldn't be made within `retries` tries, for example because its writer died part way through. Call again later or after the key has been written.
+     */
+    read(key, retries)
+    {
+    }
+
+    /**
+      Get the version of the value for a key.
+
+      @param {integer} key - Key to check.
+      @returns {integer} - Version of the value. This is 0 if the value has never been written and odd while it's being written.
+     */
+    version(key)
+    {
+    }
+
+    /**
+      Detaches from the shared memory backing the table.
+
+      Although this will be called when the object is garbage collected,
+      you can force the shared memory to be unmapped by calling this function.
+
+      Don't use the object again afterwards!
+     */
+    release()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of keys in the table.
+     */
+    get numKeys()
+    {
+    }
+
+    /**
+      @returns {integer} - Size of each value in bytes.
+     */
+    get valueSize()
+    {
+    }
+}
+
+/**
+  Creates an object which waits for new data on many {@link Disruptor}s at
+  once. Instead of each Disruptor polling for new data separately, one
+  background check looks at all of them, so waiting on lots of mostly-idle
+  Disruptors doesn't use lots of threads.
+
+  Each Disruptor is read using its own consumer, exactly as
+  {@link Disruptor#consumeNew|consumeNew} would. Their `spin` settings are
+  ignored.
+
+  By default, every Disruptor with new data is returned, starting with a
+  different one each time. To stop busy Disruptors starving the others, give
+  them a `max` when you {@link Selector#add|add} them and set `limit` here.
+
+  @param {Object} [options] - Options:
+  @param {string} [options.policy='round-robin'] - How to choose which Disruptors to return when some have new data. `'round-robin'` takes turns, giving each Disruptor `weight` turns in a row at being first (see {@link Selector#add|add}). `'priority'` only returns Disruptors with the highest `priority` of those which have new data, so lower priority Disruptors are read only while higher priority ones are idle.
+  @param {integer} [options.limit=0] - Maximum number of Disruptors to return from each select. 0 means no limit.
+  @param {integer} [options.idle=1000] - Longest time in microseconds to sleep between checks while {@link Selector#select|select} is waiting. The background check starts at 1 microsecond and backs off to this while there's no new data. 0 means yield the CPU and check again.
+ */
+class Selector
+{
+    constructor(options)
+    {
+    }
+
+    /**
+      Start waiting on a Disruptor. Adding the same Disruptor again has no
+      effect.
+
+      @param {Disruptor} disruptor - Disruptor to add. Throws an error if it has a native handler attached (see {@link Disruptor#attachHandler|attachHandler}), and selects throw if one is attached later. Released Disruptors are skipped. If they've all been released, {@link Selector#select|select} stops waiting and returns no results.
+      @param {Object} [options] - Options:
+      @param {integer} [options.max=0] - Maximum number of elements to return from the Disruptor in each select. 0 means no limit.
+      @param {integer} [options.weight=1] - Number of turns in a row the Disruptor gets at being first when `policy` is `'round-robin'`.
+      @param {integer} [options.priority=0] - Priority of the Disruptor when `policy` is `'priority'`. Higher numbers go first. Disruptors with the same priority are returned in the order they were added.
+     */
+    add(disruptor, options)
+    {
+    }
+
+    /**
+      Stop waiting on a Disruptor.
+
+      @param {Disruptor} disruptor - Disruptor to remove.
+     */
+    remove(disruptor)
+    {
+    }
+
+    /**
+      Commits the data consumed by the last call to {@link Selector#select|select} or {@link Selector#selectSync|selectSync} on every Disruptor in the Selector and then waits until at least one of them has new data.
+
+      @param {selectCallback} [cb] - Called with the new data. If you don't pass a callback, a `Promise` is returned which resolves to the array of results.
+      @returns {Promise|undefined} - If no callback is passed, a `Promise` which resolves to the results.
+     */
+    select(cb)
+    {
+    }
+
+    /**
+      Commits the data consumed by the last call to {@link Selector#select|select} or {@link Selector#selectSync|selectSync} on every Disruptor in the Selector and then returns new data without waiting.
+
+      @returns {SelectResult[]} - One entry for each Disruptor chosen to return new data. Empty if none have any.
+     */
+    selectSync()
+    {
+    }
+
+    /**
+      Stop a {@link Selector#select|select} which is waiting. It returns no results.
+     */
+    cancel()
+    {
+    }
+}
+
+/**
+  @typedef {Object} SelectResult
+  @property {Disruptor} disruptor - Disruptor the data came from.
+  @property {Buffer[]} bufs - New data, as returned by {@link Disruptor#consumeNew|consumeNew}.
+  @property {integer} start - Number of elements consumed from the Disruptor before `bufs`.
+ */
+
+/**
+  Callback type for waiting on many Disruptors.
+
+  @param {?Error} err - Error, if one occurred.
+  @param {SelectResult[]} results - One entry for each Disruptor chosen to return new data. Contains at least one entry unless the Selector has no Disruptors.
+ */
+function selectCallback(err, results)
+{
+}
+
+/**
+  Creates an object which spreads data over a number of {@link Disruptor}s
+  (partitions) instead of one. Producers write each value to a partition
+  chosen from a key, so values with the same key are read in the order they
+  were written, while producers writing different keys mostly use different
+  Disruptors and don't contend with each other.
+
+  Partition `i` is a separate Disruptor on the shared memory object
+  `` `${shm_prefix}.${i}` `` and every partition has `num_consumers`
+  consumers. Typically, each consumer reads only some of the partitions
+  (see `options.partitions`), so you can give each partition to a different
+  worker by having `num_consumers` be 1 and passing each worker different
+  partitions.
+
+  @param {string} shm_prefix - Start of the name of each partition's shared memory object.
+  @param {integer} num_partitions - Number of partitions.
+  @param {integer} num_elements - Number of elements in each partition.
+  @param {integer} element_size - Size of each element in bytes.
+  @param {integer} num_consumers - Number of consumers for each partition.
+  @param {integer} consumer - Unique ID of this object's consumer in each partition it reads.
+  @param {boolean} init - Whether to create and initialize the partitions.
+  @param {boolean} spin - Passed to each partition's {@link Disruptor|constructor}.
+  @param {Object} [options] - Passed to each partition's {@link Disruptor|constructor}, as well as:
+  @param {integer[]} [options.partitions] - Indexes of the partitions this object reads. Defaults to all of them. This can differ between objects.
+ */
+class PartitionedDisruptor
+{
+    constructor(shm_prefix, num_partitions, num_elements, element_size, num_consumers, consumer, init, spin, options)
+    {
+    }
+
+    /**
+      @returns {Disruptor[]} - The partitions, in order.
+     */
+    get disruptors()
+    {
+    }
+
+    /**
+      @returns {integer[]} - Indexes of the partitions this object reads.
+     */
+    get partitions()
+    {
+    }
+
+    /**
+      Get the partition for a key. Non-negative integers are taken modulo the
+      number of partitions. Strings (as UTF-8) and Buffers are hashed.
+
+      @param {integer|string|Buffer} key - Key to look up.
+      @returns {integer} - Index of the partition.
+     */
+    partition(key)
+    {
+    }
+
+    /**
+      Get the Disruptor for a key. Use this to call any of the
+      {@link Disruptor} methods which write data.
+
+      @param {integer|string|Buffer} key - Key to look up (see {@link PartitionedDisruptor#partition|partition}).
+      @returns {Disruptor} - Partition for the key.
+     */
+    disruptor(key)
+    {
+    }
+
+    /**
+      Write a value to the partition for a key (see {@link Disruptor#produceSync|produceSync}).
+
+      @param {integer|string|Buffer} key - Key to look up (see {@link PartitionedDisruptor#partition|partition}).
+      @param {Buffer|TypedArray|ArrayBuffer|string} data - Value to write.
+      @returns {boolean} - Whether the value was written.
+     */
+    produceSync(key, data)
+    {
+    }
+
+    /**
+      Write many values to the partition for a key (see {@link Disruptor#produceManySync|produceManySync}).
+
+      @param {integer|string|Buffer} key - Key to look up (see {@link PartitionedDisruptor#partition|partition}).
+      @param {Array<Buffer|TypedArray|ArrayBuffer|string>} data - Values to write.
+      @returns {boolean} - Whether the values were written.
+     */
+    produceManySync(key, data)
+    {
+    }
+
+    /**
+      Commits the data returned by the last read and waits until at least one
+      of the partitions this object reads has new data. This uses a
+      {@link Selector} (see {@link Selector#select|select}).
+
+      @param {selectCallback} [cb] - Called with the new data. If you don't pass a callback, a `Promise` is returned which resolves to the array of results.
+      @returns {Promise|undefined} - If no callback is passed, a `Promise` which resolves to the results.
+     */
+    consumeNew(cb)
+    {
+    }
+
+    /**
+      Commits the data returned by the last read and returns new data from
+      the partitions this object reads without waiting
+      (see {@link Selector#selectSync|selectSync}).
+
+      @returns {SelectResult[]} - One entry for each partition with new data. Empty if none have any.
+     */
+    consumeNewSync()
+    {
+    }
+
+    /**
+      Commits the data returned by the last read from each partition this
+      object reads (see {@link Disruptor#consumeCommit|consumeCommit}).
+
+      @return {boolean} - Whether every partition was in the expected state.
+     */
+    consumeCommit()
+    {
+    }
+
+    /**
+      Detaches from the shared memory backing each partition.
+
+      @param {boolean} [mark_ignore=false] - Whether publishers should ignore this object's consumer in the partitions it reads.
+     */
+    release(mark_ignore)
+    {
+    }
+}
+
+/**
+  Creates an object which writes to and reads from a {@link Disruptor}
+  which can be resized while in use.
+
+  Each resize creates a new generation, a separate Disruptor whose shared
+  memory is named `shm_name` followed by `.` and the generation number
+  (generation 0 is just `shm_name`). The old generation is sealed so
+  producers move to the new one, while consumers read everything left in
+  the old generation before they move. Values are neither lost nor
+  reordered. Each object keeps its consumer ID in every generation.
+
+  Once every consumer has read all of a generation, the object which
+  resizes it or the last consumer to move on removes its name (see
+  {@link Disruptor.unlink|unlink}). Its memory is freed when every object
+  still using it has moved on and released it. Generation 0 is removed too,
+  so objects created after that must open the current generation by passing
+  `options.generation` (for example another object's
+  {@link ResizableDisruptor#producerGeneration|producerGeneration}). A
+  consumer which hasn't read a generation holds it open, so only producers
+  and consumers which were released with `mark_ignore` need to do this.
+
+  Only the methods below follow resizes. If you use other methods (such as
+  {@link Disruptor#produceClaimSync|produceClaimSync}) on
+  {@link ResizableDisruptor#producer|producer} or
+  {@link ResizableDisruptor#consumer|consumer} directly, they fail as if the
+  generation is full or empty once it's been resized, and you need to get
+  `producer` or `consumer` again and retry. Commit claims on the generation
+  you made them on.
+
+  @param {string} shm_name - Name of the first generation's shared memory object.
+  @param {integer} num_elements - Number of elements in the first generation.
+  @param {integer} element_size - Size of each element in bytes.
+  @param {integer} num_consumers - Number of consumers in each generation.
+  @param {integer} consumer - Unique ID of this object's consumer.
+  @param {boolean} init - Whether to create and initialize the first generation.
+  @param {boolean} spin - Passed to each generation's {@link Disruptor|constructor}.
+  @param {Object} [options] - Passed to each generation's {@link Disruptor|constructor}, with `options.resizable` set.
+  @param {integer} [options.generation=0] - Generation to open first. Later generations are followed as usual.
+ */
+class ResizableDisruptor
+{
+    constructor(shm_name, num_elements, element_size, num_consumers, consumer, init, spin, options)
+    {
+    }
+
+    /**
+      @returns {Disruptor} - Generation this object is writing to.
+     */
+    get producer()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of the generation this object is writing to.
+     */
+    get producerGeneration()
+    {
+    }
+
+    /**
+      @returns {Disruptor} - Generation this object is reading from. This lags behind {@link ResizableDisruptor#producer|producer} while there's still data to read in an older generation.
+     */
+    get consumer()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of the generation this object is reading from.
+     */
+    get consumerGeneration()
+    {
+    }
+
+    /**
+      Replace the newest generation with one which has a different number of
+      elements. Producers using the old generation move to the new one the
+      next time they find it full.
+
+      @param {integer} num_elements - Number of elements in the new generation.
+      @returns {boolean} - Whether this call created the new generation. `false` if another object was resizing at the same time.
+     */
+    resize(num_elements)
+    {
+    }
+
+    /**
+      Write a value (see {@link Disruptor#produceSync|produceSync}), moving
+      to a newer generation first if the current one has been resized.
+
+      @param {Buffer|TypedArray|ArrayBuffer|string} data - Value to write.
+      @returns {boolean} - Whether the value was written.
+     */
+    produceSync(data)
+    {
+    }
+
+    /**
+      Write many values (see {@link Disruptor#produceManySync|produceManySync}),
+      moving to a newer generation first if the current one has been resized.
+
+      @param {Array<Buffer|TypedArray|ArrayBuffer|string>} data - Values to write.
+      @returns {boolean} - Whether the values were written.
+     */
+    produceManySync(data)
+    {
+    }
+
+    /**
+      Read data from a file descriptor (see {@link Disruptor#produceFromSync|produceFromSync}),
+      moving to a newer generation first if the current one has been resized.
+
+      @param {integer} fd - File descriptor to read from.
+      @param {integer} [max] - Maximum number of elements to fill.
+      @returns {integer} - Number of bytes read, 0 at the end of the file or -1 if nothing could be read.
+     */
+    produceFromSync(fd, max)
+    {
+    }
+
+    /**
+      Compress and write a record (see {@link Disruptor#produceCompressSync|produceCompressSync}),
+      moving to a newer generation first if the current one has been resized.
+
+      @param {Buffer|TypedArray|ArrayBuffer|string} data - Data to compress.
+      @returns {boolean} - Whether the record was written.
+     */
+    produceCompressSync(data)
+    {
+    }
+
+    /**
+      Commits the data returned by the last read and reads new data
+      (see {@link Disruptor#consumeNew|consumeNew}). Once a resized generation
+      has been read to its end, moves on to the next one.
+
+      @returns {Promise} - Resolves to an object with `bufs` and `start` properties.
+     */
+    consumeNew()
+    {
+    }
+
+    /**
+      Commits the data returned by the last read and reads new data
+      (see {@link Disruptor#consumeNewSync|consumeNewSync}). Once a resized
+      generation has been read to its end, moves on to the next one.
+
+      @param {integer} [max] - Maximum number of elements to return.
+      @returns {Buffer[]} - New data, in one or two buffers.
+     */
+    consumeNewSync(max)
+    {
+    }
+
+    /**
+      Write new data to a file descriptor (see {@link Disruptor#consumeToSync|consumeToSync}).
+      Once a resized generation has been read to its end, moves on to the next one.
+
+      @param {integer} fd - File descriptor to write to.
+      @param {integer} [max] - Maximum number of elements to write.
+      @returns {integer} - Number of bytes written.
+     */
+    consumeToSync(fd, max)
+    {
+    }
+
+    /**
+      Read and decompress new records (see {@link Disruptor#consumeDecompressSync|consumeDecompressSync}).
+      Once a resized generation has been read to its end, moves on to the next one.
+
+      @param {integer} [max] - Maximum number of elements to read.
+      @returns {Buffer[]} - Decompressed records.
+     */
+    consumeDecompressSync(max)
+    {
+    }
+
+    /**
+      Commits the data returned by the last read (see {@link Disruptor#consumeCommit|consumeCommit}).
+
+      @return {boolean} - Whether the generation was in the expected state.
+     */
+    consumeCommit()
+    {
+    }
+
+    /**
+      Detaches from the shared memory of the generations this object is using.
+
+      @param {boolean} [mark_ignore=false] - Whether publishers should ignore this object's consumer in the generation it's reading.
+     */
+    release(mark_ignore)
+    {
+    }
+}
+
+/**
+  Creates an object which gathers small values in a local buffer and
+  writes them to a {@link Disruptor} together, so lots of tiny values
+  cost one reservation and one commit between them rather than one each.
+
+  Values are written (see {@link Disruptor#produceSync|produceSync}) when
+  the buffer fills up, when the first value in it has waited for
+  `options.maxDelay` or when you call {@link Coalescer#flush|flush}.
+  Each value starts in a new element, exactly as if it had been written on
+  its own.
+
+  The timer doesn't keep the process alive, so call
+  {@link Coalescer#close|close} before exiting to write any values left in
+  the buffer.
+
+  @param {Disruptor} disruptor - Disruptor to write to. If its `spin` is `true`, writes wait while it's full.
+  @param {Object} [options] - Options:
+  @param {integer} [options.maxElements=64] - Size of the buffer in elements. This must be no more than the number of elements in the Disruptor.
+  @param {integer} [options.maxDelay=100] - Longest time in microseconds a value should wait in the buffer. It's checked each time a value is added; a timer also writes the buffer if no more values are added, but it can't fire sooner than 1 millisecond.
+ */
+class Coalescer
+{
+    constructor(disruptor, options)
+    {
+    }
+
+    /**
+      Add a value to the buffer, writing the buffer to the Disruptor first
+      if the value doesn't fit.
+
+      @param {Buffer|TypedArray|ArrayBuffer|string} data - Value to write. Strings are written as UTF-8. Values bigger than the buffer are written to the Disruptor directly.
+      @returns {boolean} - `false` if the buffer needed to be written but the Disruptor was full, in which case `data` wasn't added. Otherwise `true`. Throws an error if {@link Coalescer#close|close} has been called.
+     */
+    write(data)
+    {
+    }
+
+    /**
+      Write the values in the buffer to the Disruptor now.
+
+      @returns {boolean} - `false` if the Disruptor was full, in which case the values stay in the buffer. Otherwise `true`.
+     */
+    flush()
+    {
+    }
+
+    /**
+      Write the values in the buffer to the Disruptor and stop the timer.
+      {@link Coalescer#write|write} throws an error afterwards.
+
+      @returns {boolean} - `false` if the Disruptor was full, in which case the values stay in the buffer and you can call {@link Coalescer#flush|flush} to try again. Otherwise `true`.
+     */
+    close()
+    {
+    }
+
+    /**
+      @returns {integer} - Number of elements waiting in the buffer.
+     */
+    get pending()
+    {
+    }
+}
+
 const stream = require('stream');
 
 /**
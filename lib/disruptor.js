@@ -1,6 +1,10 @@
 const { promisify } = require('util');
 const { Readable, Writable } = require('stream');
-const Disruptor = require('bindings')('disruptor.node').Disruptor;
+const {
+    Disruptor,
+    SnapshotTable,
+    Selector
+} = require('bindings')('disruptor.node');
 
 const status_eof = 1;
 const status_error = 2;
@@ -19,36 +23,146 @@ class Disruptor2 extends Disruptor
     {
         super(...args);
 
-        this._consumeNewAsync = promisify(cb => {
-            this._consumeNew((err, bufs, start) => {
-                cb(err, { bufs, start });
-            });
-        });
+        this._args = args;
+    }
 
-        this._produceClaimAsync = promisify(cb => {
-            this._produceClaim((err, buf, claimStart, claimEnd, allConsumersIgnoring) => {
-                cb(err, { buf, claimStart, claimEnd, allConsumersIgnoring });
-            });
-        });
+    handle()
+    {
+        const [shm_name, num_elements, element_size, num_consumers, , , spin, options] = this._args;
+        return {
+            shm_name,
+            num_elements,
+            element_size,
+            num_consumers,
+            spin,
+            options: Object.assign({}, options, { share: true })
+        };
+    }
 
-        this._produceClaimManyAsync = promisify((n, cb) => {
-            this._produceClaimMany(n, (err, bufs, claimStart, claimEnd, allConsumersIgnoring) => {
-                cb(err, { bufs, claimStart, claimEnd, allConsumersIgnoring });
-            });
-        });
+    static fromHandle(handle, consumer)
+    {
+        return new Disruptor2(handle.shm_name,
+                              handle.num_elements,
+                              handle.element_size,
+                              handle.num_consumers,
+                              consumer,
+                              false,
+                              handle.spin,
+                              handle.options);
+    }
 
-        this._produceClaimAvailAsync = promisify((max, cb) => {
-            this._produceClaimAvail(max, (err, bufs, claimStart, claimEnd, allConsumersIgnoring) => {
-                cb(err, { bufs, claimStart, claimEnd, allConsumersIgnoring });
-            });
-        });
+    columnsAt(start, n)
+    {
+        const num_elements = this._args[1];
+        const index = start % num_elements;
+        const first = Math.min(n, num_elements - index);
+        const r = {};
+        for (const [name, column] of Object.entries(this.columns))
+        {
+            // Slots wrap around the end of the ring
+            r[name] = [column.subarray(index, index + first)];
+            if (first < n)
+            {
+                r[name].push(column.subarray(0, n - first));
+            }
+        }
+        return r;
+    }
 
-        this._produceCommitAsync = promisify(function (claimStart, claimEnd, cb) {
-            if (arguments.length >= 2) {
-                return this._produceCommit(claimStart, claimEnd, cb);
+    watermarks(options, cb)
+    {
+        if (this._watermarks_timer)
+        {
+            clearInterval(this._watermarks_timer);
+            this._watermarks_timer = null;
+        }
+
+        if (!cb)
+        {
+            return;
+        }
+
+        const { high, low, interval } = Object.assign({
+            low: 0,
+            interval: 10
+        }, options);
+
+        let above = false;
+
+        this._watermarks_timer = setInterval(() => {
+            const fill = this.fill;
+            if (!above && (fill >= high))
+            {
+                above = true;
+                cb(true, fill);
             }
-            this._produceCommit(claimStart);
-        });
+            else if (above && (fill <= low))
+            {
+                above = false;
+                cb(false, fill);
+            }
+        }, interval);
+
+        this._watermarks_timer.unref();
+    }
+
+    release(...args)
+    {
+        this.watermarks();
+        super.release(...args);
+    }
+
+    async *batches(max)
+    {
+        let stopped = false;
+        let failed = false;
+        try
+        {
+            // Waits on the thread pool (and for options.minBatch)
+            let wait = this.consumeWait();
+            while (await wait)
+            {
+                // Commits the previous batch
+                const bufs = this.consumeNewSync(max, false);
+                if (bufs.length === 0)
+                {
+                    // Another worker got there first (pool mode)
+                    wait = this.consumeWait();
+                    continue;
+                }
+                const start = this.prevConsumeStart;
+                // Wait for the next batch while this one is processed
+                wait = this.consumeWait();
+                try
+                {
+                    yield { bufs, start };
+                }
+                catch (ex)
+                {
+                    // Don't commit a batch which wasn't processed
+                    failed = true;
+                    throw ex;
+                }
+            }
+            // Released
+            stopped = true;
+        }
+        finally
+        {
+            if (!stopped)
+            {
+                this.consumeWaitCancel();
+                if (!failed)
+                {
+                    this.consumeCommit();
+                }
+            }
+        }
+    }
+
+    [Symbol.asyncIterator]()
+    {
+        return this.batches();
     }
 
     _consumeNew(cb)
@@ -65,7 +179,8 @@ class Disruptor2 extends Disruptor
             return this._consumeNew(cb);
         }
 
-        return this._consumeNewAsync();
+        // Native method returns a Promise if there's no callback
+        return super.consumeNew();
     }
 
     _produceClaim(cb)
@@ -84,7 +199,7 @@ class Disruptor2 extends Disruptor
             return this._produceClaim(cb);
         }
 
-        return this._produceClaimAsync();
+        return super.produceClaim();
     }
 
     _produceClaimMany(n, cb)
@@ -103,7 +218,7 @@ class Disruptor2 extends Disruptor
             return this._produceClaimMany(n, cb);
         }
 
-        return this._produceClaimManyAsync(n);
+        return super.produceClaimMany(n);
     }
 
     _produceClaimAvail(max, cb)
@@ -122,7 +237,7 @@ class Disruptor2 extends Disruptor
             return this._produceClaimAvail(max, cb);
         }
 
-        return this._produceClaimAvailAsync(max);
+        return super.produceClaimAvail(max);
     }
 
     _produceCommit(claimStart, claimEnd, cb)
@@ -144,7 +259,7 @@ class Disruptor2 extends Disruptor
                 return this._produceCommit(claimStart, claimEnd, cb);
             }
 
-            return this._produceCommitAsync(claimStart, claimEnd);
+            return super.produceCommit(claimStart, claimEnd);
         }
 
         if (claimStart)
@@ -152,7 +267,520 @@ class Disruptor2 extends Disruptor
             return this._produceCommit(claimStart);
         }
 
-        return this._produceCommitAsync();
+        return super.produceCommit();
+    }
+}
+
+class Selector2 extends Selector
+{
+    constructor(...args)
+    {
+        super(...args);
+
+        this._selectAsync = promisify(cb => this._select(cb));
+    }
+
+    _select(cb)
+    {
+        check(cb, super.select(cb));
+    }
+
+    select(cb)
+    {
+        if (cb)
+        {
+            return this._select(cb);
+        }
+
+        return this._selectAsync();
+    }
+}
+
+class PartitionedDisruptor
+{
+    constructor(shm_prefix, num_partitions, num_elements, element_size,
+                num_consumers, consumer, init, spin, options)
+    {
+        options = Object.assign({}, options);
+        let partitions = options.partitions;
+        delete options.partitions;
+
+        if (partitions === undefined)
+        {
+            partitions = Array.from({ length: num_partitions }, (_, i) => i);
+        }
+
+        for (const i of partitions)
+        {
+            if (!(Number.isInteger(i) && (i >= 0) && (i < num_partitions)))
+            {
+                throw new RangeError('partition out of range');
+            }
+        }
+
+        this.disruptors = [];
+        this.partitions = partitions;
+        this._selector = new Selector2();
+
+        for (let i = 0; i < num_partitions; i += 1)
+        {
+            this.disruptors.push(new Disruptor2(`${shm_prefix}.${i}`,
+                                                num_elements,
+                                                element_size,
+                                                num_consumers,
+                                                consumer,
+                                                init,
+                                                spin,
+                                                options));
+        }
+
+        for (const i of partitions)
+        {
+            this._selector.add(this.disruptors[i]);
+        }
+    }
+
+    partition(key)
+    {
+        const n = this.disruptors.length;
+
+        if (Number.isInteger(key) && (key >= 0))
+        {
+            return key % n;
+        }
+
+        if (typeof key === 'string')
+        {
+            key = Buffer.from(key);
+        }
+        else if (!(key instanceof Uint8Array))
+        {
+            throw new TypeError('key must be a non-negative integer, string or Buffer');
+        }
+
+        // 32-bit FNV-1a
+        let h = 0x811c9dc5;
+        for (const b of key)
+        {
+            h = Math.imul(h ^ b, 0x01000193);
+        }
+
+        return (h >>> 0) % n;
+    }
+
+    disruptor(key)
+    {
+        return this.disruptors[this.partition(key)];
+    }
+
+    produceSync(key, data)
+    {
+        return this.disruptor(key).produceSync(data);
+    }
+
+    produceManySync(key, data)
+    {
+        return this.disruptor(key).produceManySync(data);
+    }
+
+    consumeNew(cb)
+    {
+        return this._selector.select(cb);
+    }
+
+    consumeNewSync()
+    {
+        return this._selector.selectSync();
+    }
+
+    consumeCommit()
+    {
+        let r = true;
+        for (const i of this.partitions)
+        {
+            r = this.disruptors[i].consumeCommit() && r;
+        }
+        return r;
+    }
+
+    release(mark_ignore)
+    {
+        this.disruptors.forEach((d, i) =>
+        {
+            d.release(!!mark_ignore && this.partitions.includes(i));
+        });
+    }
+}
+
+class ResizableDisruptor
+{
+    constructor(shm_name, num_elements, element_size, num_consumers,
+                consumer, init, spin, options)
+    {
+        const generation = (options && options.generation) || 0;
+
+        this._shm_name = shm_name;
+        this._args = [element_size, num_consumers, consumer, spin,
+                      Object.assign({}, options, { resizable: true })];
+        delete this._args[4].generation;
+
+        this.producer = this._open(generation, num_elements, init);
+        this.producerGeneration = generation;
+        this.consumer = this.producer;
+        this.consumerGeneration = generation;
+    }
+
+    _name(generation)
+    {
+        return generation === 0 ? this._shm_name : `${this._shm_name}.${generation}`;
+    }
+
+    _open(generation, num_elements, init)
+    {
+        const [element_size, num_consumers, consumer, spin, options] = this._args;
+        return new Disruptor2(this._name(generation),
+                              num_elements,
+                              element_size,
+                              num_consumers,
+                              consumer,
+                              init,
+                              spin,
+                              options);
+    }
+
+    _retire(d)
+    {
+        if ((d !== this.producer) && (d !== this.consumer))
+        {
+            d.release();
+        }
+    }
+
+    // Once every consumer has read a sealed generation to its end, nobody
+    // needs to open it again so remove its name. Its memory is freed when
+    // the last object which has it mapped releases it.
+    _unlinkDrained(d, generation)
+    {
+        if (d.drained)
+        {
+            Disruptor2.unlink(this._name(generation));
+        }
+    }
+
+    _follow(fwd)
+    {
+        if (fwd.generation === this.producerGeneration)
+        {
+            return this.producer;
+        }
+
+        if (fwd.generation === this.consumerGeneration)
+        {
+            return this.consumer;
+        }
+
+        return this._open(fwd.generation, fwd.numElements, false);
+    }
+
+    _followProducer()
+    {
+        const fwd = this.producer.forward;
+        if (!fwd)
+        {
+            return false;
+        }
+
+        const old = this.producer;
+        this.producer = this._follow(fwd);
+        this.producerGeneration = fwd.generation;
+        this._retire(old);
+        return true;
+    }
+
+    _followConsumer()
+    {
+        const fwd = this.consumer.forward;
+
+        // Everything claimed before the ring was sealed must be consumed
+        // first so nothing is lost or reordered
+        if (!fwd ||
+            (this.consumer.cursor !== fwd.boundary) ||
+            (this.consumer.lag !== 0))
+        {
+            return false;
+        }
+
+        const old = this.consumer;
+        const old_generation = this.consumerGeneration;
+        this.consumer = this._follow(fwd);
+        this.consumerGeneration = fwd.generation;
+        this._unlinkDrained(old, old_generation);
+        this._retire(old);
+        return true;
+    }
+
+    resize(num_elements)
+    {
+        // Replace the newest generation
+        while (this._followProducer())
+        {
+            // Someone else resized it already
+        }
+
+        const generation = this.producerGeneration + 1;
+        if (!this.producer.setForward(generation, num_elements))
+        {
+            // Someone else is resizing it
+            return false;
+        }
+
+        // Create the new generation before sealing the old one so it's
+        // there for anyone who sees the forward
+        const d = this._open(generation, num_elements, true);
+        this.producer.seal();
+
+        const old = this.producer;
+        const old_generation = this.producerGeneration;
+        this.producer = d;
+        this.producerGeneration = generation;
+        this._unlinkDrained(old, old_generation);
+        this._retire(old);
+        return true;
+    }
+
+    // Produce using f, moving to newer generations while it returns full
+    // and the generation it used has been resized
+    _produce(f, full)
+    {
+        while (true)
+        {
+            const r = f(this.producer);
+            if ((r !== full) || !this._followProducer())
+            {
+                return r;
+            }
+        }
+    }
+
+    // Consume using f, moving to the next generation while it returns
+    // nothing and the generation it used has been read to its end
+    _consume(f, empty)
+    {
+        while (true)
+        {
+            const r = f(this.consumer);
+            if (!empty(r) || !this._followConsumer())
+            {
+                return r;
+            }
+        }
+    }
+
+    produceSync(data)
+    {
+        return this._produce(d => d.produceSync(data), false);
+    }
+
+    produceManySync(data)
+    {
+        return this._produce(d => d.produceManySync(data), false);
+    }
+
+    produceFromSync(fd, max)
+    {
+        return this._produce(d => d.produceFromSync(fd, max), -1);
+    }
+
+    produceCompressSync(data)
+    {
+        return this._produce(d => d.produceCompressSync(data), false);
+    }
+
+    async consumeNew()
+    {
+        while (true)
+        {
+            const r = await this.consumer.consumeNew();
+            if ((r.bufs.length > 0) || !this._followConsumer())
+            {
+                return r;
+            }
+        }
+    }
+
+    consumeNewSync(max)
+    {
+        return this._consume(d => d.consumeNewSync(max), bufs => bufs.length === 0);
+    }
+
+    consumeToSync(fd, max)
+    {
+        return this._consume(d => d.consumeToSync(fd, max), n => n === 0);
+    }
+
+    consumeDecompressSync(max)
+    {
+        return this._consume(d => d.consumeDecompressSync(max), bufs => bufs.length === 0);
+    }
+
+    consumeCommit()
+    {
+        return this.consumer.consumeCommit();
+    }
+
+    release(mark_ignore)
+    {
+        if (this.producer !== this.consumer)
+        {
+            this.producer.release();
+        }
+        this.consumer.release(mark_ignore);
+    }
+}
+
+class Coalescer
+{
+    constructor(disruptor, options)
+    {
+        options = Object.assign({
+            maxElements: 64,
+            maxDelay: 100
+        }, options);
+
+        if (disruptor.elementSize === 0)
+        {
+            throw new Error('element_size is 0');
+        }
+
+        this.disruptor = disruptor;
+        this._element_size = disruptor.elementSize;
+        this._buf = Buffer.alloc(options.maxElements * this._element_size);
+        this._max_delay_ns = BigInt(options.maxDelay) * 1000n;
+        this._max_delay_ms = Math.max(options.maxDelay / 1000, 1);
+        this._length = 0;
+        this._first_ns = 0n;
+        this._timer = null;
+        this._closed = false;
+    }
+
+    get pending()
+    {
+        return this._length / this._element_size;
+    }
+
+    write(data)
+    {
+        if (this._closed)
+        {
+            throw new Error('closed');
+        }
+
+        if (typeof data === 'string')
+        {
+            data = Buffer.from(data);
+        }
+        else if (data instanceof ArrayBuffer)
+        {
+            data = Buffer.from(data);
+        }
+        else if (ArrayBuffer.isView(data) && !Buffer.isBuffer(data))
+        {
+            data = Buffer.from(data.buffer, data.byteOffset, data.byteLength);
+        }
+        else if (!Buffer.isBuffer(data))
+        {
+            throw new TypeError('data must be a Buffer, TypedArray, ArrayBuffer or string');
+        }
+
+        const size = Math.max(Math.ceil(data.length / this._element_size), 1) *
+                     this._element_size;
+
+        if ((this._length + size > this._buf.length) && !this.flush())
+        {
+            return false;
+        }
+
+        if (size > this._buf.length)
+        {
+            // Too big to stage
+            return this.disruptor.produceSync(data);
+        }
+
+        if (this._length === 0)
+        {
+            this._first_ns = process.hrtime.bigint();
+            this._schedule();
+        }
+
+        data.copy(this._buf, this._length);
+        this._buf.fill(0, this._length + data.length, this._length + size);
+        this._length += size;
+
+        if ((this._length === this._buf.length) ||
+            (process.hrtime.bigint() - this._first_ns >= this._max_delay_ns))
+        {
+            this.flush();
+        }
+
+        return true;
+    }
+
+    flush()
+    {
+        if (this._length === 0)
+        {
+            return true;
+        }
+
+        // One claim and one commit for everything staged
+        if (!this.disruptor.produceSync(this._buf.subarray(0, this._length)))
+        {
+            return false;
+        }
+
+        this._length = 0;
+
+        if (this._timer)
+        {
+            clearTimeout(this._timer);
+            this._timer = null;
+        }
+
+        return true;
+    }
+
+    close()
+    {
+        this._closed = true;
+
+        if (this._timer)
+        {
+            clearTimeout(this._timer);
+            this._timer = null;
+        }
+
+        return this.flush();
+    }
+
+    _schedule()
+    {
+        if (this._timer || this._closed)
+        {
+            return;
+        }
+
+        this._timer = setTimeout(() =>
+        {
+            this._timer = null;
+            if (!this.flush())
+            {
+                // Disruptor is full, try again later
+                this._schedule();
+            }
+        }, this._max_delay_ms);
+
+        // Don't keep the process alive just to write the buffer
+        this._timer.unref();
     }
 }
 
@@ -333,3 +961,8 @@ class DisruptorWriteStream extends Writable {
 exports.Disruptor = Disruptor2;
 exports.DisruptorReadStream = DisruptorReadStream;
 exports.DisruptorWriteStream = DisruptorWriteStream;
+exports.SnapshotTable = SnapshotTable;
+exports.Selector = Selector2;
+exports.PartitionedDisruptor = PartitionedDisruptor;
+exports.ResizableDisruptor = ResizableDisruptor;
+exports.Coalescer = Coalescer;
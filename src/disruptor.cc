@@ -3,26 +3,140 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <dlfcn.h>
 #include <memory>
 #include <napi.h>
+#include "lz4.h"
 #include <memory>
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
 #include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <chrono>
+#include <thread>
 #include <limits>
+#include <cmath>
+#include <type_traits>
+#include <array>
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 
 typedef uint64_t sequence_t;
 typedef int32_t status_t;
 
 const sequence_t sequence_max = std::numeric_limits<sequence_t>::max();
 
+// Set in next when a resizable ring has been replaced by a new generation
+const sequence_t sealed_bit = sequence_t(1) << 63;
+
+// Longest a reclaimer holds producers off slots while it gives back their
+// memory. Producers ignore a reclaimer which runs over this (e.g. because
+// its process died).
+const uint64_t reclaim_timeout_ns = 1000000000ULL;
+
 // Needs to be heap allocated because we access it from finalizers which can be called
 // on process exit
 static std::unordered_set<uint8_t*> *buffers;
 static std::mutex buffers_mutex;
 
+// Shared memory mapped once and used by Disruptors in many threads
+class SharedMapping
+{
+public:
+    SharedMapping(void *buf, size_t size) :
+        buf(buf),
+        size(size)
+    {
+    }
+
+    ~SharedMapping()
+    {
+        munmap(buf, size);
+    }
+
+    void *buf;
+    size_t size;
+};
+
+// Mappings by shared memory name, for Disruptors which share them.
+// Heap allocated for the same reason as buffers.
+static std::unordered_map<std::string, std::weak_ptr<SharedMapping>> *mappings;
+static std::mutex mappings_mutex;
+
 const int memorder = __ATOMIC_SEQ_CST;
 
+// Optional USDT probes for perf, bpftrace etc. Build with --trace=true.
+// The first argument of every probe is a timestamp in CPU cycles
+// (or nanoseconds where there's no cycle counter).
+#ifdef DISRUPTOR_TRACE
+#include <sys/sdt.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+inline uint64_t TraceTime()
+{
+    return __rdtsc();
+}
+#elif defined(__aarch64__)
+inline uint64_t TraceTime()
+{
+    uint64_t t;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+    return t;
+}
+#else
+#include <chrono>
+inline uint64_t TraceTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+#define TRACE(probe, ...) STAP_PROBEV(disruptor, probe, TraceTime(), __VA_ARGS__)
+#else
+#define TRACE(probe, ...)
+#endif
+
+class ProduceData;
+class NativeHandler;
+class Reclaimer;
+
+enum class Compare { All, Eq, Ne, Lt, Le, Gt, Ge };
+
+// Where to find a value in each slot for aggregating
+struct AggregateField
+{
+    const uint8_t* base;  // value for slot 0
+    size_t stride;        // bytes between slots
+    napi_typedarray_type type;
+};
+
+// A field stored in its own array of num_elements values (columnar layout)
+struct Column
+{
+    std::string name;
+    napi_typedarray_type type;
+    size_t size;    // bytes per value
+    size_t offset;  // from start of shared memory
+};
+
+// Each compressed record starts in a new slot with this header, followed by
+// the stored bytes
+struct RecordHeader
+{
+    uint32_t stored;  // bytes after the header (size if not compressed)
+    uint32_t size;    // bytes once decompressed
+};
+
 class Disruptor : public Napi::ObjectWrap<Disruptor>
 {
 public:
@@ -38,9 +152,28 @@ public:
     Napi::Value ConsumeNew(const Napi::CallbackInfo& info); 
     Napi::Value ConsumeNewSync(const Napi::CallbackInfo& info); 
 
+    // Wait for slots after those last returned
+    Napi::Value ConsumeWait(const Napi::CallbackInfo& info);
+    void ConsumeWaitCancel(const Napi::CallbackInfo&);
+
     // Commit consumed slots
     Napi::Value ConsumeCommit(const Napi::CallbackInfo&);
 
+    // Commit some consumed slots
+    Napi::Value ConsumeCommitUpTo(const Napi::CallbackInfo& info);
+
+    // Move a consumer back so it replays recently produced slots
+    Napi::Value ConsumeRewind(const Napi::CallbackInfo& info);
+
+    // Return slots at a given sequence number without consuming them
+    Napi::Value ReadAt(const Napi::CallbackInfo& info);
+
+    // Return number of consumed slots overwritten since they were returned
+    Napi::Value ConsumeCheck(const Napi::CallbackInfo& info);
+
+    // Return number of slots whose checksums don't match their data
+    Napi::Value VerifyChecksums(const Napi::CallbackInfo& info);
+
     // Claim a slot for writing a value
     Napi::Value ProduceClaim(const Napi::CallbackInfo& info);
     Napi::Value ProduceClaimSync(const Napi::CallbackInfo& info);
@@ -60,6 +193,22 @@ public:
     // Get slots previously claimed but not committed
     Napi::Value ProduceRecover(const Napi::CallbackInfo& info);
 
+    // Claim slots, copy data into them and commit them
+    Napi::Value ProduceSync(const Napi::CallbackInfo& info);
+    Napi::Value ProduceManySync(const Napi::CallbackInfo& info);
+
+    // Claim slots, read data from a file into them and commit them
+    Napi::Value ProduceFromSync(const Napi::CallbackInfo& info);
+
+    // Write unconsumed slots to a file and commit them
+    Napi::Value ConsumeToSync(const Napi::CallbackInfo& info);
+
+    // Compress data into a record and produce it
+    Napi::Value ProduceCompressSync(const Napi::CallbackInfo& info);
+
+    // Consume and decompress records, committing them
+    Napi::Value ConsumeDecompressSync(const Napi::CallbackInfo& info);
+
     // Get size of each element in bytes
     Napi::Value GetElementSize(const Napi::CallbackInfo& info);
 
@@ -72,23 +221,99 @@ public:
     // Set status value
     void SetStatus(const Napi::CallbackInfo& info, const Napi::Value& value);
 
+    // Get longest time to spin for
+    Napi::Value GetTimeout(const Napi::CallbackInfo& info);
+
+    // Set longest time to spin for
+    void SetTimeout(const Napi::CallbackInfo& info, const Napi::Value& value);
+
+    // Get number of slots producers are ahead of the slowest consumer
+    Napi::Value GetFill(const Napi::CallbackInfo& info);
+
+    // Get typed arrays over each column, indexed by slot
+    Napi::Value GetColumns(const Napi::CallbackInfo& info);
+
+    // Get number of consumed slots whose checksums didn't match
+    Napi::Value GetChecksumErrors(const Napi::CallbackInfo& info);
+
+    // Get number of corrupt compressed records consumed
+    Napi::Value GetCorruptRecords(const Napi::CallbackInfo& info);
+
+    // Get number of bytes of free slots given back to the OS
+    Napi::Value GetReclaimed(const Napi::CallbackInfo& info);
+
+    // Count, sum, min and max of a field over consumed slots
+    Napi::Value Aggregate(const Napi::CallbackInfo& info);
+
+    // Consume new slots without making buffers and aggregate a field
+    Napi::Value ConsumeAggregateSync(const Napi::CallbackInfo& info);
+
+    // Consume slots on a native thread, passing them to a function in a
+    // shared object
+    void AttachHandler(const Napi::CallbackInfo& info);
+    Napi::Value DetachHandler(const Napi::CallbackInfo& info);
+    Napi::Value GetHandlerStats(const Napi::CallbackInfo& info);
+
+    // Reserve the right to replace a resizable ring with a new generation
+    Napi::Value SetForward(const Napi::CallbackInfo& info);
+
+    // Stop producers claiming slots so they move to the new generation
+    Napi::Value Seal(const Napi::CallbackInfo& info);
+
+    // Get the generation which replaced this ring, if it's been sealed
+    Napi::Value GetForward(const Napi::CallbackInfo& info);
+
+    // Get whether a sealed ring has been read to its end by every consumer
+    Napi::Value GetDrained(const Napi::CallbackInfo& info);
+
+    // Remove a shared memory object's name, so its memory is freed once
+    // everyone has unmapped it
+    static Napi::Value Unlink(const Napi::CallbackInfo& info);
+
     inline bool Spin()
     {
         return spin;
     }
 
+    // When to stop spinning if we start now (0 = never)
+    uint64_t Deadline();
+
+    // Whether a deadline has passed
+    static bool Expired(const uint64_t deadline);
+
+    // Whether there are new slots for our consumer.
+    // Doesn't access any V8 stuff so can be called from worker threads.
+    inline bool Ready()
+    {
+        return (shm_buf != MAP_FAILED) &&
+               (__atomic_load_n(cursor, memorder) !=
+                __atomic_load_n(pool ? work : ptr_consumer, memorder));
+    }
+
 private:
     friend class ConsumeNewAsyncWorker;
+    friend class ConsumeWaitAsyncWorker;
     friend class ProduceClaimAsyncWorker;
     friend class ProduceClaimManyAsyncWorker;
     friend class ProduceClaimAvailAsyncWorker;
     friend class ProduceCommitAsyncWorker;
     friend class SyncBuffer;
     friend class AsyncBuffer;
+    friend class Selector;
+    friend class NativeHandler;
+    friend class Reclaimer;
+    friend class SelectAsyncWorker;
 
-    int Release();
+    void Release();
 
     void UpdatePending(sequence_t seq_consumer, sequence_t seq_cursor);
+    sequence_t SkipOverwritten(sequence_t seq_consumer, sequence_t seq_cursor);
+    void StampClaimed(sequence_t seq_next, sequence_t seq_next_end);
+    void StampCommitted(sequence_t seq_next, sequence_t seq_next_end);
+    uint32_t SlotCrc32c(const sequence_t pos);
+    void ChecksumCommitted(sequence_t seq_next, sequence_t seq_next_end);
+    sequence_t ChecksumMismatches(sequence_t seq, sequence_t seq_end);
+    bool Stamped(sequence_t seq, sequence_t seq_end);
     void UpdateSeqNext(const sequence_t seq_next,
                        const sequence_t seq_next_end,
                        const bool all_ignored);
@@ -104,10 +329,152 @@ private:
                            Array& r);
 
     template<typename Array, typename DisruptorBuffer>
-    Array ConsumeNewSync(const Napi::Env& env, const bool retry, sequence_t& start);
+    void ConsumeGetBuffers(const Napi::Env& env,
+                           const sequence_t seq_consumer,
+                           const sequence_t seq_cursor,
+                           Array& r);
+
+    template<typename Array, typename DisruptorBuffer>
+    Array ConsumeNewSync(const Napi::Env& env,
+                         const bool retry,
+                         sequence_t& start,
+                         const sequence_t max = sequence_max,
+                         const bool records = false);
     void ConsumeNewAsync(const Napi::CallbackInfo& info); 
 
     bool ConsumeCommit();
+    bool ConsumeCommitUpTo(const sequence_t seq);
+
+    sequence_t RecordSlots(const RecordHeader& header);
+    sequence_t RecordsEnd(sequence_t seq,
+                          const sequence_t seq_limit,
+                          const sequence_t seq_cursor);
+
+    // Whether there are new slots at or after seq.
+    // Doesn't access any V8 stuff so can be called from worker threads.
+    inline bool NewAfter(const sequence_t seq)
+    {
+        return pool ? (__atomic_load_n(cursor, memorder) !=
+                       __atomic_load_n(work, memorder)) :
+                      (__atomic_load_n(cursor, memorder) > seq);
+    }
+
+    bool BatchReady(const sequence_t seq,
+                    const sequence_t threshold,
+                    uint64_t& wait_start);
+
+    // Whether producers have moved to a new generation, so there's no point
+    // waiting for more slots.
+    // Doesn't access any V8 stuff so can be called from worker threads.
+    inline bool Sealed()
+    {
+        return (shm_buf != MAP_FAILED) &&
+               (__atomic_load_n(next, memorder) & sealed_bit);
+    }
+
+    // Whether a sealed ring has had all its claimed slots committed, so
+    // consumers won't get any more.
+    // Doesn't access any V8 stuff so can be called from worker threads.
+    inline bool Exhausted()
+    {
+        return Sealed() && (__atomic_load_n(cursor, memorder) == LoadNext());
+    }
+
+    // Next slot to claim, without the sealed bit
+    inline sequence_t LoadNext()
+    {
+        return __atomic_load_n(next, memorder) & ~sealed_bit;
+    }
+
+    // Throw unless elements have bytes to copy, read or write (a columnar
+    // ring can have element_size 0)
+    inline void CheckElementSize(const Napi::Env& env)
+    {
+        if (element_size == 0)
+        {
+            throw Napi::Error::New(env, "element_size is 0");
+        }
+    }
+
+    // Throw if a native handler is consuming for us, since it runs on its
+    // own thread and uses the same pending state
+    inline void CheckNoHandler(const Napi::Env& env)
+    {
+        if (handler)
+        {
+            throw Napi::Error::New(env, "handler attached");
+        }
+    }
+
+    // Whether slots we claimed earlier haven't been committed yet
+    inline bool ClaimPending()
+    {
+        return (pending_seq_next <= pending_seq_next_end) &&
+               (__atomic_load_n(cursor, memorder) <= pending_seq_next_end);
+    }
+
+    // First slot whose memory is being given back, or sequence_max if none.
+    // Producers can't claim it or any slot after it.
+    // Doesn't access any V8 stuff so can be called from worker threads.
+    sequence_t ReclaimLimit();
+
+    // First slot whose data hasn't been given back. Slots before it read
+    // as zeros.
+    inline sequence_t ReclaimedEnd()
+    {
+        const sequence_t seq_reclaimed = __atomic_load_n(&reclaiming[2], memorder);
+        return (seq_reclaimed > num_elements) ? seq_reclaimed - num_elements : 0;
+    }
+
+    // Wait until slots we've just claimed aren't being given back. A
+    // reclaimer which published its limit before we claimed them will
+    // either see our claim and stop or finish first.
+    // Doesn't access any V8 stuff so can be called from worker threads.
+    inline void WaitReclaimed(const sequence_t seq_next_end)
+    {
+        while (ReclaimLimit() <= seq_next_end)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    sequence_t ConsumeLimit();
+    bool ConsumeWaited(const sequence_t n, const sequence_t limit);
+
+    uint32_t ProduceSize(const size_t length);
+    void ProduceCopy(const sequence_t seq,
+                     const uint8_t *data,
+                     const size_t length,
+                     const uint32_t n);
+    bool ProduceCopySync(const Napi::Env& env,
+                         const std::vector<ProduceData>& data,
+                         const uint64_t n);
+
+    AggregateField GetAggregateField(const Napi::Env& env,
+                                     const Napi::Value& field);
+    Napi::Value AggregateSync(const Napi::CallbackInfo& info,
+                              const bool consume);
+    template<typename T>
+    Napi::Value AggregateSync(const Napi::Env& env,
+                              const AggregateField& field,
+                              const Compare cmp,
+                              const Napi::Value& value,
+                              const bool consume,
+                              const sequence_t max);
+
+    int GetIOVecs(const sequence_t seq,
+                  const size_t offset,
+                  const size_t length,
+                  iovec *iov);
+    void CopyFromSlots(const sequence_t seq,
+                       const size_t offset,
+                       const size_t length,
+                       void *dst);
+    ssize_t TransferAll(const int fd,
+                        const sequence_t seq,
+                        size_t& offset,
+                        const size_t end,
+                        const bool write);
 
     template<typename DisruptorBuffer>
     typename DisruptorBuffer::Buffer ProduceClaimSync(const Napi::Env& env,
@@ -156,16 +523,44 @@ private:
     uint32_t consumer;
     bool init;
     bool spin;
+    bool overwrite;
+    bool pool;
+    uint64_t timeout_ns;  // longest to spin for (0 = no limit)
 
     size_t shm_size;
     void* shm_buf;
+    std::shared_ptr<SharedMapping> mapping; // shared with other threads and workers
     
     sequence_t *consumers; // for each consumer, next slot to read
     sequence_t *cursor;    // next slot to be filled
     sequence_t *next;      // next slot to claim
     status_t *status;     // status code (app-specific)
     uint8_t* elements;
+    sequence_t *stamps;    // for each slot, sequence it holds plus 1 (overwrite mode)
+    sequence_t *dropped;   // for each consumer, slots skipped (overwrite mode)
     sequence_t *ptr_consumer;
+    sequence_t *work;      // next slot for a worker to claim (pool mode)
+    std::vector<Column> columns;
+    uint32_t *checksums;   // for each slot, CRC32C of its data (checksum mode)
+    uint64_t checksum_errors;
+    uint64_t corrupt_records;  // skipped by consumeDecompressSync
+    uint32_t max_record_size;  // largest record to decompress (0 = no limit)
+    sequence_t *forward;   // generation << 32 | size of the next ring (resizable mode)
+    sequence_t *reclaiming; // first slot being given back, deadline for doing so
+                            // (ns, 0 = not reclaiming) and end of slots given back
+
+    sequence_t *gating;    // sequences producers mustn't get N slots ahead of
+    uint32_t num_gating;
+
+    // Consume batching
+    sequence_t max_batch;         // most slots to return at once
+    sequence_t min_batch;         // fewest slots to return without waiting
+    uint64_t min_wait_ns;         // longest to wait for min_batch slots
+    uint64_t wait_start_ns;       // when we started waiting (0 = not waiting)
+    bool adaptive;                // whether to limit batches to target latency
+    uint64_t target_latency_ns;   // how long we want to hold slots for
+    double element_ns;            // average time to process a slot
+    uint64_t consume_ns;          // when we returned pending slots
 
     sequence_t pending_seq_consumer;
     sequence_t pending_seq_cursor;
@@ -173,28 +568,39 @@ private:
     sequence_t pending_seq_next;
     sequence_t pending_seq_next_end;
 
+    // Slot consumeToSync stopped part of the way through writing, and how
+    // many of its bytes were written
+    sequence_t to_seq;
+    size_t to_offset;
+
     bool all_consumers_ignoring;
 
+    uint64_t wait_epoch;  // changed to cancel consume waits
+
+    std::unique_ptr<NativeHandler> handler;
+    std::unique_ptr<Reclaimer> reclaimer;
+
     Napi::Reference<Napi::Buffer<uint8_t>> shm_buffer_ref;
     Napi::Reference<Napi::Buffer<uint8_t>> elements_buffer_ref;
     Napi::Reference<Napi::Buffer<uint8_t>> consumers_buffer_ref;
+    Napi::Reference<Napi::TypedArrayOf<uint64_t>> sequences_ref;
+    Napi::ObjectReference columns_ref;
     Napi::FunctionReference slice_ref;
 
     Napi::Value GetConsumers(const Napi::CallbackInfo& info);
     Napi::Value GetCursor(const Napi::CallbackInfo& info);
     Napi::Value GetNext(const Napi::CallbackInfo& info);
     Napi::Value GetElements(const Napi::CallbackInfo& info);
+    Napi::Value GetSequences(const Napi::CallbackInfo& info);
     Napi::Value GetConsumer(const Napi::CallbackInfo& info);
     Napi::Value GetPendingSeqConsumer(const Napi::CallbackInfo& info);
     Napi::Value GetPendingSeqCursor(const Napi::CallbackInfo& info);
     Napi::Value GetPendingSeqNext(const Napi::CallbackInfo& info);
     Napi::Value GetPendingSeqNextEnd(const Napi::CallbackInfo& info);
     Napi::Value GetAllConsumersIgnoring(const Napi::CallbackInfo& info);
-
-    const char* ErrorMessage(const int r, const char* buf);
-    const char* ErrorMessage(const char* r, const char* buf);
-    void ThrowErrnoError(const Napi::CallbackInfo& info,
-                         const char *msg);
+    Napi::Value GetDropped(const Napi::CallbackInfo& info);
+    Napi::Value GetLag(const Napi::CallbackInfo& info);
+    Napi::Value GetBatchLimit(const Napi::CallbackInfo& info);
 };
 
 //LCOV_EXCL_START
@@ -203,1248 +609,4898 @@ void NullCallback(const Napi::CallbackInfo&)
 }
 //LCOV_EXCL_STOP
 
+bool HasCallback(const Napi::CallbackInfo& info, const uint32_t cb_arg)
+{
+    return (info.Length() > cb_arg) && info[cb_arg].IsFunction();
+}
+
 Napi::Function GetCallback(const Napi::CallbackInfo& info, const uint32_t cb_arg)
 {
-    if (info.Length() > cb_arg)
+    if (HasCallback(info, cb_arg))
     {
-        Napi::Value cb = info[cb_arg];
-        if (cb.IsFunction())
-        {
-            return cb.As<Napi::Function>();
-        }
+        return info[cb_arg].As<Napi::Function>();
     }
 
-    return Napi::Function::New<&NullCallback>(info.Env()); //LCOV_EXCL_LINE
+    // Worker will resolve a promise instead
+    return Napi::Function::New<&NullCallback>(info.Env());
 }
 
-class SyncBuffer
+Napi::Object GetOptions(const Napi::CallbackInfo& info, const size_t arg)
 {
-public:
-    typedef Napi::Buffer<uint8_t> Buffer;
+    return ((info.Length() > arg) && info[arg].IsObject()) ?
+        info[arg].As<Napi::Object>() : Napi::Object::New(info.Env());
+}
 
-    static Buffer New(Napi::Env env, Disruptor *d, sequence_t start, sequence_t end)
-    {
-#ifdef COVERAGE
-        return d->slice_ref.Value().Call(d->elements_buffer_ref.Value(),
-#else
-        return d->slice_ref.Call(d->elements_buffer_ref.Value(),
-#endif
-        {
-            Napi::Number::New(env, start * d->element_size),
-            Napi::Number::New(env, end * d->element_size)
-        }).As<Buffer>();
-    }
-};
+bool GetBoolOption(const Napi::Object& options, const char* name)
+{
+    return options.Get(name).ToBoolean();
+}
 
-class AsyncBuffer
+uint32_t GetUint32Option(const Napi::Object& options,
+                         const char* name,
+                         const uint32_t def)
 {
-public:
-    typedef AsyncBuffer Buffer;
+    Napi::Value v = options.Get(name);
+    return v.IsUndefined() ? def : v.ToNumber().Uint32Value();
+}
 
-    AsyncBuffer() : AsyncBuffer(0, 0, 0)
-    {
-    }
+int32_t GetInt32Option(const Napi::Object& options,
+                       const char* name,
+                       const int32_t def)
+{
+    Napi::Value v = options.Get(name);
+    return v.IsUndefined() ? def : v.ToNumber().Int32Value();
+}
 
-    static Buffer New(Napi::Env, Disruptor *d, sequence_t start, sequence_t end)
-    {
-        return Buffer(start, end, d->element_size);
-    }
+size_t Align(size_t n)
+{
+    return (n + sizeof(sequence_t) - 1) & ~(sizeof(sequence_t) - 1);
+}
 
-    Napi::Value ToValue(Napi::Env env, Disruptor *d)
-    {
-        return SyncBuffer::New(env, d, start, end);
-    }
+// Start each column on its own cache line
+size_t AlignColumn(size_t n)
+{
+    return (n + 63) & ~static_cast<size_t>(63);
+}
 
-    size_t Length()
-    {
-        return length;
-    }
+struct ColumnType
+{
+    const char* name;
+    napi_typedarray_type type;
+    size_t size;
+};
 
-private:
-    AsyncBuffer(sequence_t start, sequence_t end, uint32_t element_size) :
-        start(start),
-        end(end),
-        length((end - start) * element_size)
+const ColumnType column_types[] = {
+    { "int8", napi_int8_array, 1 },
+    { "uint8", napi_uint8_array, 1 },
+    { "int16", napi_int16_array, 2 },
+    { "uint16", napi_uint16_array, 2 },
+    { "int32", napi_int32_array, 4 },
+    { "uint32", napi_uint32_array, 4 },
+    { "float32", napi_float32_array, 4 },
+    { "float64", napi_float64_array, 8 },
+    { "bigint64", napi_bigint64_array, 8 },
+    { "biguint64", napi_biguint64_array, 8 }
+};
+
+const ColumnType* FindColumnType(const std::string& type)
+{
+    for (const auto& t : column_types)
     {
+        if (type == t.name)
+        {
+            return &t;
+        }
     }
 
-    sequence_t start;
-    sequence_t end;
-    size_t length;
-};
+    return nullptr;
+}
 
-template<typename T>
-class AsyncArray
+std::vector<Column> GetColumnsOption(const Napi::Env& env,
+                                     const Napi::Object& options)
 {
-public:
-    AsyncArray() :
-        elements(std::make_unique<std::vector<T>>())
+    std::vector<Column> columns;
+    Napi::Value v = options.Get("columns");
+
+    if (v.IsUndefined())
     {
+        return columns;
     }
 
-    static AsyncArray<T> New(Napi::Env)
+    if (!v.IsObject())
     {
-        return AsyncArray<T>();
+        throw Napi::TypeError::New(env, "columns must be an object");
     }
 
-    void Set(uint32_t index, T&& el)
+    Napi::Object schema = v.As<Napi::Object>();
+    Napi::Array names = schema.GetPropertyNames();
+
+    for (uint32_t i = 0; i < names.Length(); ++i)
     {
-        if (elements->size() <= index)
+        const std::string name = names.Get(i).ToString();
+        const std::string type = schema.Get(name).ToString();
+        const ColumnType* ct = FindColumnType(type);
+
+        if (!ct)
         {
-            elements->resize(index + 1);
+            throw Napi::TypeError::New(env, "unknown column type: " + type);
         }
 
-        (*elements)[index] = std::move(el);
+        columns.push_back({ name, ct->type, ct->size, 0 });
     }
 
-    Napi::Value ToValue(Napi::Env env, Disruptor *d)
+    return columns;
+}
+
+uint64_t ColumnsHash(const std::vector<Column>& columns)
+{
+    // FNV-1a of each field's name and type, in order. Never 0.
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](const uint8_t b)
     {
-        size_t length = elements->size();
-        Napi::Array r = Napi::Array::New(env);
-        for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ b) * 1099511628211ULL;
+    };
+
+    for (const auto& column : columns)
+    {
+        for (const char c : column.name)
         {
-            r[i] = (*elements)[i].ToValue(env, d);
+            add(static_cast<uint8_t>(c));
         }
-        return r;
+        add(0);
+        add(static_cast<uint8_t>(column.type));
     }
 
-    size_t Length()
+    return hash ? hash : 1;
+}
+
+Napi::TypedArray NewColumnArray(const Napi::Env& env,
+                                const Column& column,
+                                const size_t length,
+                                const Napi::ArrayBuffer& buffer,
+                                const size_t offset)
+{
+    switch (column.type)
     {
-        return elements->size();
+        case napi_int8_array:
+            return Napi::TypedArrayOf<int8_t>::New(env, length, buffer, offset, column.type);
+        case napi_uint8_array:
+            return Napi::TypedArrayOf<uint8_t>::New(env, length, buffer, offset, column.type);
+        case napi_int16_array:
+            return Napi::TypedArrayOf<int16_t>::New(env, length, buffer, offset, column.type);
+        case napi_uint16_array:
+            return Napi::TypedArrayOf<uint16_t>::New(env, length, buffer, offset, column.type);
+        case napi_int32_array:
+            return Napi::TypedArrayOf<int32_t>::New(env, length, buffer, offset, column.type);
+        case napi_uint32_array:
+            return Napi::TypedArrayOf<uint32_t>::New(env, length, buffer, offset, column.type);
+        case napi_float32_array:
+            return Napi::TypedArrayOf<float>::New(env, length, buffer, offset, column.type);
+        case napi_float64_array:
+            return Napi::TypedArrayOf<double>::New(env, length, buffer, offset, column.type);
+        case napi_bigint64_array:
+            return Napi::TypedArrayOf<int64_t>::New(env, length, buffer, offset, column.type);
+        default:
+            return Napi::TypedArrayOf<uint64_t>::New(env, length, buffer, offset, column.type);
     }
+}
 
-private:
-    std::unique_ptr<std::vector<T>> elements;
-};
+// CRC32C (Castagnoli), using CPU instructions where there are any
 
-class AsyncBoolean
+// Only used where the CPU has no CRC32C instructions
+//LCOV_EXCL_START
+uint32_t Crc32cTable(uint32_t crc, const uint8_t *p, size_t n)
 {
-public:
-    AsyncBoolean() :
-        b(false)
+    static const std::array<uint32_t, 256> table = []
     {
-    }
+        std::array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c >> 1) ^ ((c & 1) ? 0x82f63b78 : 0);
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
 
-    static AsyncBoolean New(Napi::Env, bool b)
+    for (; n > 0; --n, ++p)
     {
-        return AsyncBoolean(b);
+        crc = table[(crc ^ *p) & 0xff] ^ (crc >> 8);
     }
 
-    Napi::Value ToValue(Napi::Env env, Disruptor*)
+    return crc;
+}
+//LCOV_EXCL_STOP
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+__attribute__((target("sse4.2")))
+uint32_t Crc32cHardware(uint32_t crc, const uint8_t *p, size_t n)
+{
+#ifdef __x86_64__
+    for (; n >= 8; n -= 8, p += 8)
     {
-        return Napi::Boolean::New(env, b);
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        crc = static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+    }
+#endif
+    for (; n > 0; --n, ++p)
+    {
+        crc = _mm_crc32_u8(crc, *p);
     }
 
-    operator bool() const
+    return crc;
+}
+
+bool HasCrc32c()
+{
+    static const bool sse42 = (__builtin_cpu_init(),
+                               __builtin_cpu_supports("sse4.2"));
+    return sse42;
+}
+#elif defined(__ARM_FEATURE_CRC32)
+uint32_t Crc32cHardware(uint32_t crc, const uint8_t *p, size_t n)
+{
+    for (; n >= 8; n -= 8, p += 8)
     {
-        return b;
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        crc = __crc32cd(crc, v);
     }
 
-private:
-    AsyncBoolean(bool b) :
-        b(b)
+    for (; n > 0; --n, ++p)
     {
+        crc = __crc32cb(crc, *p);
     }
 
-    bool b;
-};
+    return crc;
+}
 
-class AsyncUndefined
+bool HasCrc32c()
 {
-};
-
-Napi::Number ToValue(const Napi::Env& env, sequence_t n)
+    return true;
+}
+#else
+uint32_t Crc32cHardware(uint32_t crc, const uint8_t *p, size_t n)
 {
-    return Napi::Number::New(env, n);
+    return Crc32cTable(crc, p, n);
 }
 
-Napi::Value ToValue(const Napi::Env& env, const AsyncUndefined&)
+bool HasCrc32c()
 {
-    return env.Undefined();
+    return false;
 }
+#endif
 
-template <typename Result,
-          typename Arg1 = AsyncUndefined,
-          typename Arg2 = AsyncUndefined,
-          typename Arg3 = AsyncUndefined>
-class DisruptorAsyncWorker : public Napi::AsyncWorker
+// Carry on a CRC32C from crc. Start with ~0U and invert the result.
+uint32_t Crc32cUpdate(const uint32_t crc, const uint8_t *p, const size_t n)
 {
-public:
-    DisruptorAsyncWorker(Disruptor *disruptor,
-                         const Napi::Function& callback) :
-        Napi::AsyncWorker(callback),
-        retry(false),
-        disruptor(disruptor), // disruptor_ref keeps this around
-        disruptor_ref(Napi::Persistent(disruptor->Value()))
+    return HasCrc32c() ? Crc32cHardware(crc, p, n) :
+                         Crc32cTable(crc, p, n); //LCOV_EXCL_LINE
+}
+
+// Aggregate kernels. Each reads a value of type T every stride bytes and
+// accumulates those which match a comparison. Results are kept in separate
+// lanes so the compiler can vectorise the loop, including floating point
+// sums which it otherwise isn't allowed to reorder.
+
+template<typename T>
+using SumType = typename std::conditional<
+    std::is_floating_point<T>::value, double,
+    typename std::conditional<
+        std::is_signed<T>::value, int64_t, uint64_t>::type>::type;
+
+template<typename T>
+struct AggregateResult
+{
+    AggregateResult() :
+        count(0),
+        sum(0),
+        min(std::numeric_limits<T>::has_infinity ?
+            std::numeric_limits<T>::infinity() :
+            std::numeric_limits<T>::max()),
+        max(std::numeric_limits<T>::has_infinity ?
+            -std::numeric_limits<T>::infinity() :
+            std::numeric_limits<T>::lowest())
     {
     }
 
-protected:
-    virtual void Retry() = 0;
+    uint64_t count;
+    SumType<T> sum;  // integers wrap around
+    T min;
+    T max;
+};
 
-    void OnOK() override
+const size_t aggregate_lanes = 8;
+
+template<typename T, Compare C>
+inline bool Matches(const T v, const T x)
+{
+    switch (C)
     {
-        if (disruptor->Spin() && retry)
-        {
-            return Retry();
-        }
+        case Compare::Eq: return v == x;
+        case Compare::Ne: return v != x;
+        case Compare::Lt: return v < x;
+        case Compare::Le: return v <= x;
+        case Compare::Gt: return v > x;
+        case Compare::Ge: return v >= x;
+        default: return true;
+    }
+}
 
-        Napi::Env env = Env();
+template<typename T, Compare C, bool Contiguous>
+__attribute__((always_inline)) inline
+void AggregateKernel(const uint8_t *p,
+                     const size_t n,
+                     const size_t stride,
+                     const T x,
+                     AggregateResult<T>& r)
+{
+    const size_t step = Contiguous ? sizeof(T) : stride;
+    uint64_t count[aggregate_lanes];
+    SumType<T> sum[aggregate_lanes];
+    T min[aggregate_lanes];
+    T max[aggregate_lanes];
 
-        Callback().MakeCallback(
-            Receiver().Value(),
-            std::initializer_list<napi_value>
-            {
-                env.Null(),
-                result.ToValue(env, disruptor),
-                ToValue(env, arg1),
-                ToValue(env, arg2),
-                ToValue(env, arg3)
-            });
+    for (size_t j = 0; j < aggregate_lanes; ++j)
+    {
+        count[j] = 0;
+        sum[j] = 0;
+        min[j] = r.min;
+        max[j] = r.max;
     }
 
-    Result result;
-    Arg1 arg1;
-    Arg2 arg2;
-    Arg3 arg3;
-    bool retry;
-    Disruptor *disruptor;
+    for (size_t i = 0; i < n; i += aggregate_lanes)
+    {
+        const size_t lanes = std::min(aggregate_lanes, n - i);
 
-private:
-    Napi::ObjectReference disruptor_ref;
-};
+        for (size_t j = 0; j < lanes; ++j)
+        {
+            T v;
+            memcpy(&v, p + (i + j) * step, sizeof(T));
+            const bool m = Matches<T, C>(v, x);
+            count[j] += m;
+            sum[j] += m ? static_cast<SumType<T>>(v) : 0;
+            min[j] = (m && (v < min[j])) ? v : min[j];
+            max[j] = (m && (v > max[j])) ? v : max[j];
+        }
+    }
 
-class CloseFD
-{
-public:
-    void operator()(int *fd)
+    for (size_t j = 0; j < aggregate_lanes; ++j)
     {
-        close(*fd);
-        delete fd;
+        r.count += count[j];
+        r.sum += sum[j];
+        r.min = (min[j] < r.min) ? min[j] : r.min;
+        r.max = (max[j] > r.max) ? max[j] : r.max;
     }
-};
+}
 
-//LCOV_EXCL_START
-const char* Disruptor::ErrorMessage(const int r, const char* buf)
+template<typename T, Compare C, bool Contiguous>
+void AggregateDefault(const uint8_t *p,
+                      const size_t n,
+                      const size_t stride,
+                      const T x,
+                      AggregateResult<T>& r)
 {
-    return r == 0 ? buf : nullptr;
+    AggregateKernel<T, C, Contiguous>(p, n, stride, x, r);
 }
 
-const char* Disruptor::ErrorMessage(const char* r, const char*)
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define DISRUPTOR_AVX2
+// Same kernel compiled for wider vectors, used if the CPU supports them.
+// Elsewhere (e.g. NEON on arm64) the baseline instruction set is used.
+template<typename T, Compare C, bool Contiguous>
+__attribute__((target("avx2")))
+void AggregateAVX2(const uint8_t *p,
+                   const size_t n,
+                   const size_t stride,
+                   const T x,
+                   AggregateResult<T>& r)
 {
-    return r;
+    AggregateKernel<T, C, Contiguous>(p, n, stride, x, r);
 }
-//LCOV_EXCL_STOP
 
-void Disruptor::ThrowErrnoError(const Napi::CallbackInfo& info,
-                                const char *msg)
+bool HasAVX2()
 {
-    int errnum = errno;
-    char buf[1025] = {0};
-    auto errmsg = ErrorMessage(strerror_r(errnum, buf, sizeof(buf) - 1), buf);
-    throw Napi::Error::New(info.Env(), 
-        std::string(msg) + ": " + (errmsg ? errmsg : std::to_string(errnum)));
+    static const bool avx2 = (__builtin_cpu_init(),
+                              __builtin_cpu_supports("avx2"));
+    return avx2;
 }
+#endif
 
-Disruptor::Disruptor(const Napi::CallbackInfo& info) :
-    Napi::ObjectWrap<Disruptor>(info),
-    shm_buf(MAP_FAILED)
+template<typename T, Compare C>
+void AggregateRange(const uint8_t *p,
+                    const size_t n,
+                    const size_t stride,
+                    const T x,
+                    AggregateResult<T>& r)
 {
-    // Arguments
-    Napi::String shm_name = info[0].As<Napi::String>();
-    num_elements = info[1].As<Napi::Number>();
-    element_size = info[2].As<Napi::Number>();
-    num_consumers = info[3].As<Napi::Number>();
-    consumer = info[4].As<Napi::Number>();
-    init = info[5].As<Napi::Boolean>();
-    spin = info[6].As<Napi::Boolean>();
-
-    // Open shared memory object
-    // OS X does not allow using O_TRUNC with shm_open.
-    // If this item exists, and init flag is true, delete it and recreate.
-    const auto name = shm_name.Utf8Value();
-    int shm_fd_tmp = shm_open(name.c_str(),
-        (init ? O_CREAT | O_EXCL : 0) | O_RDWR,
-        S_IRUSR | S_IWUSR);
-
-    if (init && shm_fd_tmp < 0 && errno == EEXIST)
+    // Columns and fields filling a whole element are contiguous
+    const bool contiguous = (stride == sizeof(T));
+#ifdef DISRUPTOR_AVX2
+    if (HasAVX2())
     {
-        shm_unlink(name.c_str());
-        shm_fd_tmp = shm_open(name.c_str(),
-            O_CREAT | O_EXCL | O_RDWR,
-            S_IRUSR | S_IWUSR);
+        return contiguous ? AggregateAVX2<T, C, true>(p, n, stride, x, r) :
+                            AggregateAVX2<T, C, false>(p, n, stride, x, r);
     }
+#endif
+    return contiguous ? AggregateDefault<T, C, true>(p, n, stride, x, r) :
+                        AggregateDefault<T, C, false>(p, n, stride, x, r);
+}
 
-    if (shm_fd_tmp < 0)
+template<typename T>
+void AggregateRange(const uint8_t *p,
+                    const size_t n,
+                    const size_t stride,
+                    const Compare cmp,
+                    const T x,
+                    AggregateResult<T>& r)
+{
+    switch (cmp)
     {
-        ThrowErrnoError(info, "Failed to open shared memory object");
+        case Compare::Eq: return AggregateRange<T, Compare::Eq>(p, n, stride, x, r);
+        case Compare::Ne: return AggregateRange<T, Compare::Ne>(p, n, stride, x, r);
+        case Compare::Lt: return AggregateRange<T, Compare::Lt>(p, n, stride, x, r);
+        case Compare::Le: return AggregateRange<T, Compare::Le>(p, n, stride, x, r);
+        case Compare::Gt: return AggregateRange<T, Compare::Gt>(p, n, stride, x, r);
+        case Compare::Ge: return AggregateRange<T, Compare::Ge>(p, n, stride, x, r);
+        default: return AggregateRange<T, Compare::All>(p, n, stride, x, r);
     }
+}
 
-    std::unique_ptr<int, CloseFD> shm_fd(new int(shm_fd_tmp));
-
-    // Allow space for:
-    // - a sequence number for each consumer
-    // - the cursor sequence number (last filled slot)
-    // - the next sequence number (first free slot)
-    // - a status code
-    // - all the elements
-    shm_size = (num_consumers + 2) * sizeof(sequence_t) +
-               sizeof(status_t) +
-               num_elements * element_size;
-
-    // Resize the shared memory if we're initializing it.
-    // Note: ftruncate initializes to null bytes.
-    if (init && (ftruncate(*shm_fd, shm_size) < 0))
+Compare GetCompare(const Napi::Env& env, const Napi::Value& filter)
+{
+    if (filter.IsUndefined() || filter.IsNull())
     {
-        ThrowErrnoError(info, "Failed to size shared memory"); //LCOV_EXCL_LINE
+        return Compare::All;
     }
 
-    // Map the shared memory
-    shm_buf = mmap(NULL,
-                   shm_size,
-                   PROT_READ | PROT_WRITE, MAP_SHARED,
-                   *shm_fd,
-                   0);
-    if (shm_buf == MAP_FAILED)
+    if (!filter.IsObject())
     {
-        ThrowErrnoError(info, "Failed to map shared memory"); //LCOV_EXCL_LINE
+        throw Napi::TypeError::New(env, "filter must be an object");
     }
 
-    consumers = static_cast<sequence_t*>(shm_buf);
-    cursor = &consumers[num_consumers];
-    next = &cursor[1];
-    status = reinterpret_cast<status_t*>(&next[1]);
-    elements = reinterpret_cast<uint8_t*>(&status[1]);
-    ptr_consumer = &consumers[consumer];
-
-    pending_seq_consumer = 0;
-    pending_seq_cursor = 0;
+    static const std::pair<const char*, Compare> ops[] = {
+        { "eq", Compare::Eq },
+        { "ne", Compare::Ne },
+        { "lt", Compare::Lt },
+        { "le", Compare::Le },
+        { "gt", Compare::Gt },
+        { "ge", Compare::Ge }
+    };
+
+    const std::string op = filter.As<Napi::Object>().Get("op").ToString();
+    for (const auto& o : ops)
+    {
+        if (op == o.first)
+        {
+            return o.second;
+        }
+    }
 
-    pending_seq_next = 1;
-    pending_seq_next_end = 0;
+    throw Napi::TypeError::New(env, "unknown filter op: " + op);
+}
 
-    all_consumers_ignoring = false;
+// Value to compare against must be exactly representable in the field's type
+template<typename T>
+T GetFilterValue(const Napi::Env& env, const Napi::Value& value)
+{
+    const double d = value.ToNumber().DoubleValue();
 
-    // From Node 14, V8 doesn't allow buffers pointing to the same memory:
-    //
-    // https://monorail-prod.appspot.com/p/v8/issues/detail?id=9908
-    // https://github.com/nodejs/node/issues/32463
-    //
-    // We work around this by having a single Buffer over all of shm_buf and using
-    // Buffer#slice() to return data from it.
-    //
-    // This leaves the issue of shm_buf getting the same address as a previous call -
-    // whether because the same shared memory is mapped or because it's been
-    // unmapped in Release() and then remapped again.
-    // 
-    // Since Node 14.3.0, we can be sure that the finalizer is run after the memory
-    // pointer is removed from the BackingStore:
-    //
-    // https://github.com/nodejs/node/pull/33321
-    //
-    // However, if the memory is Release()d before it's removed from the BackingStore
-    // then mmap may return it again and we won't be able to pass it to V8 without
-    // it exiting.
-    //
-    // Further, even if we remember the Buffers we create in an unordered_map, they
-    // become invalid before the finalizer is called. The finalizer is only guaranteed
-    // to be called sometime after the object is collected:
-    //
-    // https://github.com/nodejs/node-addon-api/issues/702#issuecomment-625897608
-    //
-    // This also applies to weak N-API references to the object.
-    //
-    // We can detect this using napi_get_reference_value but there's nothing we can
-    // do about it since the value will still be in the BackingStore until the finalizer
-    // is run. It's this window of time that's the problem - between the Buffer being
-    // collected and the finalizer being called.
-    //
-    // The solution implemented below is to maintain an unordered set of shm_bufs that
-    // are still alive in the BackingStore. If mmap returns one of these, we search
-    // downwards for the next address not in the set, adjusting the length of the
-    // Buffer we need to create accordingly. Since we're slicing Buffer views over it,
-    // where it starts from doesn't matter.
+    if ((std::numeric_limits<T>::has_infinity && std::isinf(d)) ||
+        ((d >= std::numeric_limits<T>::lowest()) &&
+         (d <= std::numeric_limits<T>::max()) &&
+         (static_cast<double>(static_cast<T>(d)) == d)))
+    {
+        return static_cast<T>(d);
+    }
 
-    Napi::Env env = info.Env();
-    const auto JSBuffer = env.Global().Get("Buffer").As<Napi::Function>();
-    const auto proto = JSBuffer.Get("prototype").As<Napi::Object>();
-    slice_ref = Napi::Persistent(proto.Get("slice").As<Napi::Function>());
+    throw Napi::RangeError::New(env, "filter value out of range");
+}
 
-    auto shm_buf8 = static_cast<uint8_t*>(shm_buf);
-    auto shm_size8 = shm_size;
-    Napi::Buffer<uint8_t> shm_buffer;
+template<>
+int64_t GetFilterValue<int64_t>(const Napi::Env& env, const Napi::Value& value)
+{
+    bool lossless = false;
+    const int64_t x = value.IsBigInt() ?
+        value.As<Napi::BigInt>().Int64Value(&lossless) : 0;
 
+    if (!lossless)
     {
-        std::lock_guard<std::mutex> lock(buffers_mutex);
-
-        while (shm_buf8) {
-            if (buffers->find(shm_buf8) == buffers->end()) {
-                break;
-            }
-            --shm_buf8;
-            ++shm_size8;
-        }
+        throw Napi::RangeError::New(env, "filter value out of range");
     }
 
-    if (!shm_buf8) {
-        //LCOV_EXCL_START
-        Release();
-        throw Napi::Error::New(env, "No space for buffer due to due to https://github.com/nodejs/node/issues/32463");
-        //LCOV_EXCL_STOP
-    }
+    return x;
+}
 
-    shm_buffer = Napi::Buffer<uint8_t>::New(
-        env,
-        shm_buf8,
-        shm_size8,
-        [](Napi::Env, uint8_t* shm_buf8) {
-            std::lock_guard<std::mutex> lock(buffers_mutex);
-            buffers->erase(shm_buf8);
-        });
+template<>
+uint64_t GetFilterValue<uint64_t>(const Napi::Env& env, const Napi::Value& value)
+{
+    bool lossless = false;
+    const uint64_t x = value.IsBigInt() ?
+        value.As<Napi::BigInt>().Uint64Value(&lossless) : 0;
 
+    if (!lossless)
     {
-        std::lock_guard<std::mutex> lock(buffers_mutex);
-        buffers->emplace(shm_buf8);
+        throw Napi::RangeError::New(env, "filter value out of range");
     }
 
-    shm_buffer_ref = Napi::Persistent(shm_buffer);
+    return x;
+}
 
-    const auto elements_start = elements - shm_buf8;
-    elements_buffer_ref = Napi::Persistent(slice_ref.Call(shm_buffer_ref.Value(),
-    {
-        Napi::Number::New(env, elements_start),
-        Napi::Number::New(env, elements_start + num_elements * element_size)
-    }).As<Napi::Buffer<uint8_t>>());
+// 64-bit integers are returned as BigInts, like in typed arrays
+Napi::Value AggregateValue(const Napi::Env& env, const double v, const bool)
+{
+    return Napi::Number::New(env, v);
+}
 
-    const auto consumers_start = reinterpret_cast<uint8_t*>(consumers) - shm_buf8;
-    consumers_buffer_ref = Napi::Persistent(slice_ref.Call(shm_buffer_ref.Value(),
-    {
-        Napi::Number::New(env, consumers_start),
-        Napi::Number::New(env, consumers_start + num_consumers * sizeof(sequence_t))
-    }).As<Napi::Buffer<uint8_t>>());
+Napi::Value AggregateValue(const Napi::Env& env, const int64_t v, const bool big)
+{
+    return big ? Napi::Value(Napi::BigInt::New(env, v)) :
+                 Napi::Value(Napi::Number::New(env, static_cast<double>(v)));
 }
 
-Disruptor::~Disruptor()
+Napi::Value AggregateValue(const Napi::Env& env, const uint64_t v, const bool big)
 {
-    Release();
+    return big ? Napi::Value(Napi::BigInt::New(env, v)) :
+                 Napi::Value(Napi::Number::New(env, static_cast<double>(v)));
 }
 
-int Disruptor::Release()
+uint64_t NowNs()
 {
-    shm_buffer_ref.Reset();
-    elements_buffer_ref.Reset();
-    consumers_buffer_ref.Reset();
-    slice_ref.Reset();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-    if (shm_buf != MAP_FAILED)
+sequence_t Disruptor::ReclaimLimit()
+{
+    // No deadline means nobody is reclaiming, and a passed one means the
+    // reclaimer died or is too slow. We may briefly see the limit from a
+    // previous pass but the reclaimer checks next again after storing its own.
+    const uint64_t deadline = __atomic_load_n(&reclaiming[1], memorder);
+    if ((deadline == 0) || (NowNs() >= deadline))
     {
-        int r = munmap(shm_buf, shm_size);
-
-        if (r < 0)
-        {
-            return r; //LCOV_EXCL_LINE
-        }
-
-        shm_buf = MAP_FAILED;
+        return sequence_max;
     }
+    return __atomic_load_n(&reclaiming[0], memorder);
+}
 
-    return 0;
+uint64_t Disruptor::Deadline()
+{
+    return timeout_ns ? NowNs() + timeout_ns : 0;
 }
 
-void Disruptor::Release(const Napi::CallbackInfo& info)
+bool Disruptor::Expired(const uint64_t deadline)
 {
-    if ((shm_buf != MAP_FAILED) &&
+    return deadline && (NowNs() >= deadline);
+}
+
+class SyncBuffer
+{
+public:
+    typedef Napi::Buffer<uint8_t> Buffer;
+
+    static Buffer New(Napi::Env env, Disruptor *d, sequence_t start, sequence_t end)
+    {
+#ifdef COVERAGE
+        return d->slice_ref.Value().Call(d->elements_buffer_ref.Value(),
+#else
+        return d->slice_ref.Call(d->elements_buffer_ref.Value(),
+#endif
+        {
+            Napi::Number::New(env, start * d->element_size),
+            Napi::Number::New(env, end * d->element_size)
+        }).As<Buffer>();
+    }
+};
+
+class AsyncBuffer
+{
+public:
+    typedef AsyncBuffer Buffer;
+
+    AsyncBuffer() : AsyncBuffer(0, 0, 0)
+    {
+    }
+
+    static Buffer New(Napi::Env, Disruptor *d, sequence_t start, sequence_t end)
+    {
+        return Buffer(start, end, d->element_size);
+    }
+
+    Napi::Value ToValue(Napi::Env env, Disruptor *d)
+    {
+        return SyncBuffer::New(env, d, start, end);
+    }
+
+    size_t Length()
+    {
+        return length;
+    }
+
+private:
+    AsyncBuffer(sequence_t start, sequence_t end, uint32_t element_size) :
+        start(start),
+        end(end),
+        length((end - start) * element_size)
+    {
+    }
+
+    sequence_t start;
+    sequence_t end;
+    size_t length;
+};
+
+template<typename T>
+class AsyncArray
+{
+public:
+    AsyncArray() :
+        elements(std::make_unique<std::vector<T>>())
+    {
+    }
+
+    static AsyncArray<T> New(Napi::Env)
+    {
+        return AsyncArray<T>();
+    }
+
+    void Set(uint32_t index, T&& el)
+    {
+        if (elements->size() <= index)
+        {
+            elements->resize(index + 1);
+        }
+
+        (*elements)[index] = std::move(el);
+    }
+
+    Napi::Value ToValue(Napi::Env env, Disruptor *d)
+    {
+        size_t length = elements->size();
+        Napi::Array r = Napi::Array::New(env);
+        for (size_t i = 0; i < length; ++i)
+        {
+            r[i] = (*elements)[i].ToValue(env, d);
+        }
+        return r;
+    }
+
+    size_t Length()
+    {
+        return elements->size();
+    }
+
+private:
+    std::unique_ptr<std::vector<T>> elements;
+};
+
+class AsyncBoolean
+{
+public:
+    AsyncBoolean() :
+        b(false)
+    {
+    }
+
+    static AsyncBoolean New(Napi::Env, bool b)
+    {
+        return AsyncBoolean(b);
+    }
+
+    Napi::Value ToValue(Napi::Env env, Disruptor*)
+    {
+        return Napi::Boolean::New(env, b);
+    }
+
+    operator bool() const
+    {
+        return b;
+    }
+
+private:
+    AsyncBoolean(bool b) :
+        b(b)
+    {
+    }
+
+    bool b;
+};
+
+class AsyncUndefined
+{
+};
+
+// Buffer and array types for claiming slots without making any buffers
+class NullBuffer
+{
+public:
+    typedef NullBuffer Buffer;
+
+    static Buffer New(Napi::Env, Disruptor*, sequence_t, sequence_t)
+    {
+        return Buffer();
+    }
+};
+
+class NullArray
+{
+public:
+    static NullArray New(Napi::Env)
+    {
+        return NullArray();
+    }
+
+    void Set(uint32_t, NullBuffer&&)
+    {
+    }
+};
+
+// Bytes to be copied into the Disruptor by ProduceSync
+class ProduceData
+{
+public:
+    ProduceData(const Napi::Value& value) :
+        ptr(nullptr),
+        is_string(false)
+    {
+        if (value.IsTypedArray())
+        {
+            Napi::TypedArray ta = value.As<Napi::TypedArray>();
+            ptr = static_cast<const uint8_t*>(ta.ArrayBuffer().Data()) +
+                  ta.ByteOffset();
+            length = ta.ByteLength();
+        }
+        else if (value.IsArrayBuffer())
+        {
+            Napi::ArrayBuffer ab = value.As<Napi::ArrayBuffer>();
+            ptr = static_cast<const uint8_t*>(ab.Data());
+            length = ab.ByteLength();
+        }
+        else if (value.IsString())
+        {
+            str = value.As<Napi::String>().Utf8Value();
+            is_string = true;
+            length = str.size();
+        }
+        else
+        {
+            throw Napi::TypeError::New(value.Env(),
+                "data must be a Buffer, TypedArray, ArrayBuffer or string");
+        }
+    }
+
+    // Bytes we've made ourselves
+    ProduceData(std::string&& bytes) :
+        length(bytes.size()),
+        ptr(nullptr),
+        str(std::move(bytes)),
+        is_string(true)
+    {
+    }
+
+    const uint8_t *Data() const
+    {
+        // Strings can move their characters when moved so don't keep a pointer
+        return is_string ? reinterpret_cast<const uint8_t*>(str.data()) : ptr;
+    }
+
+    size_t length;
+
+private:
+    const uint8_t *ptr;
+    std::string str;
+    bool is_string;
+};
+
+Napi::Number ToValue(const Napi::Env& env, sequence_t n)
+{
+    return Napi::Number::New(env, n);
+}
+
+Napi::Boolean ToValue(const Napi::Env& env, bool b)
+{
+    return Napi::Boolean::New(env, b);
+}
+
+Napi::Value ToValue(const Napi::Env& env, const AsyncUndefined&)
+{
+    return env.Undefined();
+}
+
+// Property names for the objects promises resolve to, each ending with nullptr
+const char* const consume_names[] = { "bufs", "start", nullptr };
+const char* const claim_names[] = { "buf", "claimStart", "claimEnd", "allConsumersIgnoring", nullptr };
+const char* const claim_many_names[] = { "bufs", "claimStart", "claimEnd", "allConsumersIgnoring", nullptr };
+
+Napi::Value Resolution(const Napi::Env& env,
+                       const char* const* names,
+                       std::initializer_list<napi_value> values)
+{
+    // No names means resolve to the first value
+    if (!names)
+    {
+        return Napi::Value(env, *values.begin());
+    }
+
+    Napi::Object r = Napi::Object::New(env);
+    size_t i = 0;
+    for (napi_value v : values)
+    {
+        if (!names[i])
+        {
+            break;
+        }
+        r.Set(names[i++], v);
+    }
+    return r;
+}
+
+template <typename Result,
+          typename Arg1 = AsyncUndefined,
+          typename Arg2 = AsyncUndefined,
+          typename Arg3 = AsyncUndefined>
+class DisruptorAsyncWorker : public Napi::AsyncWorker
+{
+public:
+    DisruptorAsyncWorker(Disruptor *disruptor,
+                         const Napi::Function& callback,
+                         const char* const* names = nullptr) :
+        Napi::AsyncWorker(callback),
+        retry(false),
+        disruptor(disruptor), // disruptor_ref keeps this around
+        spin(disruptor->Spin()),
+        deadline(disruptor->Deadline()),
+        names(names),
+        disruptor_ref(Napi::Persistent(disruptor->Value()))
+    {
+        TRACE(async_queue, disruptor, this);
+    }
+
+    using Napi::AsyncWorker::Queue;
+
+    // Queue the worker to resolve a promise instead of calling back
+    void Queue(const Napi::Promise::Deferred& deferred)
+    {
+        this->deferred = std::make_shared<Napi::Promise::Deferred>(deferred);
+        Queue();
+    }
+
+protected:
+    virtual void Retry() = 0;
+
+    // Queue a worker to try again before our deadline
+    void Requeue(DisruptorAsyncWorker *worker)
+    {
+        worker->deadline = deadline;
+        worker->deferred = deferred;
+        worker->Queue();
+    }
+
+    void OnOK() override
+    {
+        TRACE(async_complete, disruptor, this, retry);
+
+        if (spin && retry && !Disruptor::Expired(deadline))
+        {
+            return Retry();
+        }
+
+        Napi::Env env = Env();
+
+        if (deferred)
+        {
+            return deferred->Resolve(Resolution(env, names,
+            {
+                result.ToValue(env, disruptor),
+                ToValue(env, arg1),
+                ToValue(env, arg2),
+                ToValue(env, arg3)
+            }));
+        }
+
+        Callback().MakeCallback(
+            Receiver().Value(),
+            std::initializer_list<napi_value>
+            {
+                env.Null(),
+                result.ToValue(env, disruptor),
+                ToValue(env, arg1),
+                ToValue(env, arg2),
+                ToValue(env, arg3)
+            });
+    }
+
+    //LCOV_EXCL_START
+    void OnError(const Napi::Error& e) override
+    {
+        if (deferred)
+        {
+            return deferred->Reject(e.Value());
+        }
+
+        Napi::AsyncWorker::OnError(e);
+    }
+    //LCOV_EXCL_STOP
+
+    Result result;
+    Arg1 arg1;
+    Arg2 arg2;
+    Arg3 arg3;
+    bool retry;
+    Disruptor *disruptor;
+    bool spin;
+    uint64_t deadline;
+    const char* const* names;
+    std::shared_ptr<Napi::Promise::Deferred> deferred;
+
+private:
+    Napi::ObjectReference disruptor_ref;
+};
+
+class CloseFD
+{
+public:
+    void operator()(int *fd)
+    {
+        close(*fd);
+        delete fd;
+    }
+};
+
+//LCOV_EXCL_START
+const char* ErrorMessage(const int r, const char* buf)
+{
+    return r == 0 ? buf : nullptr;
+}
+
+const char* ErrorMessage(const char* r, const char*)
+{
+    return r;
+}
+//LCOV_EXCL_STOP
+
+void ThrowErrnoError(const Napi::CallbackInfo& info,
+                     const char *msg)
+{
+    int errnum = errno;
+    char buf[1025] = {0};
+    auto errmsg = ErrorMessage(strerror_r(errnum, buf, sizeof(buf) - 1), buf);
+    throw Napi::Error::New(info.Env(), 
+        std::string(msg) + ": " + (errmsg ? errmsg : std::to_string(errnum)));
+}
+
+void* MapSharedMemory(const Napi::CallbackInfo& info,
+                      const std::string& name,
+                      const size_t shm_size,
+                      const bool init)
+{
+    // Open shared memory object
+    // OS X does not allow using O_TRUNC with shm_open.
+    // If this item exists, and init flag is true, delete it and recreate.
+    int shm_fd_tmp = shm_open(name.c_str(),
+        (init ? O_CREAT | O_EXCL : 0) | O_RDWR,
+        S_IRUSR | S_IWUSR);
+
+    if (init && shm_fd_tmp < 0 && errno == EEXIST)
+    {
+        shm_unlink(name.c_str());
+        shm_fd_tmp = shm_open(name.c_str(),
+            O_CREAT | O_EXCL | O_RDWR,
+            S_IRUSR | S_IWUSR);
+    }
+
+    if (shm_fd_tmp < 0)
+    {
+        ThrowErrnoError(info, "Failed to open shared memory object");
+    }
+
+    std::unique_ptr<int, CloseFD> shm_fd(new int(shm_fd_tmp));
+
+    // Resize the shared memory if we're initializing it.
+    // Note: ftruncate initializes to null bytes.
+    if (init && (ftruncate(*shm_fd, shm_size) < 0))
+    {
+        ThrowErrnoError(info, "Failed to size shared memory"); //LCOV_EXCL_LINE
+    }
+
+    // Otherwise make sure it was initialized with the same layout
+    struct stat shm_stat;
+    if (fstat(*shm_fd, &shm_stat) < 0)
+    {
+        ThrowErrnoError(info, "Failed to get size of shared memory"); //LCOV_EXCL_LINE
+    }
+
+    if (static_cast<size_t>(shm_stat.st_size) < shm_size)
+    {
+        throw Napi::Error::New(info.Env(), "Shared memory is too small");
+    }
+
+    // Map the shared memory
+    void *shm_buf = mmap(NULL,
+                         shm_size,
+                         PROT_READ | PROT_WRITE, MAP_SHARED,
+                         *shm_fd,
+                         0);
+    if (shm_buf == MAP_FAILED)
+    {
+        ThrowErrnoError(info, "Failed to map shared memory"); //LCOV_EXCL_LINE
+    }
+
+    return shm_buf;
+}
+
+std::shared_ptr<SharedMapping> ShareSharedMemory(const Napi::CallbackInfo& info,
+                                                 const std::string& name,
+                                                 const size_t shm_size,
+                                                 const bool init)
+{
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+
+    // Initializing always makes a new mapping, existing users keep the old one
+    if (!init)
+    {
+        auto it = mappings->find(name);
+        if (it != mappings->end())
+        {
+            auto mapping = it->second.lock();
+            if (mapping)
+            {
+                if (mapping->size < shm_size)
+                {
+                    throw Napi::Error::New(info.Env(), "Shared memory is too small");
+                }
+
+                return mapping;
+            }
+        }
+    }
+
+    auto mapping = std::make_shared<SharedMapping>(
+        MapSharedMemory(info, name, shm_size, init), shm_size);
+    (*mappings)[name] = mapping;
+    return mapping;
+}
+
+// Handler function exported from a shared object. Called with contiguous
+// runs of slots. Return 0 to carry on, anything else to stop.
+typedef int (*on_batch_t)(const uint8_t *ptr, size_t len, uint64_t seq);
+
+// Consumes slots on its own thread and passes them to a native handler.
+// The Disruptor mustn't be used to consume while the handler is attached.
+class NativeHandler
+{
+public:
+    NativeHandler(Disruptor *disruptor,
+                  void *lib,
+                  on_batch_t on_batch,
+                  const uint64_t idle_ns) :
+        disruptor(disruptor),
+        lib(lib),
+        on_batch(on_batch),
+        idle_ns(idle_ns),
+        stop(false),
+        running(true),
+        batches(0),
+        elements(0),
+        result(0),
+        thread(&NativeHandler::Run, this)
+    {
+    }
+
+    ~NativeHandler()
+    {
+        Stop();
+        dlclose(lib);
+    }
+
+    // Waits for the current batch to finish
+    void Stop()
+    {
+        __atomic_store_n(&stop, true, memorder);
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    Napi::Object Stats(const Napi::Env& env)
+    {
+        Napi::Object r = Napi::Object::New(env);
+        r["running"] = Napi::Boolean::New(env, __atomic_load_n(&running, memorder));
+        r["batches"] = Napi::Number::New(env, __atomic_load_n(&batches, memorder));
+        r["elements"] = Napi::Number::New(env, __atomic_load_n(&elements, memorder));
+        r["result"] = Napi::Number::New(env, __atomic_load_n(&result, memorder));
+        return r;
+    }
+
+private:
+    void Run()
+    {
+        // Remember: don't access any V8 stuff in this thread
+        Napi::Env env(nullptr);
+
+        while (!__atomic_load_n(&stop, memorder))
+        {
+            sequence_t start;
+            disruptor->ConsumeNewSync<NullArray, NullBuffer>(env, false, start);
+
+            if (!disruptor->pending_seq_cursor)
+            {
+                if (idle_ns > 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(idle_ns));
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+
+            // Slots may wrap around the end of the ring
+            const sequence_t n = disruptor->pending_seq_cursor - start;
+            const sequence_t pos = start % disruptor->num_elements;
+            const sequence_t first = std::min(n, disruptor->num_elements - pos);
+            const uint32_t element_size = disruptor->element_size;
+            uint8_t *elements = disruptor->elements;
+
+            // Number of slots on_batch has accepted
+            sequence_t accepted = 0;
+
+            int r = on_batch(elements + pos * element_size,
+                             first * element_size,
+                             start);
+            if (r == 0)
+            {
+                accepted = first;
+                if (n > first)
+                {
+                    r = on_batch(elements, (n - first) * element_size, start + first);
+                    if (r == 0)
+                    {
+                        accepted = n;
+                    }
+                }
+            }
+
+            if (r != 0)
+            {
+                if (disruptor->pool)
+                {
+                    // Other workers won't see the slots we claimed
+                    disruptor->ConsumeCommit();
+                }
+                else
+                {
+                    // Leave the slots on_batch failed on for whoever
+                    // consumes next
+                    if (accepted > 0)
+                    {
+                        disruptor->ConsumeCommitUpTo(start + accepted);
+                    }
+                    disruptor->pending_seq_cursor = 0;
+                }
+                __atomic_add_fetch(&elements, accepted, memorder);
+                __atomic_store_n(&result, r, memorder);
+                break;
+            }
+
+            disruptor->ConsumeCommit();
+            __atomic_add_fetch(&batches, 1, memorder);
+            __atomic_add_fetch(&elements, n, memorder);
+        }
+
+        __atomic_store_n(&running, false, memorder);
+    }
+
+    Disruptor *disruptor;
+    void *lib;
+    on_batch_t on_batch;
+    uint64_t idle_ns;  // how long to sleep when there's nothing to consume
+
+    bool stop;
+    bool running;
+    uint64_t batches;
+    uint64_t elements;
+    int32_t result;    // what on_batch returned if it stopped us
+
+    std::thread thread;
+};
+
+// Gives back the memory behind free slots on its own thread, so an idle
+// ring's resident size follows what it holds rather than its peak.
+// Slots are free once every consumer has read them. Those within distance
+// of next are left alone because producers are about to claim them.
+class Reclaimer
+{
+public:
+    Reclaimer(Disruptor *disruptor,
+              const uint64_t interval_ns,
+              const sequence_t distance) :
+        disruptor(disruptor),
+        interval_ns(interval_ns),
+        distance(distance),
+        page_size(sysconf(_SC_PAGESIZE)),
+        reclaimed(0),
+        stop(false),
+        bytes(0),
+        thread(&Reclaimer::Run, this)
+    {
+    }
+
+    ~Reclaimer()
+    {
+        Stop();
+    }
+
+    // Waits for the current pass to finish
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_one();
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    uint64_t Bytes()
+    {
+        return __atomic_load_n(&bytes, memorder);
+    }
+
+private:
+    void Run()
+    {
+        // Remember: don't access any V8 stuff in this thread
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!cv.wait_for(lock,
+                            std::chrono::nanoseconds(interval_ns),
+                            [this] { return stop; }))
+        {
+            Reclaim();
+        }
+    }
+
+    void Reclaim()
+    {
+        // Take over publishing a reclaim limit. Someone else may be
+        // reclaiming already, unless they've run out of time.
+        sequence_t *reclaiming = disruptor->reclaiming;
+        const uint64_t now = NowNs();
+        const uint64_t deadline = now + reclaim_timeout_ns;
+        uint64_t expected = __atomic_load_n(&reclaiming[1], memorder);
+        if (((expected != 0) && (now < expected)) ||
+            !__atomic_compare_exchange_n(&reclaiming[1],
+                                         &expected,
+                                         deadline,
+                                         false,
+                                         memorder,
+                                         memorder))
+        {
+            return;
+        }
+
+        const sequence_t seq_next = disruptor->LoadNext();
+
+        sequence_t seq_consumer = sequence_max;
+        for (uint32_t i = 0; i < disruptor->num_gating; ++i)
+        {
+            seq_consumer = std::min(seq_consumer,
+                __atomic_load_n(&disruptor->gating[i], memorder));
+        }
+
+        // Nothing to do if all consumers are ignored
+        if (seq_consumer != sequence_max)
+        {
+            // Slots [seq_next, seq_consumer + num_elements) are free
+            const sequence_t seq_start = std::max(seq_next + distance, reclaimed);
+            const sequence_t seq_end = seq_consumer + disruptor->num_elements;
+
+            // Stop producers claiming from seq_start, then check none
+            // got there before we did. Producers which claim after this
+            // wait for us to finish.
+            __atomic_store_n(&reclaiming[0], seq_start, memorder);
+
+            if ((seq_start < seq_end) &&
+                (disruptor->LoadNext() <= seq_start) &&
+                (NowNs() < deadline))
+            {
+                ReclaimSlots(disruptor->elements, disruptor->element_size,
+                             seq_start, seq_end);
+                for (const auto& column : disruptor->columns)
+                {
+                    ReclaimSlots(static_cast<uint8_t*>(disruptor->shm_buf) + column.offset,
+                                 column.size, seq_start, seq_end);
+                }
+                reclaimed = seq_end;
+
+                // Let consumers know not to rewind onto zeroed slots
+                if (__atomic_load_n(&reclaiming[2], memorder) < seq_end)
+                {
+                    __atomic_store_n(&reclaiming[2], seq_end, memorder);
+                }
+            }
+        }
+
+        // Another reclaimer may have taken over if we ran out of time
+        expected = deadline;
+        __atomic_compare_exchange_n(&reclaiming[1],
+                                    &expected,
+                                    0,
+                                    false,
+                                    memorder,
+                                    memorder);
+    }
+
+    void ReclaimSlots(uint8_t *base,
+                      const size_t size,
+                      const sequence_t seq_start,
+                      const sequence_t seq_end)
+    {
+        // Slots may wrap around the end of the ring
+        const sequence_t n = seq_end - seq_start;
+        const sequence_t pos = seq_start % disruptor->num_elements;
+        const sequence_t first = std::min(n, disruptor->num_elements - pos);
+
+        ReclaimBytes(base + pos * size, first * size);
+        if (n > first)
+        {
+            ReclaimBytes(base, (n - first) * size);
+        }
+    }
+
+    void ReclaimBytes(uint8_t *ptr, const size_t length)
+    {
+        // Only whole pages can be given back
+        const uintptr_t start = (reinterpret_cast<uintptr_t>(ptr) + page_size - 1) & ~(page_size - 1);
+        const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + length) & ~(page_size - 1);
+
+        if (start >= end)
+        {
+            return;
+        }
+
+        void *addr = reinterpret_cast<void*>(start);
+
+        // MADV_DONTNEED only drops our mapping of shared memory pages,
+        // MADV_REMOVE frees them
+#ifdef MADV_REMOVE
+        if (madvise(addr, end - start, MADV_REMOVE) < 0)
+#endif
+        {
+            if (madvise(addr, end - start, MADV_DONTNEED) < 0)
+            {
+                return; //LCOV_EXCL_LINE
+            }
+        }
+
+        __atomic_add_fetch(&bytes, end - start, memorder);
+    }
+
+    Disruptor *disruptor;
+    uint64_t interval_ns;  // how often to look for free slots
+    sequence_t distance;   // free slots after next to keep
+    uintptr_t page_size;
+    sequence_t reclaimed;  // slots before this have been given back
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop;
+    uint64_t bytes;        // given back so far
+
+    std::thread thread;
+};
+
+Disruptor::Disruptor(const Napi::CallbackInfo& info) :
+    Napi::ObjectWrap<Disruptor>(info),
+    shm_buf(MAP_FAILED)
+{
+    // Arguments
+    Napi::String shm_name = info[0].As<Napi::String>();
+    num_elements = info[1].As<Napi::Number>();
+    element_size = info[2].As<Napi::Number>();
+    num_consumers = info[3].As<Napi::Number>();
+    consumer = info[4].As<Napi::Number>();
+    init = info[5].As<Napi::Boolean>();
+    spin = info[6].As<Napi::Boolean>();
+
+    // Options
+    Napi::Object options = GetOptions(info, 7);
+    overwrite = GetBoolOption(options, "overwrite");
+    pool = GetBoolOption(options, "pool");
+
+    if (overwrite && pool)
+    {
+        throw Napi::Error::New(info.Env(), "overwrite and pool can't be used together");
+    }
+
+    max_batch = GetUint32Option(options, "maxBatch", 0);
+    if (max_batch == 0)
+    {
+        max_batch = sequence_max;
+    }
+    min_batch = GetUint32Option(options, "minBatch", 1);
+    min_wait_ns = GetUint32Option(options, "minWait", 0) * 1000ULL;
+    wait_start_ns = 0;
+    adaptive = GetBoolOption(options, "adaptive");
+    target_latency_ns = GetUint32Option(options, "targetLatency", 1000) * 1000ULL;
+    element_ns = 0;
+    consume_ns = 0;
+    timeout_ns = GetUint32Option(options, "timeout", 0) * 1000ULL;
+    columns = GetColumnsOption(info.Env(), options);
+    const bool checksum = GetBoolOption(options, "checksum");
+    const bool resizable = GetBoolOption(options, "resizable");
+    const bool reclaim = GetBoolOption(options, "reclaim");
+    const uint64_t reclaim_interval_ns = GetUint32Option(options, "reclaimInterval", 1000000) * 1000ULL;
+    const sequence_t reclaim_distance = GetUint32Option(options, "reclaimDistance", num_elements / 2);
+
+    if (overwrite && reclaim)
+    {
+        // Consumers may still be reading slots producers have passed
+        throw Napi::Error::New(info.Env(), "overwrite and reclaim can't be used together");
+    }
+    const bool share = GetBoolOption(options, "share");
+
+    // Allow space for:
+    // - a sequence number for each consumer
+    // - the cursor sequence number (last filled slot)
+    // - the next sequence number (first free slot)
+    // - a status code
+    // - all the elements
+    shm_size = (num_consumers + 2) * sizeof(sequence_t) +
+               sizeof(status_t) +
+               num_elements * element_size;
+
+    // In overwrite mode, also allow space for:
+    // - a sequence stamp for each element
+    // - a dropped element count for each consumer
+    const size_t stamps_offset = Align(shm_size);
+    if (overwrite)
+    {
+        shm_size = stamps_offset +
+                   (num_elements + num_consumers) * sizeof(sequence_t);
+    }
+
+    // In pool mode, also allow space for the next slot to be claimed
+    // by a worker
+    const size_t work_offset = Align(shm_size);
+    if (pool)
+    {
+        shm_size = work_offset + sizeof(sequence_t);
+    }
+
+    // With a columnar layout, also allow space for a hash of the field
+    // names and types, so objects which list them in a different order
+    // can't read each other's columns
+    const size_t layout_offset = Align(shm_size);
+    if (!columns.empty())
+    {
+        shm_size = layout_offset + sizeof(uint64_t);
+    }
+
+    // With a columnar layout, also allow space for each column. Slot i's
+    // value for a field is at index i % num_elements in its column.
+    for (auto& column : columns)
+    {
+        column.offset = AlignColumn(shm_size);
+        shm_size = column.offset + num_elements * column.size;
+    }
+
+    // With checksums, also allow space for a CRC32C of each slot
+    const size_t checksums_offset = Align(shm_size);
+    if (checksum)
+    {
+        shm_size = checksums_offset + num_elements * sizeof(uint32_t);
+    }
+
+    // When resizable, also allow space for the generation and number of
+    // elements of the ring which replaces this one, packed into one word
+    // so they're published together
+    const size_t forward_offset = Align(shm_size);
+    if (resizable)
+    {
+        shm_size = forward_offset + sizeof(sequence_t);
+    }
+
+    // Always allow space for publishing which slots are being reclaimed,
+    // since any object may reclaim and all producers must check
+    const size_t reclaim_offset = Align(shm_size);
+    shm_size = reclaim_offset + 3 * sizeof(sequence_t);
+
+    if (share)
+    {
+        mapping = ShareSharedMemory(info, shm_name.Utf8Value(), shm_size, init);
+        shm_buf = mapping->buf;
+    }
+    else
+    {
+        // Not shared with other Disruptors but async workers may still be
+        // using it after we're released
+        mapping = std::make_shared<SharedMapping>(
+            MapSharedMemory(info, shm_name.Utf8Value(), shm_size, init), shm_size);
+        shm_buf = mapping->buf;
+    }
+
+    consumers = static_cast<sequence_t*>(shm_buf);
+    cursor = &consumers[num_consumers];
+    next = &cursor[1];
+    status = reinterpret_cast<status_t*>(&next[1]);
+    elements = reinterpret_cast<uint8_t*>(&status[1]);
+    ptr_consumer = &consumers[consumer];
+
+    if (overwrite)
+    {
+        // Producers don't wait for consumers, only for other producers to
+        // commit slots they're about to overwrite
+        stamps = reinterpret_cast<sequence_t*>(
+            static_cast<uint8_t*>(shm_buf) + stamps_offset);
+        dropped = &stamps[num_elements];
+        gating = cursor;
+        num_gating = 1;
+    }
+    else
+    {
+        stamps = nullptr;
+        dropped = nullptr;
+        gating = consumers;
+        num_gating = num_consumers;
+    }
+
+    // Workers in the pool take turns to claim slots. Each worker's consumer
+    // sequence is the first slot it hasn't finished, so producers gate on
+    // consumers as usual.
+    work = pool ? reinterpret_cast<sequence_t*>(
+        static_cast<uint8_t*>(shm_buf) + work_offset) : nullptr;
+
+    if (!columns.empty())
+    {
+        uint64_t *layout = reinterpret_cast<uint64_t*>(
+            static_cast<uint8_t*>(shm_buf) + layout_offset);
+        const uint64_t hash = ColumnsHash(columns);
+        if (init)
+        {
+            __atomic_store_n(layout, hash, memorder);
+        }
+        else
+        {
+            // 0 means the initialising object hasn't stored it yet
+            const uint64_t stored = __atomic_load_n(layout, memorder);
+            if (stored && (stored != hash))
+            {
+                throw Napi::Error::New(info.Env(), "columns don't match");
+            }
+        }
+    }
+
+    // Producers checksum slots when they commit them and consumers check
+    // them when they're returned
+    checksums = checksum ? reinterpret_cast<uint32_t*>(
+        static_cast<uint8_t*>(shm_buf) + checksums_offset) : nullptr;
+    checksum_errors = 0;
+    corrupt_records = 0;
+    max_record_size = GetUint32Option(options, "maxRecordSize", 0);
+
+    // Resizing seals this ring and points everyone at the next generation
+    forward = resizable ? reinterpret_cast<sequence_t*>(
+        static_cast<uint8_t*>(shm_buf) + forward_offset) : nullptr;
+
+    reclaiming = reinterpret_cast<sequence_t*>(
+        static_cast<uint8_t*>(shm_buf) + reclaim_offset);
+
+    pending_seq_consumer = 0;
+    pending_seq_cursor = 0;
+
+    pending_seq_next = 1;
+    to_seq = sequence_max;
+    to_offset = 0;
+    pending_seq_next_end = 0;
+
+    all_consumers_ignoring = false;
+
+    wait_epoch = 0;
+
+    // From Node 14, V8 doesn't allow buffers pointing to the same memory:
+    //
+    // https://monorail-prod.appspot.com/p/v8/issues/detail?id=9908
+    // https://github.com/nodejs/node/issues/32463
+    //
+    // We work around this by having a single Buffer over all of shm_buf and using
+    // Buffer#slice() to return data from it.
+    //
+    // This leaves the issue of shm_buf getting the same address as a previous call -
+    // whether because the same shared memory is mapped or because it's been
+    // unmapped in Release() and then remapped again.
+    // 
+    // Since Node 14.3.0, we can be sure that the finalizer is run after the memory
+    // pointer is removed from the BackingStore:
+    //
+    // https://github.com/nodejs/node/pull/33321
+    //
+    // However, if the memory is Release()d before it's removed from the BackingStore
+    // then mmap may return it again and we won't be able to pass it to V8 without
+    // it exiting.
+    //
+    // Further, even if we remember the Buffers we create in an unordered_map, they
+    // become invalid before the finalizer is called. The finalizer is only guaranteed
+    // to be called sometime after the object is collected:
+    //
+    // https://github.com/nodejs/node-addon-api/issues/702#issuecomment-625897608
+    //
+    // This also applies to weak N-API references to the object.
+    //
+    // We can detect this using napi_get_reference_value but there's nothing we can
+    // do about it since the value will still be in the BackingStore until the finalizer
+    // is run. It's this window of time that's the problem - between the Buffer being
+    // collected and the finalizer being called.
+    //
+    // The solution implemented below is to maintain an unordered set of shm_bufs that
+    // are still alive in the BackingStore. If mmap returns one of these, we search
+    // downwards for the next address not in the set, adjusting the length of the
+    // Buffer we need to create accordingly. Since we're slicing Buffer views over it,
+    // where it starts from doesn't matter. We step down a sequence number at a time
+    // so typed arrays over the sequence numbers are still aligned.
+
+    Napi::Env env = info.Env();
+    const auto JSBuffer = env.Global().Get("Buffer").As<Napi::Function>();
+    const auto proto = JSBuffer.Get("prototype").As<Napi::Object>();
+    slice_ref = Napi::Persistent(proto.Get("slice").As<Napi::Function>());
+
+    auto shm_buf8 = static_cast<uint8_t*>(shm_buf);
+    auto shm_size8 = shm_size;
+    Napi::Buffer<uint8_t> shm_buffer;
+
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+
+        while (shm_buf8) {
+            if (buffers->find(shm_buf8) == buffers->end()) {
+                break;
+            }
+            shm_buf8 -= sizeof(sequence_t);
+            shm_size8 += sizeof(sequence_t);
+        }
+    }
+
+    if (!shm_buf8) {
+        //LCOV_EXCL_START
+        Release();
+        throw Napi::Error::New(env, "No space for buffer due to due to https://github.com/nodejs/node/issues/32463");
+        //LCOV_EXCL_STOP
+    }
+
+    shm_buffer = Napi::Buffer<uint8_t>::New(
+        env,
+        shm_buf8,
+        shm_size8,
+        [](Napi::Env, uint8_t* shm_buf8) {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffers->erase(shm_buf8);
+        });
+
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers->emplace(shm_buf8);
+    }
+
+    shm_buffer_ref = Napi::Persistent(shm_buffer);
+
+    const auto elements_start = elements - shm_buf8;
+    elements_buffer_ref = Napi::Persistent(slice_ref.Call(shm_buffer_ref.Value(),
+    {
+        Napi::Number::New(env, elements_start),
+        Napi::Number::New(env, elements_start + num_elements * element_size)
+    }).As<Napi::Buffer<uint8_t>>());
+
+    const auto consumers_start = reinterpret_cast<uint8_t*>(consumers) - shm_buf8;
+    consumers_buffer_ref = Napi::Persistent(slice_ref.Call(shm_buffer_ref.Value(),
+    {
+        Napi::Number::New(env, consumers_start),
+        Napi::Number::New(env, consumers_start + num_consumers * sizeof(sequence_t))
+    }).As<Napi::Buffer<uint8_t>>());
+
+    // Consumers followed by cursor and next
+    sequences_ref = Napi::Persistent(Napi::TypedArrayOf<uint64_t>::New(
+        env,
+        num_consumers + 2,
+        shm_buffer.ArrayBuffer(),
+        consumers_start,
+        napi_biguint64_array));
+
+    // Column views over the whole ring. shm_buf8 is only ever moved down in
+    // sequence number steps so these stay aligned.
+    Napi::Object columns_obj = Napi::Object::New(env);
+    for (const auto& column : columns)
+    {
+        const auto column_start =
+            static_cast<uint8_t*>(shm_buf) + column.offset - shm_buf8;
+        columns_obj.Set(column.name, NewColumnArray(
+            env, column, num_elements, shm_buffer.ArrayBuffer(), column_start));
+    }
+    columns_ref = Napi::Persistent(columns_obj);
+
+    if (reclaim)
+    {
+        reclaimer.reset(new Reclaimer(this, reclaim_interval_ns, reclaim_distance));
+    }
+}
+
+Disruptor::~Disruptor()
+{
+    Release();
+}
+
+void Disruptor::Release()
+{
+    // Stop using the memory before unmapping it
+    handler.reset();
+    reclaimer.reset();
+
+    shm_buffer_ref.Reset();
+    elements_buffer_ref.Reset();
+    consumers_buffer_ref.Reset();
+    sequences_ref.Reset();
+    columns_ref.Reset();
+    slice_ref.Reset();
+
+    // Unmapped when the last Disruptor or async worker using it lets go
+    mapping.reset();
+    shm_buf = MAP_FAILED;
+}
+
+void Disruptor::Release(const Napi::CallbackInfo& info)
+{
+    // Stop the handler committing after we mark the consumer as ignored
+    handler.reset();
+
+    if ((shm_buf != MAP_FAILED) &&
         (info.Length() >= 1) &&
         info[0].As<Napi::Boolean>())
     {
-        __atomic_store_n(ptr_consumer, sequence_max, memorder);
+        __atomic_store_n(ptr_consumer, sequence_max, memorder);
+    }
+
+    Release();
+}
+
+#include <iostream>
+
+template<typename Array, typename DisruptorBuffer>
+void Disruptor::ConsumeGetBuffers(const Napi::Env& env,
+                                  const sequence_t seq_consumer,
+                                  const sequence_t seq_cursor,
+                                  Array& r)
+{
+    sequence_t pos_consumer = seq_consumer % num_elements;
+    sequence_t pos_cursor = seq_cursor % num_elements;
+
+    if (pos_cursor > pos_consumer)
+    {
+        r.Set(0U, DisruptorBuffer::New(env, this, pos_consumer, pos_cursor));
+    }
+    else
+    {
+        r.Set(0U, DisruptorBuffer::New(env, this, pos_consumer, num_elements));
+        if (pos_cursor > 0)
+        {
+            r.Set(1U, DisruptorBuffer::New(env, this, 0, pos_cursor));
+        }
+    }
+}
+
+template<typename Array, typename DisruptorBuffer>
+Array Disruptor::ConsumeNewSync(const Napi::Env& env,
+                                const bool retry,
+                                sequence_t &start,
+                                const sequence_t max,
+                                const bool records)
+{
+    // Return all elements [&consumers[consumer], cursor),
+    // up to max elements. If records is true, don't split a compressed
+    // record, even if that means going over max.
+    // In pool mode, return elements [work, cursor) and move work on.
+
+    // Commit previous consume
+    ConsumeCommit();
+
+    TRACE(consume_entry, this, max);
+
+    const sequence_t limit = std::min(max, ConsumeLimit());
+    const uint64_t deadline = retry ? Deadline() : 0;
+    bool lost;
+
+    do
+    {
+        sequence_t seq_consumer = __atomic_load_n(pool ? work : ptr_consumer, memorder);
+        sequence_t seq_cursor = __atomic_load_n(cursor, memorder);
+        lost = false;
+
+        if (pool)
+        {
+            // Everything before work has been claimed, so we're not holding
+            // anything up. Don't let producers past what we might claim.
+            __atomic_store_n(ptr_consumer, seq_consumer, memorder);
+        }
+
+        if (overwrite && (seq_cursor != seq_consumer))
+        {
+            seq_consumer = SkipOverwritten(seq_consumer, seq_cursor);
+        }
+
+        if (seq_cursor - seq_consumer > limit)
+        {
+            seq_cursor = records ?
+                RecordsEnd(seq_consumer, seq_consumer + limit, seq_cursor) :
+                seq_consumer + limit;
+        }
+
+        if ((seq_cursor != seq_consumer) &&
+            ConsumeWaited(seq_cursor - seq_consumer, limit))
+        {
+            if (pool &&
+                !__atomic_compare_exchange_n(work, &seq_consumer, seq_cursor, false, memorder, memorder))
+            {
+                // Another worker claimed them first, try again
+                lost = true;
+                continue;
+            }
+
+            Array r = Array::New(env);
+            ConsumeGetBuffers<Array, DisruptorBuffer>(env, seq_consumer, seq_cursor, r);
+            UpdatePending(seq_consumer, seq_cursor);
+            if (checksums)
+            {
+                // May be on a worker thread
+                __atomic_add_fetch(&checksum_errors,
+                                   ChecksumMismatches(seq_consumer, seq_cursor),
+                                   memorder);
+            }
+            start = seq_consumer;
+            if (adaptive)
+            {
+                consume_ns = NowNs();
+            }
+            TRACE(consume_return, this, seq_consumer, seq_cursor);
+            return r;
+        }
+
+        TRACE(consume_wait, this, seq_cursor);
+    }
+    while (lost || (retry && !Expired(deadline) && !Exhausted()));
+
+    start = 0;
+    TRACE(consume_return, this, 0, 0);
+    // ConsumeCommit() above already set pending_set_cursor to 0
+    return Array::New(env);
+}
+
+Napi::Value Disruptor::ConsumeNewSync(const Napi::CallbackInfo& info)
+{
+    CheckNoHandler(info.Env());
+    sequence_t start;
+    sequence_t max = sequence_max;
+
+    if ((info.Length() > 0) && !info[0].IsUndefined())
+    {
+        max = info[0].As<Napi::Number>().Uint32Value();
+        if (max == 0)
+        {
+            max = sequence_max;
+        }
+    }
+
+    bool retry = spin;
+    if ((info.Length() > 1) && !info[1].IsUndefined())
+    {
+        retry = info[1].ToBoolean();
+    }
+
+    return ConsumeNewSync<Napi::Array, SyncBuffer>(info.Env(), retry, start, max);
+}
+
+class ConsumeNewAsyncWorker :
+    public DisruptorAsyncWorker<AsyncArray<AsyncBuffer>, sequence_t>
+{
+public:
+    ConsumeNewAsyncWorker(Disruptor *disruptor,
+                          const Napi::Function& callback) :
+        DisruptorAsyncWorker<AsyncArray<AsyncBuffer>, sequence_t>(
+            disruptor, callback, consume_names)
+    {
+        arg1 = 0;
+    }
+
+protected:
+    void Execute() override
+    {
+        // Remember: don't access any V8 stuff in worker thread
+        TRACE(async_execute, disruptor, this);
+        result = disruptor->ConsumeNewSync<AsyncArray<AsyncBuffer>, AsyncBuffer>(Env(), false, arg1);
+        retry = (result.Length() == 0) && !disruptor->Exhausted();
+    }
+
+    void Retry() override
+    {
+        Requeue(new ConsumeNewAsyncWorker(disruptor, Callback().Value()));
+    }
+};
+
+void Disruptor::ConsumeNewAsync(const Napi::CallbackInfo& info)
+{
+    (new ConsumeNewAsyncWorker(this, GetCallback(info, 0)))->Queue();
+}
+
+Napi::Value Disruptor::ConsumeNew(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    CheckNoHandler(env);
+    sequence_t start;
+    Napi::Array r = ConsumeNewSync<Napi::Array, SyncBuffer>(
+        env, false, start);
+    const bool done = (r.Length() > 0) || !spin;
+
+    if (!HasCallback(info, 0))
+    {
+        auto deferred = Napi::Promise::Deferred::New(env);
+        if (done)
+        {
+            deferred.Resolve(Resolution(env, consume_names,
+            {
+                r,
+                Napi::Number::New(env, pending_seq_consumer)
+            }));
+        }
+        else
+        {
+            (new ConsumeNewAsyncWorker(this, GetCallback(info, 0)))->Queue(deferred);
+        }
+        return deferred.Promise();
+    }
+
+    if (done)
+    {
+        return r;
+    }
+
+    ConsumeNewAsync(info);
+    return info.Env().Undefined();
+}
+
+bool Disruptor::BatchReady(const sequence_t seq,
+                           const sequence_t threshold,
+                           uint64_t& wait_start)
+{
+    // Whether a consume would return slots after seq: there are new slots
+    // and either at least threshold of them or we've waited min_wait_ns
+    // since wait_start (0 = since now).
+    // Doesn't access any V8 stuff so can be called from worker threads.
+
+    if (!NewAfter(seq))
+    {
+        return false;
+    }
+
+    const sequence_t n = __atomic_load_n(cursor, memorder) -
+        (pool ? __atomic_load_n(work, memorder) : seq);
+    if (n >= threshold)
+    {
+        return true;
+    }
+
+    uint64_t now = NowNs();
+
+    if (wait_start == 0)
+    {
+        wait_start = now;
+    }
+
+    return now - wait_start >= min_wait_ns;
+}
+
+class ConsumeWaitAsyncWorker :
+    public DisruptorAsyncWorker<AsyncBoolean>
+{
+public:
+    ConsumeWaitAsyncWorker(Disruptor *disruptor,
+                           const Napi::Function& callback,
+                           sequence_t seq,
+                           sequence_t threshold,
+                           uint64_t wait_start,
+                           uint64_t epoch) :
+        DisruptorAsyncWorker<AsyncBoolean>(disruptor, callback),
+        seq(seq),
+        threshold(threshold),
+        wait_start(wait_start),
+        epoch(epoch)
+    {
+        // Wait regardless of spin and timeout
+        spin = true;
+        deadline = 0;
+    }
+
+protected:
+    void Execute() override
+    {
+        // Remember: don't access any V8 stuff in worker thread
+        TRACE(async_execute, disruptor, this);
+        bool stop = (disruptor->shm_buf == MAP_FAILED) ||
+                    (__atomic_load_n(&disruptor->wait_epoch, memorder) != epoch);
+        result = AsyncBoolean::New(Env(), !stop);
+        retry = !stop && !disruptor->BatchReady(seq, threshold, wait_start);
+    }
+
+    void Retry() override
+    {
+        Requeue(new ConsumeWaitAsyncWorker(
+            disruptor, Callback().Value(), seq, threshold, wait_start, epoch));
+    }
+
+private:
+    sequence_t seq;
+    sequence_t threshold;
+    uint64_t wait_start;
+    uint64_t epoch;
+};
+
+Napi::Value Disruptor::ConsumeWait(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    CheckNoHandler(env);
+    auto deferred = Napi::Promise::Deferred::New(env);
+
+    // Wait for slots after those pending, or after our consumer
+    sequence_t seq = pending_seq_cursor ?
+        pending_seq_cursor : __atomic_load_n(ptr_consumer, memorder);
+
+    // Wait as consumeNew would for min_batch slots, so callers don't spin
+    // while it returns nothing
+    const sequence_t threshold = min_wait_ns ?
+        std::min(min_batch, ConsumeLimit()) : 1;
+    uint64_t wait_start = wait_start_ns;
+
+    if ((shm_buf == MAP_FAILED) || BatchReady(seq, threshold, wait_start))
+    {
+        deferred.Resolve(Napi::Boolean::New(env, shm_buf != MAP_FAILED));
+    }
+    else
+    {
+        (new ConsumeWaitAsyncWorker(this, GetCallback(info, 0), seq,
+            threshold, wait_start,
+            __atomic_load_n(&wait_epoch, memorder)))->Queue(deferred);
+    }
+
+    return deferred.Promise();
+}
+
+void Disruptor::ConsumeWaitCancel(const Napi::CallbackInfo&)
+{
+    __atomic_add_fetch(&wait_epoch, 1, memorder);
+}
+
+Napi::Value Disruptor::ConsumeCommit(const Napi::CallbackInfo& info)
+{
+    CheckNoHandler(info.Env());
+    return Napi::Boolean::New(info.Env(), ConsumeCommit());
+}
+
+Napi::Value Disruptor::ConsumeCommitUpTo(const Napi::CallbackInfo& info)
+{
+    CheckNoHandler(info.Env());
+    sequence_t seq = info[0].As<Napi::Number>().Int64Value();
+
+    if (pending_seq_cursor ?
+            (seq > pending_seq_cursor) :
+            (seq > __atomic_load_n(ptr_consumer, memorder)))
+    {
+        throw Napi::RangeError::New(info.Env(), "sequence not consumed");
+    }
+
+    bool r = true;
+
+    if (pending_seq_cursor && (seq > pending_seq_consumer))
+    {
+        r = ConsumeCommitUpTo(seq);
+    }
+
+    return Napi::Boolean::New(info.Env(), r);
+}
+
+Napi::Value Disruptor::ConsumeRewind(const Napi::CallbackInfo& info)
+{
+    CheckNoHandler(info.Env());
+    if (pool)
+    {
+        throw Napi::Error::New(info.Env(), "can't rewind in pool mode");
+    }
+
+    sequence_t n = info[0].As<Napi::Number>().Int64Value();
+
+    // Forget about anything returned by the previous consume
+    pending_seq_cursor = 0;
+    to_seq = sequence_max;
+
+    sequence_t seq_orig = __atomic_load_n(ptr_consumer, memorder);
+    sequence_t seq_consumer = seq_orig;
+
+    while (true)
+    {
+        sequence_t seq_cursor = __atomic_load_n(cursor, memorder);
+        sequence_t seq_next = LoadNext();
+        sequence_t seq_start = seq_cursor - std::min(n, seq_cursor);
+
+        // Don't go back past slots which producers may have overwritten
+        if (seq_next > num_elements)
+        {
+            seq_start = std::max(seq_start, seq_next - num_elements);
+        }
+
+        // or whose memory has been given back (they'd read as zeros)
+        seq_start = std::max(seq_start, ReclaimedEnd());
+
+        // Slots the slowest active consumer hasn't read yet can't be
+        // overwritten, so limit ourselves to those
+        sequence_t seq_slowest = sequence_max;
+        for (uint32_t i = 0; !overwrite && (i < num_consumers); ++i)
+        {
+            if (i != consumer)
+            {
+                seq_slowest = std::min(seq_slowest,
+                                       __atomic_load_n(&consumers[i], memorder));
+            }
+        }
+
+        if (seq_slowest != sequence_max)
+        {
+            seq_start = std::max(seq_start, std::min(seq_slowest, seq_cursor));
+        }
+
+        // Never skip slots we haven't read yet, unless producers have
+        // overwritten them already (overwrite mode)
+        if ((seq_orig != sequence_max) && (seq_next - seq_orig <= num_elements))
+        {
+            seq_start = std::min(seq_start, seq_orig);
+        }
+
+        // Publish where we've moved back to before checking it's still
+        // valid. Once producers can see it they won't claim the slots
+        // (except in overwrite mode), but they may have claimed them since
+        // we looked at next. Without another active consumer holding them
+        // back, nothing else stops that.
+        if (!__atomic_compare_exchange_n(ptr_consumer,
+                                         &seq_consumer,
+                                         seq_start,
+                                         false,
+                                         memorder,
+                                         memorder))
+        {
+            //LCOV_EXCL_START
+            throw Napi::Error::New(info.Env(), "Consumer ID is in use");
+            //LCOV_EXCL_STOP
+        }
+
+        // A reclaim pass may have started before it could see us, so let
+        // it finish before checking what it gave back
+        WaitReclaimed(seq_cursor + num_elements - 1);
+
+        if ((LoadNext() - seq_start <= num_elements) &&
+            (seq_start >= ReclaimedEnd()))
+        {
+            if (overwrite && (seq_orig != sequence_max) && (seq_start > seq_orig))
+            {
+                // Count overwritten slots we skipped as dropped
+                __atomic_add_fetch(&dropped[consumer], seq_start - seq_orig, memorder);
+            }
+
+            return Napi::Number::New(info.Env(), seq_start);
+        }
+
+        // Try again from where we are now
+        seq_consumer = seq_start;
+    }
+}
+
+Napi::Value Disruptor::ReadAt(const Napi::CallbackInfo& info)
+{
+    // Return elements [seq, seq + n) if they've been committed and
+    // haven't been overwritten since
+
+    sequence_t seq = info[0].As<Napi::Number>().Int64Value();
+    uint32_t n = info.Length() >= 2 ? info[1].As<Napi::Number>() : 1U;
+    sequence_t seq_end = seq + n;
+
+    Napi::Array r = Napi::Array::New(info.Env());
+
+    if ((n > 0) &&
+        (n <= num_elements) &&
+        (seq_end <= __atomic_load_n(cursor, memorder)) &&
+        (LoadNext() - seq <= num_elements) &&
+        (seq >= ReclaimedEnd()) &&
+        (!overwrite || Stamped(seq, seq_end)))
+    {
+        ConsumeGetBuffers<Napi::Array, SyncBuffer>(info.Env(), seq, seq_end, r);
+    }
+
+    return r;
+}
+
+Napi::Value Disruptor::VerifyChecksums(const Napi::CallbackInfo& info)
+{
+    // Check [seq, seq + n), defaulting to the slots last returned
+    Napi::Env env = info.Env();
+
+    if (!checksums)
+    {
+        throw Napi::Error::New(env, "checksums not enabled");
+    }
+
+    sequence_t seq = pending_seq_consumer;
+    sequence_t seq_end = pending_seq_cursor ? pending_seq_cursor : seq;
+
+    if ((info.Length() > 0) && !info[0].IsUndefined())
+    {
+        seq = info[0].As<Napi::Number>().Int64Value();
+        uint32_t n = info.Length() >= 2 ? info[1].As<Napi::Number>() : 1U;
+        seq_end = seq + n;
+
+        if ((n > num_elements) ||
+            (seq_end > __atomic_load_n(cursor, memorder)) ||
+            (LoadNext() - seq > num_elements) ||
+            (seq < ReclaimedEnd()))
+        {
+            throw Napi::RangeError::New(env, "slots not available");
+        }
+    }
+
+    return Napi::Number::New(env, ChecksumMismatches(seq, seq_end));
+}
+
+Napi::Value Disruptor::ConsumeCheck(const Napi::CallbackInfo& info)
+{
+    sequence_t n = 0;
+
+    if (overwrite && pending_seq_cursor)
+    {
+        // Make sure the data was read before we check the stamps again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        for (sequence_t seq = pending_seq_consumer; seq < pending_seq_cursor; ++seq)
+        {
+            if (!Stamped(seq, seq + 1))
+            {
+                ++n;
+            }
+        }
+    }
+
+    return Napi::Number::New(info.Env(), n);
+}
+
+sequence_t Disruptor::SkipOverwritten(sequence_t seq_consumer, sequence_t seq_cursor)
+{
+    // In overwrite mode, producers don't wait for us so skip over slots
+    // they've overwritten (or are overwriting) since we last read.
+
+    sequence_t seq = seq_consumer;
+
+    if (seq_cursor - seq > num_elements)
+    {
+        seq = seq_cursor - num_elements;
+    }
+
+    while ((seq < seq_cursor) && !Stamped(seq, seq + 1))
+    {
+        ++seq;
+    }
+
+    if (seq != seq_consumer)
+    {
+        sequence_t expected = seq_consumer;
+        if (!__atomic_compare_exchange_n(ptr_consumer,
+                                         &expected,
+                                         seq,
+                                         false,
+                                         memorder,
+                                         memorder))
+        {
+            // Someone else is using our consumer ID
+            return seq_consumer; //LCOV_EXCL_LINE
+        }
+
+        __atomic_add_fetch(&dropped[consumer], seq - seq_consumer, memorder);
+    }
+
+    return seq;
+}
+
+bool Disruptor::Stamped(sequence_t seq, sequence_t seq_end)
+{
+    // Slots are stamped just after the cursor moves past them, so a
+    // committed slot still marked as claimed has only been overwritten if
+    // producers have claimed it again since. A slow producer's stamp can
+    // land after the slot has been claimed again, so don't trust a
+    // matching stamp once that's happened either.
+    for (; seq < seq_end; ++seq)
+    {
+        sequence_t stamp = __atomic_load_n(&stamps[seq % num_elements], memorder);
+        if (((stamp != seq + 1) && (stamp != sequence_max)) ||
+            (LoadNext() - seq > num_elements))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Disruptor::StampClaimed(sequence_t seq_next, sequence_t seq_next_end)
+{
+    // Tell consumers the slots are being overwritten
+    if (overwrite)
+    {
+        for (sequence_t seq = seq_next; seq <= seq_next_end; ++seq)
+        {
+            __atomic_store_n(&stamps[seq % num_elements], sequence_max, memorder);
+        }
+    }
+}
+
+void Disruptor::StampCommitted(sequence_t seq_next, sequence_t seq_next_end)
+{
+    // Tell consumers which sequence the slots now hold. Other producers
+    // may have claimed them again since we moved the cursor, in which case
+    // leave them marked as claimed. Their commit replaces any stale stamp
+    // we do manage to store.
+    if (overwrite)
+    {
+        for (sequence_t seq = seq_next; seq <= seq_next_end; ++seq)
+        {
+            sequence_t *stamp = &stamps[seq % num_elements];
+            sequence_t expected = __atomic_load_n(stamp, memorder);
+            while (((expected == sequence_max) || (expected < seq + 1)) &&
+                   (LoadNext() - seq <= num_elements) &&
+                   !__atomic_compare_exchange_n(stamp,
+                                                &expected,
+                                                seq + 1,
+                                                false,
+                                                memorder,
+                                                memorder))
+            {
+            }
+        }
+    }
+}
+
+uint32_t Disruptor::SlotCrc32c(const sequence_t pos)
+{
+    // CRC32C of a slot's bytes followed by its value in each column
+    uint32_t crc = Crc32cUpdate(~0U, elements + pos * element_size, element_size);
+
+    for (const auto& column : columns)
+    {
+        crc = Crc32cUpdate(crc,
+                           static_cast<uint8_t*>(shm_buf) + column.offset + pos * column.size,
+                           column.size);
+    }
+
+    return ~crc;
+}
+
+void Disruptor::ChecksumCommitted(sequence_t seq_next, sequence_t seq_next_end)
+{
+    if (checksums)
+    {
+        for (sequence_t seq = seq_next; seq <= seq_next_end; ++seq)
+        {
+            const sequence_t pos = seq % num_elements;
+            checksums[pos] = SlotCrc32c(pos);
+        }
+    }
+}
+
+sequence_t Disruptor::ChecksumMismatches(sequence_t seq, sequence_t seq_end)
+{
+    sequence_t n = 0;
+
+    for (; seq < seq_end; ++seq)
+    {
+        const sequence_t pos = seq % num_elements;
+        if (checksums[pos] != SlotCrc32c(pos))
+        {
+            ++n;
+        }
+    }
+
+    return n;
+}
+
+void Disruptor::UpdatePending(sequence_t seq_consumer, sequence_t seq_cursor)
+{
+    pending_seq_consumer = seq_consumer;
+    pending_seq_cursor = seq_cursor;
+}
+
+sequence_t Disruptor::ConsumeLimit()
+{
+    if (!adaptive || (element_ns == 0))
+    {
+        return max_batch;
+    }
+
+    // As many slots as we can process in the target latency
+    sequence_t limit = std::max(
+        static_cast<sequence_t>(1),
+        static_cast<sequence_t>(target_latency_ns / element_ns));
+
+    return std::min(limit, max_batch);
+}
+
+bool Disruptor::ConsumeWaited(const sequence_t n, const sequence_t limit)
+{
+    // Wait a while for at least min_batch slots, unless there's a whole
+    // batch (limit) available anyway
+    if ((n >= std::min(min_batch, limit)) || (min_wait_ns == 0))
+    {
+        wait_start_ns = 0;
+        return true;
+    }
+
+    uint64_t now = NowNs();
+
+    if (wait_start_ns == 0)
+    {
+        wait_start_ns = now;
+    }
+
+    if (now - wait_start_ns >= min_wait_ns)
+    {
+        wait_start_ns = 0;
+        return true;
+    }
+
+    return false;
+}
+
+sequence_t Disruptor::RecordSlots(const RecordHeader& header)
+{
+    // Number of slots a compressed record takes up, or 0 if its header is
+    // corrupt. Check the size before anyone allocates it: it must be one
+    // the stored bytes can decompress to and no bigger than we allow.
+    const sequence_t n = std::max(static_cast<sequence_t>(1),
+        static_cast<sequence_t>((sizeof(header) + header.stored +
+                                 element_size - 1) / element_size));
+    return ((n <= num_elements) &&
+            (header.stored <= header.size) &&
+            ((header.stored == header.size) ||
+             (header.size <= lz4::MaxDecompressed(header.stored))) &&
+            ((max_record_size == 0) || (header.size <= max_record_size))) ? n : 0;
+}
+
+sequence_t Disruptor::RecordsEnd(sequence_t seq,
+                                 const sequence_t seq_limit,
+                                 const sequence_t seq_cursor)
+{
+    // Move seq_limit on to the end of the compressed record it splits.
+    // Records are committed whole, so seq_cursor never splits one. If a
+    // header is corrupt we can't tell where records start, so go up to
+    // seq_cursor.
+    // Doesn't access any V8 stuff so can be called from worker threads.
+
+    while (seq < seq_limit)
+    {
+        if ((seq_cursor - seq) * element_size < sizeof(RecordHeader))
+        {
+            return seq_cursor;
+        }
+
+        RecordHeader header;
+        CopyFromSlots(seq, 0, sizeof(header), &header);
+
+        const sequence_t n = RecordSlots(header);
+        if ((n == 0) || (seq + n > seq_cursor))
+        {
+            return seq_cursor;
+        }
+
+        seq += n;
+    }
+
+    return seq;
+}
+
+bool Disruptor::ConsumeCommit()
+{
+    return pending_seq_cursor ? ConsumeCommitUpTo(pending_seq_cursor) : true;
+}
+
+bool Disruptor::ConsumeCommitUpTo(const sequence_t seq)
+{
+    // Commit [pending_seq_consumer, seq), seq <= pending_seq_cursor
+
+    uint64_t now = 0;
+    if (adaptive)
+    {
+        // Update average time to process a slot
+        now = NowNs();
+        double sample = static_cast<double>(now - consume_ns) /
+                        (seq - pending_seq_consumer);
+        element_ns = (element_ns == 0) ? sample :
+                     element_ns + (sample - element_ns) / 8;
+    }
+
+    sequence_t expected = pending_seq_consumer;
+    bool r = __atomic_compare_exchange_n(ptr_consumer,
+                                         &expected,
+                                         seq,
+                                         false,
+                                         memorder,
+                                         memorder);
+    TRACE(consume_commit, this, pending_seq_consumer, r);
+
+    if (r && (seq < pending_seq_cursor))
+    {
+        // The rest is still pending
+        pending_seq_consumer = seq;
+        consume_ns = now;
+    }
+    else
+    {
+        pending_seq_cursor = 0;
+    }
+
+    return r;
+}
+
+template<typename DisruptorBuffer>
+typename DisruptorBuffer::Buffer Disruptor::ProduceClaimSync(const Napi::Env& env,
+                                                             const bool retry,
+                                                             sequence_t& out_next,
+                                                             sequence_t& out_next_end,
+                                                             bool& out_all_ignored)
+{
+    const uint64_t deadline = retry ? Deadline() : 0;
+    bool all_ignored;
+
+    TRACE(claim_entry, this, 1);
+
+    do
+    {
+        sequence_t seq_next = __atomic_load_n(next, memorder);
+
+        if (seq_next & sealed_bit)
+        {
+            // Ring has been resized, producers should use the new generation
+            all_ignored = false;
+            break;
+        }
+
+        // Slots being reclaimed count as full
+        bool can_claim = seq_next < ReclaimLimit();
+        all_ignored = true;
+
+        for (uint32_t i = 0; i < num_gating; ++i)
+        {
+            sequence_t seq_consumer = __atomic_load_n(&gating[i], memorder);
+
+            if (seq_consumer != sequence_max)
+            {
+                all_ignored = false;
+
+                if ((seq_next - seq_consumer) >= num_elements)
+                {
+                    can_claim = false;
+                    break;
+                }
+            }
+        }
+        
+        if (all_ignored)
+        {
+            break;
+        }
+
+        if (can_claim &&
+            __atomic_compare_exchange_n(next, &seq_next, seq_next + 1, false, memorder, memorder))
+        {
+            WaitReclaimed(seq_next);
+            StampClaimed(seq_next, seq_next);
+            sequence_t start = seq_next % num_elements;
+            auto r = DisruptorBuffer::New(env, this, start, start + 1);
+            UpdateSeqNext(seq_next, seq_next, all_ignored);
+            out_next = seq_next;
+            out_next_end = seq_next;
+            out_all_ignored = all_ignored;
+            TRACE(claim_return, this, seq_next, out_next_end);
+            return r;
+        }
+
+        TRACE(claim_wait, this, seq_next);
+    }
+    while (retry && !Expired(deadline));
+
+    UpdateSeqNext(1, 0, all_ignored);
+    out_next = 1;
+    out_next_end = 0;
+    out_all_ignored = all_ignored;
+    TRACE(claim_return, this, out_next, out_next_end);
+    return DisruptorBuffer::New(env, this, 0, 0);
+}
+
+Napi::Value Disruptor::ProduceClaimSync(const Napi::CallbackInfo& info)
+{
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    return ProduceClaimSync<SyncBuffer>(info.Env(), spin, seq_next, seq_next_end, all_ignored);
+}
+
+class ProduceClaimAsyncWorker :
+    public DisruptorAsyncWorker<AsyncBuffer, sequence_t, sequence_t, bool>
+{
+public:
+    ProduceClaimAsyncWorker(Disruptor *disruptor,
+                            const Napi::Function& callback) :
+        DisruptorAsyncWorker<AsyncBuffer, sequence_t, sequence_t, bool>(
+            disruptor, callback, claim_names)
+    {
+        arg1 = 1;
+        arg2 = 0;
+        arg3 = false;
+    }
+
+protected:
+    void Execute() override
+    {
+        // Remember: don't access any V8 stuff in worker thread
+        TRACE(async_execute, disruptor, this);
+        result = disruptor->ProduceClaimSync<AsyncBuffer>(
+            Env(), false, arg1, arg2, arg3);
+        retry = (result.Length() == 0) && !disruptor->Sealed();
+    }
+
+    void Retry() override
+    {
+        Requeue(new ProduceClaimAsyncWorker(disruptor, Callback().Value()));
+    }
+};
+
+void Disruptor::ProduceClaimAsync(const Napi::CallbackInfo& info)
+{
+    (new ProduceClaimAsyncWorker(this, GetCallback(info, 0)))->Queue();
+}
+
+Napi::Value Disruptor::ProduceClaim(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    Napi::Buffer<uint8_t> r = ProduceClaimSync<SyncBuffer>(
+        env, false, seq_next, seq_next_end, all_ignored);
+    const bool done = (r.Length() > 0) || all_ignored || !spin;
+
+    if (!HasCallback(info, 0))
+    {
+        auto deferred = Napi::Promise::Deferred::New(env);
+        if (done)
+        {
+            deferred.Resolve(Resolution(env, claim_names,
+            {
+                r,
+                ToValue(env, seq_next),
+                ToValue(env, seq_next_end),
+                ToValue(env, all_ignored)
+            }));
+        }
+        else
+        {
+            (new ProduceClaimAsyncWorker(this, GetCallback(info, 0)))->Queue(deferred);
+        }
+        return deferred.Promise();
+    }
+
+    if (done)
+    {
+        return r;
+    }
+
+    ProduceClaimAsync(info);
+    return info.Env().Undefined();
+}
+
+template<typename Array, typename DisruptorBuffer>
+void Disruptor::ProduceGetBuffers(const Napi::Env& env,
+                                  const sequence_t seq_next,
+                                  const sequence_t seq_next_end,
+                                  const bool all_ignored,
+                                  Array& r)
+{
+    sequence_t pos_next = seq_next % num_elements;
+    sequence_t pos_next_end = seq_next_end % num_elements;
+
+    if (pos_next_end < pos_next)
+    {
+        r.Set(0U, DisruptorBuffer::New(env, this, pos_next, num_elements));
+        r.Set(1U, DisruptorBuffer::New(env, this, 0, pos_next_end + 1));
+    }
+    else
+    {
+        r.Set(0U, DisruptorBuffer::New(env, this, pos_next, pos_next_end + 1));
+    }
+
+    UpdateSeqNext(seq_next, seq_next_end, all_ignored);
+}
+
+template<typename Array, typename DisruptorBuffer>
+Array Disruptor::ProduceClaimManySync(const Napi::Env& env,
+                                      const uint32_t n,
+                                      const bool retry,
+                                      sequence_t& out_next,
+                                      sequence_t& out_next_end,
+                                      bool& out_all_ignored)
+{
+    const uint64_t deadline = retry ? Deadline() : 0;
+    bool all_ignored;
+
+    TRACE(claim_entry, this, n);
+
+    do
+    {
+        sequence_t seq_next = __atomic_load_n(next, memorder);
+
+        if (seq_next & sealed_bit)
+        {
+            // Ring has been resized, producers should use the new generation
+            all_ignored = false;
+            break;
+        }
+        sequence_t seq_next_end = seq_next + std::min(n, num_elements) - 1;
+
+        // Slots being reclaimed count as full
+        bool can_claim = seq_next_end < ReclaimLimit();
+        all_ignored = true;
+
+        for (uint32_t i = 0; i < num_gating; ++i)
+        {
+            sequence_t seq_consumer = __atomic_load_n(&gating[i], memorder);
+
+            if (seq_consumer != sequence_max)
+            {
+                all_ignored = false;                
+
+                if ((seq_next_end - seq_consumer) >= num_elements)
+                {
+                    can_claim = false;
+                    break;
+                }
+            }
+        }
+
+        if (all_ignored)
+        {
+            break;
+        }
+
+        if (can_claim &&
+            __atomic_compare_exchange_n(next, &seq_next, seq_next_end + 1, false, memorder, memorder))
+        {
+            WaitReclaimed(seq_next_end);
+            StampClaimed(seq_next, seq_next_end);
+            Array r = Array::New(env);
+            ProduceGetBuffers<Array, DisruptorBuffer>(env, seq_next, seq_next_end, all_ignored, r);
+            out_next = seq_next;
+            out_next_end = seq_next_end;
+            out_all_ignored = all_ignored;
+            TRACE(claim_return, this, seq_next, out_next_end);
+            return r;
+        }
+
+        TRACE(claim_wait, this, seq_next);
+    }
+    while (retry && !Expired(deadline));
+
+    UpdateSeqNext(1, 0, all_ignored);
+    out_next = 1;
+    out_next_end = 0;
+    out_all_ignored = all_ignored;
+    TRACE(claim_return, this, out_next, out_next_end);
+    return Array::New(env);
+}
+
+Napi::Value Disruptor::ProduceClaimManySync(const Napi::CallbackInfo& info)
+{
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    return ProduceClaimManySync<Napi::Array, SyncBuffer>(
+        info.Env(), info[0].As<Napi::Number>(), spin, seq_next, seq_next_end, all_ignored);
+}
+
+class ProduceClaimManyAsyncWorker :
+    public DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
+                                sequence_t,
+                                sequence_t,
+                                bool>
+{
+public:
+    ProduceClaimManyAsyncWorker(Disruptor *disruptor,
+                                const Napi::Function& callback,
+                                uint32_t n) :
+        DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
+                             sequence_t,
+                             sequence_t,
+                             bool>(
+            disruptor, callback, claim_many_names),
+        n(n)
+    {
+        arg1 = 1;
+        arg2 = 0;
+        arg3 = false;
+    }
+
+protected:
+    void Execute() override
+    {
+        // Remember: don't access any V8 stuff in worker thread
+        TRACE(async_execute, disruptor, this);
+        result = disruptor->ProduceClaimManySync<AsyncArray<AsyncBuffer>, AsyncBuffer>(
+            Env(), n, false, arg1, arg2, arg3);
+        retry = (result.Length() == 0) && !disruptor->Sealed();
+    }
+
+    void Retry() override
+    {
+        Requeue(new ProduceClaimManyAsyncWorker(disruptor, Callback().Value(), n));
+    }
+
+private:
+    uint32_t n;
+};
+
+void Disruptor::ProduceClaimManyAsync(const Napi::CallbackInfo& info,
+                                      uint32_t n)
+{
+    (new ProduceClaimManyAsyncWorker(this, GetCallback(info, 1), n))->Queue();
+}
+
+void Disruptor::ProduceClaimManyAsync(const Napi::CallbackInfo& info)
+{
+    ProduceClaimManyAsync(info, info[0].As<Napi::Number>());
+}
+
+Napi::Value Disruptor::ProduceClaimMany(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    uint32_t n = info[0].As<Napi::Number>();
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    Napi::Array r = ProduceClaimManySync<Napi::Array, SyncBuffer>(
+        env, n, false, seq_next, seq_next_end, all_ignored);
+    const bool done = (r.Length() > 0) || all_ignored || !spin;
+
+    if (!HasCallback(info, 1))
+    {
+        auto deferred = Napi::Promise::Deferred::New(env);
+        if (done)
+        {
+            deferred.Resolve(Resolution(env, claim_many_names,
+            {
+                r,
+                ToValue(env, seq_next),
+                ToValue(env, seq_next_end),
+                ToValue(env, all_ignored)
+            }));
+        }
+        else
+        {
+            (new ProduceClaimManyAsyncWorker(this, GetCallback(info, 1), n))->Queue(deferred);
+        }
+        return deferred.Promise();
+    }
+
+    if (done)
+    {
+        return r;
+    }
+
+    ProduceClaimManyAsync(info, n);
+    return info.Env().Undefined();
+}
+
+template<typename Array, typename DisruptorBuffer>
+Array Disruptor::ProduceClaimAvailSync(const Napi::Env& env,
+                                       const uint32_t max,
+                                       const bool retry,
+                                       sequence_t& out_next,
+                                       sequence_t& out_next_end,
+                                       bool& out_all_ignored)
+{
+    const uint64_t deadline = retry ? Deadline() : 0;
+    bool all_ignored;
+
+    TRACE(claim_entry, this, max);
+
+    do
+    {
+        sequence_t seq_next = __atomic_load_n(next, memorder);
+
+        if (seq_next & sealed_bit)
+        {
+            // Ring has been resized, producers should use the new generation
+            all_ignored = false;
+            break;
+        }
+        auto n = std::min(max, num_elements);
+        all_ignored = true;
+
+        // Slots being reclaimed count as full
+        const sequence_t seq_limit = ReclaimLimit();
+        n = std::min(static_cast<sequence_t>(n),
+                     (seq_limit > seq_next) ? seq_limit - seq_next : 0);
+
+        for (uint32_t i = 0; i < num_gating; ++i)
+        {
+            sequence_t seq_consumer = __atomic_load_n(&gating[i], memorder);
+            if (seq_consumer != sequence_max)
+            {
+                all_ignored = false;
+                n = std::min(static_cast<sequence_t>(n), num_elements - (seq_next - seq_consumer));
+            }
+        }
+
+        if (all_ignored)
+        {
+            break;
+        }
+
+        if ((n > 0) &&
+            __atomic_compare_exchange_n(next, &seq_next, seq_next + n, false, memorder, memorder))
+        {
+            WaitReclaimed(seq_next + n - 1);
+            StampClaimed(seq_next, seq_next + n - 1);
+            Array r = Array::New(env);
+            ProduceGetBuffers<Array, DisruptorBuffer>(env, seq_next, seq_next + n - 1, all_ignored, r);
+            out_next = seq_next;
+            out_next_end = seq_next + n - 1;
+            out_all_ignored = all_ignored;
+            TRACE(claim_return, this, seq_next, out_next_end);
+            return r;
+        }
+
+        TRACE(claim_wait, this, seq_next);
+    }
+    while (retry && !Expired(deadline));
+
+    UpdateSeqNext(1, 0, all_ignored);
+    out_next = 1;
+    out_next_end = 0;
+    out_all_ignored = all_ignored;
+    TRACE(claim_return, this, out_next, out_next_end);
+    return Array::New(env);
+}
+
+Napi::Value Disruptor::ProduceClaimAvailSync(const Napi::CallbackInfo& info)
+{
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    return ProduceClaimAvailSync<Napi::Array, SyncBuffer>(
+        info.Env(), info[0].As<Napi::Number>(), spin, seq_next, seq_next_end, all_ignored);
+}
+
+class ProduceClaimAvailAsyncWorker :
+    public DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
+                                sequence_t,
+                                sequence_t,
+                                bool>
+{
+public:
+    ProduceClaimAvailAsyncWorker(Disruptor *disruptor,
+                                 const Napi::Function& callback,
+                                 uint32_t max) :
+        DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
+                             sequence_t,
+                             sequence_t,
+                             bool>(
+            disruptor, callback, claim_many_names),
+        max(max)
+    {
+        arg1 = 1;
+        arg2 = 0;
+        arg3 = false;
+    }
+
+protected:
+    void Execute() override
+    {
+        // Remember: don't access any V8 stuff in worker thread
+        TRACE(async_execute, disruptor, this);
+        result = disruptor->ProduceClaimAvailSync<AsyncArray<AsyncBuffer>, AsyncBuffer>(
+            Env(), max, false, arg1, arg2, arg3);
+        retry = (result.Length() == 0) && !disruptor->Sealed();
+    }
+
+    void Retry() override
+    {
+        Requeue(new ProduceClaimAvailAsyncWorker(disruptor, Callback().Value(), max));
+    }
+
+private:
+    uint32_t max;
+};
+
+void Disruptor::ProduceClaimAvailAsync(const Napi::CallbackInfo& info,
+                                       uint32_t max)
+{
+    (new ProduceClaimAvailAsyncWorker(this, GetCallback(info, 1), max))->Queue();
+}
+
+
+void Disruptor::ProduceClaimAvailAsync(const Napi::CallbackInfo& info)
+{
+    ProduceClaimAvailAsync(info, info[0].As<Napi::Number>());
+}
+
+Napi::Value Disruptor::ProduceClaimAvail(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    uint32_t max = info[0].As<Napi::Number>();
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    Napi::Array r = ProduceClaimAvailSync<Napi::Array, SyncBuffer>(
+        env, max, false, seq_next, seq_next_end, all_ignored);
+    const bool done = (r.Length() > 0) || all_ignored || !spin;
+
+    if (!HasCallback(info, 1))
+    {
+        auto deferred = Napi::Promise::Deferred::New(env);
+        if (done)
+        {
+            deferred.Resolve(Resolution(env, claim_many_names,
+            {
+                r,
+                ToValue(env, seq_next),
+                ToValue(env, seq_next_end),
+                ToValue(env, all_ignored)
+            }));
+        }
+        else
+        {
+            (new ProduceClaimAvailAsyncWorker(this, GetCallback(info, 1), max))->Queue(deferred);
+        }
+        return deferred.Promise();
+    }
+
+    if (done)
+    {
+        return r;
+    }
+
+    ProduceClaimAvailAsync(info, max);
+    return info.Env().Undefined();
+}
+
+Napi::Value Disruptor::ProduceRecover(const Napi::CallbackInfo& info)
+{
+    sequence_t seq_next = info[0].As<Napi::Number>().Int64Value();
+    sequence_t seq_next_end = info[1].As<Napi::Number>().Int64Value();
+
+    Napi::Array r = Napi::Array::New(info.Env());
+
+    if ((seq_next <= seq_next_end) &&
+        (__atomic_load_n(cursor, memorder) <= seq_next) &&
+        (LoadNext() > seq_next_end))
+    {
+        ProduceGetBuffers<Napi::Array, SyncBuffer>(
+            info.Env(), seq_next, seq_next_end, false, r);
+    }
+
+    return r;
+}
+
+uint32_t Disruptor::ProduceSize(const size_t length)
+{
+    // Each value takes up at least one slot
+    return std::max(static_cast<size_t>(1),
+                    (length + element_size - 1) / element_size);
+}
+
+void Disruptor::ProduceCopy(const sequence_t seq,
+                            const uint8_t *data,
+                            const size_t length,
+                            const uint32_t n)
+{
+    // Copy into n slots starting at seq, wrapping around the end of the
+    // elements and zero filling the rest of the last slot
+    const size_t elements_size = num_elements * element_size;
+    size_t pos = (seq % num_elements) * element_size;
+    size_t size = n * element_size;
+    size_t copied = 0;
+
+    while (copied < size)
+    {
+        size_t chunk = std::min(size - copied, elements_size - pos);
+        size_t from_data = copied < length ?
+            std::min(chunk, length - copied) : 0;
+
+        memcpy(elements + pos, data + copied, from_data);
+        memset(elements + pos + from_data, 0, chunk - from_data);
+
+        copied += chunk;
+        pos = 0;
+    }
+}
+
+bool Disruptor::ProduceCopySync(const Napi::Env& env,
+                                const std::vector<ProduceData>& data,
+                                const uint64_t n)
+{
+    if (n > num_elements)
+    {
+        throw Napi::RangeError::New(env, "data too large");
+    }
+
+    // Our slots would be committed after a claim we haven't committed yet,
+    // so we'd wait for ourselves. Claiming would also lose track of it.
+    if (ClaimPending())
+    {
+        throw Napi::Error::New(env, "claim pending");
+    }
+
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    ProduceClaimManySync<NullArray, NullBuffer>(
+        env, static_cast<uint32_t>(n), spin, seq_next, seq_next_end, all_ignored);
+
+    if (seq_next > seq_next_end)
+    {
+        return false;
+    }
+
+    sequence_t seq = seq_next;
+    for (const auto& d : data)
+    {
+        uint32_t size = ProduceSize(d.length);
+        ProduceCopy(seq, d.Data(), d.length, size);
+        seq += size;
+    }
+
+    // The slots are ours so we must commit them, even if we have to wait
+    // for other producers to commit first
+    const uint64_t deadline = Deadline();
+    while (!ProduceCommitSync<AsyncBoolean>(env, seq_next, seq_next_end, false))
+    {
+        if (Expired(deadline))
+        {
+            // Leave them for produceCommit
+            throw Napi::Error::New(env, "timed out waiting for other producers to commit");
+        }
+    }
+
+    // Nothing left for produceCommit to do
+    UpdateSeqNext(1, 0, all_ignored);
+    return true;
+}
+
+Napi::Value Disruptor::ProduceSync(const Napi::CallbackInfo& info)
+{
+    CheckElementSize(info.Env());
+    std::vector<ProduceData> data;
+    data.emplace_back(info[0]);
+    return Napi::Boolean::New(
+        info.Env(),
+        ProduceCopySync(info.Env(), data, ProduceSize(data[0].length)));
+}
+
+int Disruptor::GetIOVecs(const sequence_t seq,
+                         const size_t offset,
+                         const size_t length,
+                         iovec *iov)
+{
+    // Bytes [offset, offset + length) of the slots from seq,
+    // which may wrap around the end of the ring
+
+    const size_t size = static_cast<size_t>(num_elements) * element_size;
+    const size_t start = ((seq % num_elements) * element_size + offset) % size;
+    const size_t first = std::min(length, size - start);
+
+    iov[0].iov_base = elements + start;
+    iov[0].iov_len = first;
+
+    if (first == length)
+    {
+        return 1;
+    }
+
+    iov[1].iov_base = elements;
+    iov[1].iov_len = length - first;
+    return 2;
+}
+
+void Disruptor::CopyFromSlots(const sequence_t seq,
+                              const size_t offset,
+                              const size_t length,
+                              void *dst)
+{
+    iovec iov[2];
+    const int iovcnt = GetIOVecs(seq, offset, length, iov);
+    uint8_t *p = static_cast<uint8_t*>(dst);
+
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        memcpy(p, iov[i].iov_base, iov[i].iov_len);
+        p += iov[i].iov_len;
+    }
+}
+
+ssize_t Disruptor::TransferAll(const int fd,
+                               const sequence_t seq,
+                               size_t& offset,
+                               const size_t end,
+                               const bool write)
+{
+    // Read or write bytes [offset, end) of the slots from seq, moving offset
+    // on. Never waits if fd is non-blocking, so this can be called on the
+    // JS thread. Returns the result of the last read or write: 0 means end
+    // of file and < 0 an error (see errno, EAGAIN if fd would block).
+
+    ssize_t r = 1;
+
+    while (offset < end)
+    {
+        iovec iov[2];
+        int iovcnt = GetIOVecs(seq, offset, end - offset, iov);
+        r = write ? writev(fd, iov, iovcnt) : readv(fd, iov, iovcnt);
+
+        if (r > 0)
+        {
+            offset += r;
+        }
+        else if ((r == 0) || (errno != EINTR))
+        {
+            break;
+        }
+    }
+
+    return r;
+}
+
+Napi::Value Disruptor::ProduceFromSync(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    CheckElementSize(env);
+    int fd = info[0].As<Napi::Number>();
+    uint32_t max = num_elements;
+
+    if ((info.Length() > 1) && !info[1].IsUndefined())
+    {
+        max = info[1].As<Napi::Number>().Uint32Value();
+        if (max == 0)
+        {
+            max = num_elements;
+        }
+    }
+
+    // The caller has to finish a partly read element left from last time
+    if (ClaimPending())
+    {
+        throw Napi::Error::New(env, "claim pending");
+    }
+
+    sequence_t seq_next, seq_next_end;
+    bool all_ignored;
+    ProduceClaimAvailSync<NullArray, NullBuffer>(
+        env, max, spin, seq_next, seq_next_end, all_ignored);
+
+    if (seq_next > seq_next_end)
+    {
+        return Napi::Number::New(env, -1);
+    }
+
+    const sequence_t n = seq_next_end - seq_next + 1;
+    const size_t length = n * element_size;
+
+    iovec iov[2];
+    int iovcnt = GetIOVecs(seq_next, 0, length, iov);
+    ssize_t r;
+    do
+    {
+        r = readv(fd, iov, iovcnt);
+    }
+    while ((r < 0) && (errno == EINTR));
+    const int errnum = errno;
+
+    size_t bytes = (r > 0) ? r : 0;
+    sequence_t filled = bytes / element_size;
+    sequence_t held = filled;
+
+    if (bytes % element_size)
+    {
+        // Try to finish a partly read element, without waiting for data
+        held = filled + 1;
+        size_t end = bytes;
+        const ssize_t r2 = TransferAll(fd, seq_next, end,
+            (filled + 1) * element_size, false);
+        if (end == (filled + 1) * element_size)
+        {
+            ++filled;
+        }
+        else if (r2 == 0)
+        {
+            // End of file, so zero the rest of it
+            iovcnt = GetIOVecs(seq_next, end, (filled + 1) * element_size - end, iov);
+            for (int i = 0; i < iovcnt; ++i)
+            {
+                memset(iov[i].iov_base, 0, iov[i].iov_len);
+            }
+            ++filled;
+        }
+        bytes = end;
+    }
+
+    // Give back slots we didn't read anything into. We can't if another
+    // producer has claimed slots after them.
+    sequence_t seq_keep = seq_next_end + 1;
+    if (held < n)
+    {
+        sequence_t expected = __atomic_load_n(next, memorder);
+        while ((expected & ~sealed_bit) == seq_keep)
+        {
+            if (__atomic_compare_exchange_n(next,
+                                            &expected,
+                                            (seq_next + held) | (expected & sealed_bit),
+                                            false,
+                                            memorder,
+                                            memorder))
+            {
+                seq_keep = seq_next + held;
+                break;
+            }
+        }
+    }
+
+    if (filled > 0)
+    {
+        UpdateSeqNext(seq_next, seq_keep - 1, all_ignored);
+
+        // The slots are ours so we must commit them, even if we have to
+        // wait for other producers to commit first
+        const uint64_t deadline = Deadline();
+        while (!ProduceCommitSync<AsyncBoolean>(env, seq_next, seq_next + filled - 1, false))
+        {
+            if (Expired(deadline))
+            {
+                // Leave them for produceCommit
+                throw Napi::Error::New(env, "timed out waiting for other producers to commit");
+            }
+        }
+    }
+
+    // Anything we couldn't fill or give back stays claimed, for the caller
+    // to fill and commit (see produceRecover). Never publish it unfilled.
+    if (seq_next + filled < seq_keep)
+    {
+        UpdateSeqNext(seq_next + filled, seq_keep - 1, all_ignored);
+    }
+    else
+    {
+        UpdateSeqNext(1, 0, all_ignored);
+    }
+
+    if (r < 0)
+    {
+        if ((errnum == EAGAIN) || (errnum == EWOULDBLOCK))
+        {
+            return Napi::Number::New(env, -1);
+        }
+
+        errno = errnum;
+        ThrowErrnoError(info, "Failed to read");
+    }
+
+    return Napi::Number::New(env, bytes);
+}
+
+Napi::Value Disruptor::ConsumeToSync(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    CheckNoHandler(env);
+    CheckElementSize(env);
+    int fd = info[0].As<Napi::Number>();
+    sequence_t max = sequence_max;
+
+    if ((info.Length() > 1) && !info[1].IsUndefined())
+    {
+        max = info[1].As<Napi::Number>().Uint32Value();
+        if (max == 0)
+        {
+            max = sequence_max;
+        }
     }
 
-    if (Release() < 0)
+    sequence_t start;
+    size_t offset = 0;
+
+    if (pool && pending_seq_cursor && (pending_seq_consumer == to_seq))
     {
-        ThrowErrnoError(info, "Failed to unmap shared memory"); //LCOV_EXCL_LINE
+        // Other workers won't see the slots we claimed last time, so
+        // finish writing them first
+        start = to_seq;
+        offset = to_offset;
+    }
+    else
+    {
+        ConsumeNewSync<NullArray, NullBuffer>(env, spin, start, max);
+
+        if (!pending_seq_cursor)
+        {
+            return Napi::Number::New(env, 0);
+        }
+
+        if (start == to_seq)
+        {
+            // Don't write the start of an element twice
+            offset = to_offset;
+        }
+    }
+
+    const size_t length = (pending_seq_cursor - start) * element_size;
+
+    size_t bytes = offset;
+    const ssize_t r = TransferAll(fd, start, bytes, length, true);
+    const int errnum = errno;
+
+    const sequence_t written = bytes / element_size;
+    if (bytes == length)
+    {
+        ConsumeCommit();
+        to_seq = sequence_max;
+        to_offset = 0;
+    }
+    else
+    {
+        if (written > 0)
+        {
+            ConsumeCommitUpTo(start + written);
+        }
+
+        // Carry on from here next time
+        to_seq = start + written;
+        to_offset = bytes % element_size;
+
+        if (!pool)
+        {
+            // Return the rest next time
+            pending_seq_cursor = 0;
+        }
+    }
+
+    if ((r < 0) && (errnum != EAGAIN) && (errnum != EWOULDBLOCK))
+    {
+        errno = errnum;
+        ThrowErrnoError(info, "Failed to write");
     }
+
+    return Napi::Number::New(env, bytes - offset);
 }
 
-#include <iostream>
+Napi::Value Disruptor::ProduceCompressSync(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+    CheckElementSize(env);
+    ProduceData data(info[0]);
 
-template<typename Array, typename DisruptorBuffer>
-Array Disruptor::ConsumeNewSync(const Napi::Env& env,
-                                const bool retry,
-                                sequence_t &start)
+    if (data.length > std::numeric_limits<uint32_t>::max())
+    {
+        throw Napi::RangeError::New(env, "data too large"); //LCOV_EXCL_LINE
+    }
+
+    if (max_record_size && (data.length > max_record_size))
+    {
+        throw Napi::RangeError::New(env, "data too large");
+    }
+
+    RecordHeader header;
+    std::string record(sizeof(header) + lz4::Bound(data.length), '\0');
+    uint8_t *stored = reinterpret_cast<uint8_t*>(&record[sizeof(header)]);
+
+    header.size = static_cast<uint32_t>(data.length);
+    header.stored = static_cast<uint32_t>(
+        lz4::Compress(data.Data(), data.length, stored));
+
+    if (header.stored >= header.size)
+    {
+        // Doesn't compress so store it as it is
+        if (data.length > 0)
+        {
+            memcpy(stored, data.Data(), data.length);
+        }
+        header.stored = header.size;
+    }
+
+    memcpy(&record[0], &header, sizeof(header));
+    record.resize(sizeof(header) + header.stored);
+
+    std::vector<ProduceData> records;
+    records.emplace_back(std::move(record));
+    return Napi::Boolean::New(env, ProduceCopySync(
+        env, records, ProduceSize(records[0].length)));
+}
+
+Napi::Value Disruptor::ConsumeDecompressSync(const Napi::CallbackInfo& info)
 {
-    // Return all elements [&consumers[consumer], cursor)
+    Napi::Env env = info.Env();
+    CheckNoHandler(env);
+    CheckElementSize(env);
+    sequence_t max = sequence_max;
 
-    // Commit previous consume
-    ConsumeCommit();
+    if ((info.Length() > 0) && !info[0].IsUndefined())
+    {
+        max = info[0].As<Napi::Number>().Uint32Value();
+        if (max == 0)
+        {
+            max = sequence_max;
+        }
+    }
 
-    do
+    // Read whole records, so in pool mode no other worker gets part of one
+    sequence_t start;
+    ConsumeNewSync<NullArray, NullBuffer>(env, spin, start, max, true);
+
+    Napi::Array r = Napi::Array::New(env);
+    if (!pending_seq_cursor)
     {
-        sequence_t seq_consumer = __atomic_load_n(ptr_consumer, memorder);
-        sequence_t seq_cursor = __atomic_load_n(cursor, memorder);
-        sequence_t pos_consumer = seq_consumer % num_elements;
-        sequence_t pos_cursor = seq_cursor % num_elements;
+        return r;
+    }
 
-        if (pos_cursor > pos_consumer)
+    const sequence_t end = pending_seq_cursor;
+    sequence_t seq = start;
+    std::vector<uint8_t> wrapped;
+    uint32_t i = 0;
+
+    while (seq < end)
+    {
+        RecordHeader header;
+        sequence_t n = 0;
+        if ((end - seq) * element_size >= sizeof(header))
         {
-            Array r = Array::New(env);
-            r.Set(0U, DisruptorBuffer::New(env, this, pos_consumer, pos_cursor));
-            UpdatePending(seq_consumer, seq_cursor);
-            start = seq_consumer;
-            return r;
+            CopyFromSlots(seq, 0, sizeof(header), &header);
+            n = RecordSlots(header);
         }
+        bool ok = (n > 0) && (seq + n <= end);
 
-        if (seq_cursor != seq_consumer)
+        Napi::Buffer<uint8_t> buf;
+        if (ok)
         {
-            Array r = Array::New(env);
-            r.Set(0U, DisruptorBuffer::New(env, this, pos_consumer, num_elements));
-            if (pos_cursor > 0)
+            // Records which wrap around the end of the ring are copied out
+            iovec iov[2];
+            const uint8_t *stored;
+            if (GetIOVecs(seq, sizeof(header), header.stored, iov) == 1)
             {
-                r.Set(1U, DisruptorBuffer::New(env, this, 0, pos_cursor));
+                stored = static_cast<const uint8_t*>(iov[0].iov_base);
             }
-            UpdatePending(seq_consumer, seq_cursor);
-            start = seq_consumer;
-            return r;
+            else
+            {
+                wrapped.resize(header.stored);
+                CopyFromSlots(seq, sizeof(header), header.stored, wrapped.data());
+                stored = wrapped.data();
+            }
+
+            buf = Napi::Buffer<uint8_t>::New(env, header.size);
+            if (header.stored == header.size)
+            {
+                if (header.size > 0)
+                {
+                    memcpy(buf.Data(), stored, header.size);
+                }
+            }
+            else
+            {
+                ok = lz4::Decompress(stored, header.stored, buf.Data(), header.size);
+            }
+        }
+
+        if (!ok)
+        {
+            // We can't tell where the next record starts so skip the rest
+            // of the batch, but keep the records we've already decoded
+            ++corrupt_records;
+            break;
         }
+
+        r.Set(i++, buf);
+        seq += n;
     }
-    while (retry);
 
-    start = 0;
-    // ConsumeCommit() above already set pending_set_cursor to 0
-    return Array::New(env);
+    // The data has been copied so the slots can be reused straight away
+    ConsumeCommit();
+
+    return r;
 }
 
-Napi::Value Disruptor::ConsumeNewSync(const Napi::CallbackInfo& info)
+AggregateField Disruptor::GetAggregateField(const Napi::Env& env,
+                                            const Napi::Value& field)
 {
-    sequence_t start;
-    return ConsumeNewSync<Napi::Array, SyncBuffer>(info.Env(), spin, start);
+    if (field.IsString())
+    {
+        const std::string name = field.ToString();
+        for (const auto& column : columns)
+        {
+            if (column.name == name)
+            {
+                return {
+                    static_cast<uint8_t*>(shm_buf) + column.offset,
+                    column.size,
+                    column.type
+                };
+            }
+        }
+
+        throw Napi::TypeError::New(env, "unknown column: " + name);
+    }
+
+    if (!field.IsObject())
+    {
+        throw Napi::TypeError::New(env, "field must be a column name or an object");
+    }
+
+    const Napi::Object f = field.As<Napi::Object>();
+    const uint32_t offset = GetUint32Option(f, "offset", 0);
+    const std::string type = f.Get("type").ToString();
+    const ColumnType* ct = FindColumnType(type);
+
+    if (!ct)
+    {
+        throw Napi::TypeError::New(env, "unknown field type: " + type);
+    }
+
+    if (offset + ct->size > element_size)
+    {
+        throw Napi::RangeError::New(env, "field out of range");
+    }
+
+    return { elements + offset, element_size, ct->type };
 }
 
-class ConsumeNewAsyncWorker :
-    public DisruptorAsyncWorker<AsyncArray<AsyncBuffer>, sequence_t>
+template<typename T>
+Napi::Value Disruptor::AggregateSync(const Napi::Env& env,
+                                     const AggregateField& field,
+                                     const Compare cmp,
+                                     const Napi::Value& value,
+                                     const bool consume,
+                                     const sequence_t max)
 {
-public:
-    ConsumeNewAsyncWorker(Disruptor *disruptor,
-                          const Napi::Function& callback) :
-        DisruptorAsyncWorker<AsyncArray<AsyncBuffer>, sequence_t>(
-            disruptor, callback)
+    const T x = (cmp == Compare::All) ? 0 : GetFilterValue<T>(env, value);
+
+    if (consume)
     {
-        arg1 = 0;
+        sequence_t start;
+        ConsumeNewSync<NullArray, NullBuffer>(env, spin, start, max);
     }
 
-protected:
-    void Execute() override
+    AggregateResult<T> r;
+    sequence_t n = 0;
+
+    if (pending_seq_cursor)
     {
-        // Remember: don't access any V8 stuff in worker thread
-        result = disruptor->ConsumeNewSync<AsyncArray<AsyncBuffer>, AsyncBuffer>(Env(), false, arg1);
-        retry = result.Length() == 0;
+        // Pending slots may wrap around the end of the ring
+        n = pending_seq_cursor - pending_seq_consumer;
+        const sequence_t pos = pending_seq_consumer % num_elements;
+        const sequence_t first = std::min(n, num_elements - pos);
+
+        AggregateRange<T>(field.base + pos * field.stride,
+                          first, field.stride, cmp, x, r);
+        AggregateRange<T>(field.base, n - first, field.stride, cmp, x, r);
     }
 
-    void Retry() override
+    const bool big = std::is_integral<T>::value && (sizeof(T) == 8);
+    Napi::Object result = Napi::Object::New(env);
+    result["elements"] = Napi::Number::New(env, n);
+    result["count"] = Napi::Number::New(env, r.count);
+    result["sum"] = AggregateValue(env, r.sum, big);
+
+    if (r.count > 0)
     {
-        (new ConsumeNewAsyncWorker(disruptor, Callback().Value()))->Queue();
+        result["min"] = AggregateValue(env, static_cast<SumType<T>>(r.min), big);
+        result["max"] = AggregateValue(env, static_cast<SumType<T>>(r.max), big);
+    }
+    else
+    {
+        result["min"] = env.Null();
+        result["max"] = env.Null();
     }
-};
 
-void Disruptor::ConsumeNewAsync(const Napi::CallbackInfo& info)
+    return result;
+}
+
+Napi::Value Disruptor::AggregateSync(const Napi::CallbackInfo& info,
+                                     const bool consume)
 {
-    (new ConsumeNewAsyncWorker(this, GetCallback(info, 0)))->Queue();
+    Napi::Env env = info.Env();
+    const AggregateField field = GetAggregateField(env, info[0]);
+    const Compare cmp = GetCompare(env, info[1]);
+    const Napi::Value value = (cmp == Compare::All) ?
+        env.Undefined() : info[1].As<Napi::Object>().Get("value");
+    sequence_t max = sequence_max;
+
+    if ((info.Length() > 2) && !info[2].IsUndefined())
+    {
+        max = info[2].As<Napi::Number>().Uint32Value();
+        if (max == 0)
+        {
+            max = sequence_max;
+        }
+    }
+
+    switch (field.type)
+    {
+        case napi_int8_array:
+            return AggregateSync<int8_t>(env, field, cmp, value, consume, max);
+        case napi_uint8_array:
+            return AggregateSync<uint8_t>(env, field, cmp, value, consume, max);
+        case napi_int16_array:
+            return AggregateSync<int16_t>(env, field, cmp, value, consume, max);
+        case napi_uint16_array:
+            return AggregateSync<uint16_t>(env, field, cmp, value, consume, max);
+        case napi_int32_array:
+            return AggregateSync<int32_t>(env, field, cmp, value, consume, max);
+        case napi_uint32_array:
+            return AggregateSync<uint32_t>(env, field, cmp, value, consume, max);
+        case napi_float32_array:
+            return AggregateSync<float>(env, field, cmp, value, consume, max);
+        case napi_float64_array:
+            return AggregateSync<double>(env, field, cmp, value, consume, max);
+        case napi_bigint64_array:
+            return AggregateSync<int64_t>(env, field, cmp, value, consume, max);
+        default:
+            return AggregateSync<uint64_t>(env, field, cmp, value, consume, max);
+    }
 }
 
-Napi::Value Disruptor::ConsumeNew(const Napi::CallbackInfo& info)
+void Disruptor::AttachHandler(const Napi::CallbackInfo& info)
 {
-    sequence_t start;
-    Napi::Array r = ConsumeNewSync<Napi::Array, SyncBuffer>(
-        info.Env(), false, start);
+    Napi::Env env = info.Env();
 
-    if ((r.Length() > 0) || !spin)
+    if (handler)
     {
-        return r;
+        throw Napi::Error::New(env, "handler already attached");
     }
 
-    ConsumeNewAsync(info);
-    return info.Env().Undefined();
+    const std::string path = info[0].As<Napi::String>();
+    const std::string symbol = ((info.Length() > 1) && info[1].IsString()) ?
+        info[1].As<Napi::String>() : std::string("on_batch");
+    const Napi::Object options = GetOptions(info, 2);
+    const uint64_t idle_ns = GetUint32Option(options, "idle", 100) * 1000ULL;
+
+    void *lib = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!lib)
+    {
+        throw Napi::Error::New(env, dlerror());
+    }
+
+    dlerror();
+    auto on_batch = reinterpret_cast<on_batch_t>(dlsym(lib, symbol.c_str()));
+    if (!on_batch)
+    {
+        const char *err = dlerror();
+        const std::string msg = err ? err : "handler not found: " + symbol; //LCOV_EXCL_LINE
+        dlclose(lib);
+        throw Napi::Error::New(env, msg);
+    }
+
+    handler.reset(new NativeHandler(this, lib, on_batch, idle_ns));
 }
 
-Napi::Value Disruptor::ConsumeCommit(const Napi::CallbackInfo& info)
+Napi::Value Disruptor::DetachHandler(const Napi::CallbackInfo& info)
 {
-    return Napi::Boolean::New(info.Env(), ConsumeCommit());
+    if (!handler)
+    {
+        return info.Env().Null();
+    }
+
+    handler->Stop();
+    Napi::Object stats = handler->Stats(info.Env());
+    handler.reset();
+    return stats;
 }
 
-void Disruptor::UpdatePending(sequence_t seq_consumer, sequence_t seq_cursor)
+Napi::Value Disruptor::GetHandlerStats(const Napi::CallbackInfo& info)
 {
-    pending_seq_consumer = seq_consumer;
-    pending_seq_cursor = seq_cursor;
+    return handler ? Napi::Value(handler->Stats(info.Env())) : info.Env().Null();
 }
 
-bool Disruptor::ConsumeCommit()
+Napi::Value Disruptor::SetForward(const Napi::CallbackInfo& info)
 {
-    bool r = true;
+    if (!forward)
+    {
+        throw Napi::Error::New(info.Env(), "not resizable");
+    }
 
-    if (pending_seq_cursor)
+    sequence_t generation = info[0].As<Napi::Number>().Int64Value();
+    sequence_t n = info[1].As<Napi::Number>().Uint32Value();
+
+    if ((generation == 0) || (generation > 0xffffffffULL) || (n == 0))
     {
-        sequence_t expected = pending_seq_consumer;
-        r = __atomic_compare_exchange_n(ptr_consumer,
-                                        &expected,
-                                        pending_seq_cursor,
-                                        false,
-                                        memorder,
-                                        memorder);
-        pending_seq_cursor = 0;
+        throw Napi::RangeError::New(info.Env(), "invalid generation or size");
     }
 
-    return r;
+    // Only one resizer can win. The generation and size are written
+    // together, before the ring is sealed, so everyone who sees the sealed
+    // bit sees both.
+    sequence_t expected = 0;
+    return Napi::Boolean::New(info.Env(), __atomic_compare_exchange_n(
+        forward, &expected, (generation << 32) | n, false, memorder, memorder));
 }
 
-template<typename DisruptorBuffer>
-typename DisruptorBuffer::Buffer Disruptor::ProduceClaimSync(const Napi::Env& env,
-                                                             const bool retry,
-                                                             sequence_t& out_next,
-                                                             sequence_t& out_next_end,
-                                                             bool& out_all_ignored)
+Napi::Value Disruptor::Seal(const Napi::CallbackInfo& info)
 {
-    bool all_ignored;
+    if (!forward || (__atomic_load_n(forward, memorder) == 0))
+    {
+        throw Napi::Error::New(info.Env(), "forward not set");
+    }
 
-    do
+    // Slots claimed before this are the last in this generation.
+    // Producers which lose a claim race see the sealed bit and move on.
+    sequence_t seq_next = __atomic_fetch_or(next, sealed_bit, memorder);
+    return Napi::Number::New(info.Env(), seq_next & ~sealed_bit);
+}
+
+Napi::Value Disruptor::GetForward(const Napi::CallbackInfo& info)
+{
+    if (!forward || !Sealed())
     {
-        sequence_t seq_next = __atomic_load_n(next, memorder);
+        return info.Env().Null();
+    }
 
-        bool can_claim = true;
-        all_ignored = true;
+    const sequence_t fwd = __atomic_load_n(forward, memorder);
+    Napi::Object r = Napi::Object::New(info.Env());
+    r["generation"] = Napi::Number::New(info.Env(), fwd >> 32);
+    r["numElements"] = Napi::Number::New(info.Env(), fwd & 0xffffffffULL);
+    r["boundary"] = Napi::Number::New(info.Env(), LoadNext());
+    return r;
+}
 
-        for (uint32_t i = 0; i < num_consumers; ++i)
-        {
-            sequence_t seq_consumer = __atomic_load_n(&consumers[i], memorder);
+Napi::Value Disruptor::GetDrained(const Napi::CallbackInfo& info)
+{
+    bool drained = Exhausted();
 
-            if (seq_consumer != sequence_max)
-            {
-                all_ignored = false;
+    for (uint32_t i = 0; drained && (i < num_consumers); ++i)
+    {
+        const sequence_t seq_consumer = __atomic_load_n(&consumers[i], memorder);
+        drained = (seq_consumer == sequence_max) || (seq_consumer >= LoadNext());
+    }
 
-                if ((seq_next - seq_consumer) >= num_elements)
-                {
-                    can_claim = false;
-                    break;
-                }
-            }
-        }
-        
-        if (all_ignored)
+    return Napi::Boolean::New(info.Env(), drained);
+}
+
+Napi::Value Disruptor::Unlink(const Napi::CallbackInfo& info)
+{
+    Napi::String shm_name = info[0].As<Napi::String>();
+
+    if (shm_unlink(shm_name.Utf8Value().c_str()) < 0)
+    {
+        if (errno == ENOENT)
         {
-            break;
+            // Someone else unlinked it
+            return Napi::Boolean::New(info.Env(), false);
         }
 
-        if (can_claim &&
-            __atomic_compare_exchange_n(next, &seq_next, seq_next + 1, false, memorder, memorder))
+        ThrowErrnoError(info, "Failed to unlink shared memory object"); //LCOV_EXCL_LINE
+    }
+
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+Napi::Value Disruptor::Aggregate(const Napi::CallbackInfo& info)
+{
+    return AggregateSync(info, false);
+}
+
+Napi::Value Disruptor::ConsumeAggregateSync(const Napi::CallbackInfo& info)
+{
+    CheckNoHandler(info.Env());
+    return AggregateSync(info, true);
+}
+
+Napi::Value Disruptor::ProduceManySync(const Napi::CallbackInfo& info)
+{
+    CheckElementSize(info.Env());
+    Napi::Array values = info[0].As<Napi::Array>();
+    uint32_t length = values.Length();
+    std::vector<ProduceData> data;
+    uint64_t n = 0;
+
+    data.reserve(length);
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        data.emplace_back(values.Get(i));
+        n += ProduceSize(data.back().length);
+    }
+
+    if (n == 0)
+    {
+        return Napi::Boolean::New(info.Env(), true);
+    }
+
+    return Napi::Boolean::New(info.Env(), ProduceCopySync(info.Env(), data, n));
+}
+
+template<typename Boolean>
+Boolean Disruptor::ProduceCommitSync(const Napi::Env& env,
+                                     sequence_t seq_next,
+                                     sequence_t seq_next_end,
+                                     const bool retry)
+{
+    TRACE(commit_entry, this, seq_next, seq_next_end);
+
+    if (seq_next <= seq_next_end)
+    {
+        ChecksumCommitted(seq_next, seq_next_end);
+
+        do
         {
-            sequence_t start = seq_next % num_elements;
-            auto r = DisruptorBuffer::New(env, this, start, start + 1);
-            UpdateSeqNext(seq_next, seq_next, all_ignored);
-            out_next = seq_next;
-            out_next_end = seq_next;
-            out_all_ignored = all_ignored;
-            return r;
+            sequence_t expected = seq_next;
+            if (__atomic_compare_exchange_n(cursor, &expected, seq_next_end + 1, false, memorder, memorder))
+            {
+                // Only once the cursor covers them, so a failed commit
+                // doesn't leave them looking committed
+                StampCommitted(seq_next, seq_next_end);
+                TRACE(commit_return, this, 1);
+                return Boolean::New(env, true);
+            }
+
+            TRACE(commit_wait, this, seq_next);
         }
+        while (retry);
     }
-    while (retry);
 
-    UpdateSeqNext(1, 0, all_ignored);
-    out_next = 1;
-    out_next_end = 0;
-    out_all_ignored = all_ignored;
-    return DisruptorBuffer::New(env, this, 0, 0);
+    TRACE(commit_return, this, 0);
+    return Boolean::New(env, false);
 }
 
-Napi::Value Disruptor::ProduceClaimSync(const Napi::CallbackInfo& info)
+void Disruptor::UpdateSeqNext(const sequence_t seq_next,
+                              const sequence_t seq_next_end,
+                              const bool all_ignored)
+{
+    pending_seq_next = seq_next;
+    pending_seq_next_end = seq_next_end;
+    all_consumers_ignoring = all_ignored;
+}
+
+uint32_t Disruptor::GetSeqNext(const Napi::CallbackInfo& info,
+                               sequence_t& seq_next,
+                               sequence_t& seq_next_end)
+{
+    if (info.Length() >= 2)
+    {
+        seq_next = info[0].As<Napi::Number>().Int64Value();
+        seq_next_end = info[1].As<Napi::Number>().Int64Value();
+        return 2;
+    }
+
+    seq_next = pending_seq_next;
+    seq_next_end = pending_seq_next_end;
+    return 0;
+}
+
+Napi::Value Disruptor::ProduceCommitSync(const Napi::CallbackInfo& info)
 {
     sequence_t seq_next, seq_next_end;
-    bool all_ignored;
-    return ProduceClaimSync<SyncBuffer>(info.Env(), spin, seq_next, seq_next_end, all_ignored);
+    GetSeqNext(info, seq_next, seq_next_end);
+    return ProduceCommitSync<Napi::Boolean>(info.Env(), seq_next, seq_next_end, spin);
 }
 
-class ProduceClaimAsyncWorker :
-    public DisruptorAsyncWorker<AsyncBuffer, sequence_t, sequence_t, bool>
+class ProduceCommitAsyncWorker :
+    public DisruptorAsyncWorker<AsyncBoolean>
 {
 public:
-    ProduceClaimAsyncWorker(Disruptor *disruptor,
-                            const Napi::Function& callback) :
-        DisruptorAsyncWorker<AsyncBuffer, sequence_t, sequence_t, bool>(
-            disruptor, callback)
+    ProduceCommitAsyncWorker(Disruptor *disruptor,
+                             const Napi::Function& callback,
+                             sequence_t seq_next,
+                             sequence_t seq_next_end) :
+        DisruptorAsyncWorker<AsyncBoolean>(disruptor, callback),
+        seq_next(seq_next),
+        seq_next_end(seq_next_end)
     {
-        arg1 = 1;
-        arg2 = 0;
-        arg3 = false;
+        // Claimed slots must be committed, so don't time out
+        deadline = 0;
     }
 
 protected:
     void Execute() override
     {
         // Remember: don't access any V8 stuff in worker thread
-        result = disruptor->ProduceClaimSync<AsyncBuffer>(
-            Env(), false, arg1, arg2, arg3);
-        retry = result.Length() == 0;
+        TRACE(async_execute, disruptor, this);
+        result = disruptor->ProduceCommitSync<AsyncBoolean>(Env(), seq_next, seq_next_end, false);
+        retry = !result;
     }
 
     void Retry() override
     {
-        (new ProduceClaimAsyncWorker(disruptor, Callback().Value()))->Queue();
+        Requeue(new ProduceCommitAsyncWorker(disruptor, Callback().Value(), seq_next, seq_next_end));
     }
+
+private:
+    sequence_t seq_next, seq_next_end;
 };
 
-void Disruptor::ProduceClaimAsync(const Napi::CallbackInfo& info)
+void Disruptor::ProduceCommitAsync(const Napi::CallbackInfo& info,
+                                   sequence_t seq_next,
+                                   sequence_t seq_next_end,
+                                   uint32_t cb_arg)
 {
-    (new ProduceClaimAsyncWorker(this, GetCallback(info, 0)))->Queue();
+    (new ProduceCommitAsyncWorker(
+        this, GetCallback(info, cb_arg), seq_next, seq_next_end))->Queue();
 }
 
-Napi::Value Disruptor::ProduceClaim(const Napi::CallbackInfo& info)
+void Disruptor::ProduceCommitAsync(const Napi::CallbackInfo& info)
 {
     sequence_t seq_next, seq_next_end;
-    bool all_ignored;
-    Napi::Buffer<uint8_t> r = ProduceClaimSync<SyncBuffer>(
-        info.Env(), false, seq_next, seq_next_end, all_ignored);
+    uint32_t cb_arg = GetSeqNext(info, seq_next, seq_next_end);
+    ProduceCommitAsync(info, seq_next, seq_next_end, cb_arg);
+}
+
+Napi::Value Disruptor::ProduceCommit(const Napi::CallbackInfo& info)
+{
+    sequence_t seq_next, seq_next_end;
+    uint32_t cb_arg = GetSeqNext(info, seq_next, seq_next_end);
+
+    Napi::Env env = info.Env();
+    Napi::Boolean r = ProduceCommitSync<Napi::Boolean>(env, seq_next, seq_next_end, false);
+    const bool done = r || !spin;
+
+    if (!HasCallback(info, cb_arg))
+    {
+        auto deferred = Napi::Promise::Deferred::New(env);
+        if (done)
+        {
+            deferred.Resolve(r);
+        }
+        else
+        {
+            (new ProduceCommitAsyncWorker(
+                this, GetCallback(info, cb_arg), seq_next, seq_next_end))->Queue(deferred);
+        }
+        return deferred.Promise();
+    }
 
-    if ((r.Length() > 0) || all_ignored || !spin)
+    if (done)
     {
         return r;
     }
 
-    ProduceClaimAsync(info);
+    ProduceCommitAsync(info, seq_next, seq_next_end, cb_arg);
     return info.Env().Undefined();
 }
 
-template<typename Array, typename DisruptorBuffer>
-void Disruptor::ProduceGetBuffers(const Napi::Env& env,
-                                  const sequence_t seq_next,
-                                  const sequence_t seq_next_end,
-                                  const bool all_ignored,
-                                  Array& r)
+Napi::Value Disruptor::GetConsumers(const Napi::CallbackInfo&)
 {
-    sequence_t pos_next = seq_next % num_elements;
-    sequence_t pos_next_end = seq_next_end % num_elements;
-
-    if (pos_next_end < pos_next)
-    {
-        r.Set(0U, DisruptorBuffer::New(env, this, pos_next, num_elements));
-        r.Set(1U, DisruptorBuffer::New(env, this, 0, pos_next_end + 1));
-    }
-    else
-    {
-        r.Set(0U, DisruptorBuffer::New(env, this, pos_next, pos_next_end + 1));
-    }
+    return consumers_buffer_ref.Value();
+}
 
-    UpdateSeqNext(seq_next, seq_next_end, all_ignored);
+Napi::Value Disruptor::GetCursor(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), __atomic_load_n(cursor, memorder));
 }
 
-template<typename Array, typename DisruptorBuffer>
-Array Disruptor::ProduceClaimManySync(const Napi::Env& env,
-                                      const uint32_t n,
-                                      const bool retry,
-                                      sequence_t& out_next,
-                                      sequence_t& out_next_end,
-                                      bool& out_all_ignored)
+Napi::Value Disruptor::GetNext(const Napi::CallbackInfo& info)
 {
-    bool all_ignored;
+    return Napi::Number::New(info.Env(), LoadNext());
+}
 
-    do
-    {
-        sequence_t seq_next = __atomic_load_n(next, memorder);
-        sequence_t seq_next_end = seq_next + std::min(n, num_elements) - 1;
+Napi::Value Disruptor::GetElements(const Napi::CallbackInfo&)
+{
+    return elements_buffer_ref.Value();
+}
 
-        bool can_claim = true;
-        all_ignored = true;
+Napi::Value Disruptor::GetSequences(const Napi::CallbackInfo&)
+{
+    return sequences_ref.Value();
+}
 
-        for (uint32_t i = 0; i < num_consumers; ++i)
-        {
-            sequence_t seq_consumer = __atomic_load_n(&consumers[i], memorder);
+Napi::Value Disruptor::GetConsumer(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), __atomic_load_n(ptr_consumer, memorder));
+}
 
-            if (seq_consumer != sequence_max)
-            {
-                all_ignored = false;                
+Napi::Value Disruptor::GetPendingSeqConsumer(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), pending_seq_consumer);
+}
 
-                if ((seq_next_end - seq_consumer) >= num_elements)
-                {
-                    can_claim = false;
-                    break;
-                }
-            }
-        }
+Napi::Value Disruptor::GetPendingSeqCursor(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), pending_seq_cursor);
+}
 
-        if (all_ignored)
-        {
-            break;
-        }
+Napi::Value Disruptor::GetPendingSeqNext(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), pending_seq_next);
+}
 
-        if (can_claim &&
-            __atomic_compare_exchange_n(next, &seq_next, seq_next_end + 1, false, memorder, memorder))
-        {
-            Array r = Array::New(env);
-            ProduceGetBuffers<Array, DisruptorBuffer>(env, seq_next, seq_next_end, all_ignored, r);
-            out_next = seq_next;
-            out_next_end = seq_next_end;
-            out_all_ignored = all_ignored;
-            return r;
-        }
-    }
-    while (retry);
+Napi::Value Disruptor::GetPendingSeqNextEnd(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), pending_seq_next_end);
+}
 
-    UpdateSeqNext(1, 0, all_ignored);
-    out_next = 1;
-    out_next_end = 0;
-    out_all_ignored = all_ignored;
-    return Array::New(env);
+Napi::Value Disruptor::GetAllConsumersIgnoring(const Napi::CallbackInfo& info)
+{
+    return Napi::Boolean::New(info.Env(), all_consumers_ignoring);
 }
 
-Napi::Value Disruptor::ProduceClaimManySync(const Napi::CallbackInfo& info)
+Napi::Value Disruptor::GetLag(const Napi::CallbackInfo& info)
 {
-    sequence_t seq_next, seq_next_end;
-    bool all_ignored;
-    return ProduceClaimManySync<Napi::Array, SyncBuffer>(
-        info.Env(), info[0].As<Napi::Number>(), spin, seq_next, seq_next_end, all_ignored);
+    return Napi::Number::New(info.Env(),
+        __atomic_load_n(cursor, memorder) -
+        __atomic_load_n(pool ? work : ptr_consumer, memorder));
 }
 
-class ProduceClaimManyAsyncWorker :
-    public DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
-                                sequence_t,
-                                sequence_t,
-                                bool>
+Napi::Value Disruptor::GetBatchLimit(const Napi::CallbackInfo& info)
 {
-public:
-    ProduceClaimManyAsyncWorker(Disruptor *disruptor,
-                                const Napi::Function& callback,
-                                uint32_t n) :
-        DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
-                             sequence_t,
-                             sequence_t,
-                             bool>(
-            disruptor, callback),
-        n(n)
-    {
-        arg1 = 1;
-        arg2 = 0;
-        arg3 = false;
-    }
+    sequence_t limit = ConsumeLimit();
 
-protected:
-    void Execute() override
+    if (limit == sequence_max)
     {
-        // Remember: don't access any V8 stuff in worker thread
-        result = disruptor->ProduceClaimManySync<AsyncArray<AsyncBuffer>, AsyncBuffer>(
-            Env(), n, false, arg1, arg2, arg3);
-        retry = result.Length() == 0;
+        return Napi::Number::New(info.Env(), std::numeric_limits<double>::infinity());
     }
 
-    void Retry() override
-    {
-        (new ProduceClaimManyAsyncWorker(disruptor, Callback().Value(), n))->Queue();
-    }
+    return Napi::Number::New(info.Env(), limit);
+}
 
-private:
-    uint32_t n;
-};
+Napi::Value Disruptor::GetDropped(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(),
+        overwrite ? __atomic_load_n(&dropped[consumer], memorder) : 0);
+}
 
-void Disruptor::ProduceClaimManyAsync(const Napi::CallbackInfo& info,
-                                      uint32_t n)
+Napi::Value Disruptor::GetElementSize(const Napi::CallbackInfo& info)
 {
-    (new ProduceClaimManyAsyncWorker(this, GetCallback(info, 1), n))->Queue();
+    return Napi::Number::New(info.Env(), element_size);
+}
+
+Napi::Value Disruptor::GetSpin(const Napi::CallbackInfo& info)
+{
+    return Napi::Boolean::New(info.Env(), spin);
 }
 
-void Disruptor::ProduceClaimManyAsync(const Napi::CallbackInfo& info)
+Napi::Value Disruptor::GetStatus(const Napi::CallbackInfo& info)
 {
-    ProduceClaimManyAsync(info, info[0].As<Napi::Number>());
+    return Napi::Number::New(info.Env(), __atomic_load_n(status, memorder));
 }
 
-Napi::Value Disruptor::ProduceClaimMany(const Napi::CallbackInfo& info)
+void Disruptor::SetStatus(const Napi::CallbackInfo&, const Napi::Value& value)
 {
-    uint32_t n = info[0].As<Napi::Number>();
-    sequence_t seq_next, seq_next_end;
-    bool all_ignored;
-    Napi::Array r = ProduceClaimManySync<Napi::Array, SyncBuffer>(
-        info.Env(), n, false, seq_next, seq_next_end, all_ignored);
+    __atomic_store_n(status, value.As<Napi::Number>(), memorder);
+}
 
-    if ((r.Length() > 0) || all_ignored || !spin)
-    {
-        return r;
-    }
+Napi::Value Disruptor::GetTimeout(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), timeout_ns / 1000);
+}
 
-    ProduceClaimManyAsync(info, n);
-    return info.Env().Undefined();
+void Disruptor::SetTimeout(const Napi::CallbackInfo&, const Napi::Value& value)
+{
+    timeout_ns = value.As<Napi::Number>().Uint32Value() * 1000ULL;
 }
 
-template<typename Array, typename DisruptorBuffer>
-Array Disruptor::ProduceClaimAvailSync(const Napi::Env& env,
-                                       const uint32_t max,
-                                       const bool retry,
-                                       sequence_t& out_next,
-                                       sequence_t& out_next_end,
-                                       bool& out_all_ignored)
+Napi::Value Disruptor::GetFill(const Napi::CallbackInfo& info)
 {
-    bool all_ignored;
+    sequence_t seq_next = LoadNext();
+    sequence_t fill = 0;
 
-    do
+    for (uint32_t i = 0; i < num_consumers; ++i)
     {
-        sequence_t seq_next = __atomic_load_n(next, memorder);
-        auto n = std::min(max, num_elements);
-        all_ignored = true;
+        sequence_t seq_consumer = __atomic_load_n(&consumers[i], memorder);
 
-        for (uint32_t i = 0; i < num_consumers; ++i)
+        if ((seq_consumer != sequence_max) && (seq_next > seq_consumer))
         {
-            sequence_t seq_consumer = __atomic_load_n(&consumers[i], memorder);
-            if (seq_consumer != sequence_max)
-            {
-                all_ignored = false;
-                n = std::min(static_cast<sequence_t>(n), num_elements - (seq_next - seq_consumer));
-            }
+            fill = std::max(fill, seq_next - seq_consumer);
         }
+    }
 
-        if (all_ignored)
-        {
-            break;
-        }
+    // In overwrite mode, producers can be more than a ring ahead
+    return Napi::Number::New(info.Env(),
+        std::min(fill, static_cast<sequence_t>(num_elements)));
+}
 
-        if ((n > 0) &&
-            __atomic_compare_exchange_n(next, &seq_next, seq_next + n, false, memorder, memorder))
-        {
-            Array r = Array::New(env);
-            ProduceGetBuffers<Array, DisruptorBuffer>(env, seq_next, seq_next + n - 1, all_ignored, r);
-            out_next = seq_next;
-            out_next_end = seq_next + n - 1;
-            out_all_ignored = all_ignored;
-            return r;
-        }
-    }
-    while (retry);
+Napi::Value Disruptor::GetColumns(const Napi::CallbackInfo&)
+{
+    return columns_ref.Value();
+}
 
-    UpdateSeqNext(1, 0, all_ignored);
-    out_next = 1;
-    out_next_end = 0;
-    out_all_ignored = all_ignored;
-    return Array::New(env);
+Napi::Value Disruptor::GetChecksumErrors(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), __atomic_load_n(&checksum_errors, memorder));
 }
 
-Napi::Value Disruptor::ProduceClaimAvailSync(const Napi::CallbackInfo& info)
+Napi::Value Disruptor::GetCorruptRecords(const Napi::CallbackInfo& info)
 {
-    sequence_t seq_next, seq_next_end;
-    bool all_ignored;
-    return ProduceClaimAvailSync<Napi::Array, SyncBuffer>(
-        info.Env(), info[0].As<Napi::Number>(), spin, seq_next, seq_next_end, all_ignored);
+    return Napi::Number::New(info.Env(), corrupt_records);
 }
 
-class ProduceClaimAvailAsyncWorker :
-    public DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
-                                sequence_t,
-                                sequence_t,
-                                bool>
+Napi::Value Disruptor::GetReclaimed(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), reclaimer ? reclaimer->Bytes() : 0);
+}
+
+Napi::Object Disruptor::Initialize(Napi::Env env, Napi::Object exports)
 {
-public:
-    ProduceClaimAvailAsyncWorker(Disruptor *disruptor,
-                                 const Napi::Function& callback,
-                                 uint32_t max) :
-        DisruptorAsyncWorker<AsyncArray<AsyncBuffer>,
-                             sequence_t,
-                             sequence_t,
-                             bool>(
-            disruptor, callback),
-        max(max)
     {
-        arg1 = 1;
-        arg2 = 0;
-        arg3 = false;
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        if (!buffers) {
+            buffers = new std::unordered_set<uint8_t*>();
+        }
     }
 
-protected:
-    void Execute() override
     {
-        // Remember: don't access any V8 stuff in worker thread
-        result = disruptor->ProduceClaimAvailSync<AsyncArray<AsyncBuffer>, AsyncBuffer>(
-            Env(), max, false, arg1, arg2, arg3);
-        retry = result.Length() == 0;
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        if (!mappings) {
+            mappings = new std::unordered_map<std::string, std::weak_ptr<SharedMapping>>();
+        }
     }
 
-    void Retry() override
+    exports.Set("Disruptor", DefineClass(env, "Disruptor",
     {
-        (new ProduceClaimAvailAsyncWorker(disruptor, Callback().Value(), max))->Queue();
-    }
+        InstanceMethod<&Disruptor::ProduceClaim>("produceClaim"),
+        InstanceMethod<&Disruptor::ProduceClaimSync>("produceClaimSync"),
+        InstanceMethod<&Disruptor::ProduceClaimMany>("produceClaimMany"),
+        InstanceMethod<&Disruptor::ProduceClaimManySync>("produceClaimManySync"),
+        InstanceMethod<&Disruptor::ProduceClaimAvail>("produceClaimAvail"),
+        InstanceMethod<&Disruptor::ProduceClaimAvailSync>("produceClaimAvailSync"),
+        InstanceMethod<&Disruptor::ProduceCommit>("produceCommit"),
+        InstanceMethod<&Disruptor::ProduceCommitSync>("produceCommitSync"),
+        InstanceMethod<&Disruptor::ProduceSync>("produceSync"),
+        InstanceMethod<&Disruptor::ProduceManySync>("produceManySync"),
+        InstanceMethod<&Disruptor::ProduceFromSync>("produceFromSync"),
+        InstanceMethod<&Disruptor::ConsumeToSync>("consumeToSync"),
+        InstanceMethod<&Disruptor::ProduceCompressSync>("produceCompressSync"),
+        InstanceMethod<&Disruptor::ConsumeDecompressSync>("consumeDecompressSync"),
+        InstanceMethod<&Disruptor::Aggregate>("aggregate"),
+        InstanceMethod<&Disruptor::ConsumeAggregateSync>("consumeAggregateSync"),
+        InstanceMethod<&Disruptor::AttachHandler>("attachHandler"),
+        InstanceMethod<&Disruptor::DetachHandler>("detachHandler"),
+        InstanceMethod<&Disruptor::SetForward>("setForward"),
+        InstanceMethod<&Disruptor::Seal>("seal"),
+        InstanceMethod<&Disruptor::ProduceRecover>("produceRecover"),
+        InstanceMethod<&Disruptor::ConsumeNew>("consumeNew"),
+        InstanceMethod<&Disruptor::ConsumeNewSync>("consumeNewSync"),
+        InstanceMethod<&Disruptor::ConsumeWait>("consumeWait"),
+        InstanceMethod<&Disruptor::ConsumeWaitCancel>("consumeWaitCancel"),
+        InstanceMethod<&Disruptor::ConsumeCommit>("consumeCommit"),
+        InstanceMethod<&Disruptor::ConsumeCommitUpTo>("consumeCommitUpTo"),
+        InstanceMethod<&Disruptor::ConsumeRewind>("consumeRewind"),
+        InstanceMethod<&Disruptor::ReadAt>("readAt"),
+        InstanceMethod<&Disruptor::ConsumeCheck>("consumeCheck"),
+        InstanceMethod<&Disruptor::VerifyChecksums>("verifyChecksums"),
+        InstanceMethod<&Disruptor::Release>("release"),
+        InstanceAccessor<&Disruptor::GetPendingSeqConsumer>("prevConsumeStart"),
+        InstanceAccessor<&Disruptor::GetPendingSeqNext>("prevClaimStart"),
+        InstanceAccessor<&Disruptor::GetPendingSeqNextEnd>("prevClaimEnd"),
+        InstanceAccessor<&Disruptor::GetAllConsumersIgnoring>("allConsumersIgnoring"),
+        InstanceAccessor<&Disruptor::GetDropped>("dropped"),
+        InstanceAccessor<&Disruptor::GetLag>("lag"),
+        InstanceAccessor<&Disruptor::GetBatchLimit>("batchLimit"),
+        InstanceAccessor<&Disruptor::GetElementSize>("elementSize"),
+        InstanceAccessor<&Disruptor::GetSpin>("spin"),
+        InstanceAccessor<&Disruptor::GetStatus, &Disruptor::SetStatus>("status"),
+        InstanceAccessor<&Disruptor::GetTimeout, &Disruptor::SetTimeout>("timeout"),
+        InstanceAccessor<&Disruptor::GetFill>("fill"),
+        InstanceAccessor<&Disruptor::GetColumns>("columns"),
+        InstanceAccessor<&Disruptor::GetChecksumErrors>("checksumErrors"),
+        InstanceAccessor<&Disruptor::GetCorruptRecords>("corruptRecords"),
+        InstanceAccessor<&Disruptor::GetReclaimed>("reclaimed"),
+        InstanceAccessor<&Disruptor::GetHandlerStats>("handlerStats"),
+        InstanceAccessor<&Disruptor::GetForward>("forward"),
+        InstanceAccessor<&Disruptor::GetDrained>("drained"),
+        StaticMethod<&Disruptor::Unlink>("unlink"),
+
+        // For testing only
+        InstanceAccessor<&Disruptor::GetConsumers>("consumers"),
+        InstanceAccessor<&Disruptor::GetCursor>("cursor"),
+        InstanceAccessor<&Disruptor::GetNext>("next"),
+        InstanceAccessor<&Disruptor::GetElements>("elements"),
+        InstanceAccessor<&Disruptor::GetSequences>("sequences"),
+        InstanceAccessor<&Disruptor::GetConsumer>("consumer"),
+        InstanceAccessor<&Disruptor::GetPendingSeqCursor>("prevConsumeNext"),
+        InstanceMethod<&Disruptor::ConsumeNewAsync>("consumeNewAsync"),
+        InstanceMethod<&Disruptor::ProduceClaimAsync>("produceClaimAsync"),
+        InstanceMethod<&Disruptor::ProduceClaimManyAsync>("produceClaimManyAsync"),
+        InstanceMethod<&Disruptor::ProduceClaimAvailAsync>("produceClaimAvailAsync"),
+        InstanceMethod<&Disruptor::ProduceCommitAsync>("produceCommitAsync")
+    }));
+
+    return exports;
+}
+
+class SnapshotTable : public Napi::ObjectWrap<SnapshotTable>
+{
+public:
+    SnapshotTable(const Napi::CallbackInfo& info);
+    ~SnapshotTable();
+
+    static Napi::Object Initialize(Napi::Env env, Napi::Object exports);
+
+    // Unmap the shared memory. Don't access it again from this SnapshotTable!
+    void Release(const Napi::CallbackInfo& info);
+
+    // Replace the value for a key
+    Napi::Value Write(const Napi::CallbackInfo& info);
+
+    // Get a consistent copy of the value for a key
+    Napi::Value Read(const Napi::CallbackInfo& info);
+
+    // Get the version of the value for a key
+    Napi::Value Version(const Napi::CallbackInfo& info);
+
+    // Get number of keys
+    Napi::Value GetNumKeys(const Napi::CallbackInfo& info);
+
+    // Get size of each value in bytes
+    Napi::Value GetValueSize(const Napi::CallbackInfo& info);
 
 private:
-    uint32_t max;
+    int Release();
+
+    sequence_t* GetSlot(const Napi::CallbackInfo& info);
+
+    uint32_t num_keys;
+    uint32_t value_size;
+    uint32_t retries;     // most times to retry a read (0 = no limit)
+
+    size_t slot_size;
+    size_t shm_size;
+    void* shm_buf;
 };
 
-void Disruptor::ProduceClaimAvailAsync(const Napi::CallbackInfo& info,
-                                       uint32_t max)
+SnapshotTable::SnapshotTable(const Napi::CallbackInfo& info) :
+    Napi::ObjectWrap<SnapshotTable>(info),
+    shm_buf(MAP_FAILED)
 {
-    (new ProduceClaimAvailAsyncWorker(this, GetCallback(info, 1), max))->Queue();
-}
+    // Arguments
+    Napi::String shm_name = info[0].As<Napi::String>();
+    num_keys = info[1].As<Napi::Number>();
+    value_size = info[2].As<Napi::Number>();
+    bool init = info[3].As<Napi::Boolean>();
 
+    // Options
+    Napi::Object options = GetOptions(info, 4);
+    retries = GetUint32Option(options, "retries", 1000);
 
-void Disruptor::ProduceClaimAvailAsync(const Napi::CallbackInfo& info)
-{
-    ProduceClaimAvailAsync(info, info[0].As<Napi::Number>());
+    // Each slot has a version number followed by the value.
+    // The version is odd while the value is being written.
+    slot_size = sizeof(sequence_t) + Align(value_size);
+    shm_size = num_keys * slot_size;
+
+    shm_buf = MapSharedMemory(info, shm_name.Utf8Value(), shm_size, init);
 }
 
-Napi::Value Disruptor::ProduceClaimAvail(const Napi::CallbackInfo& info)
+SnapshotTable::~SnapshotTable()
 {
-    uint32_t max = info[0].As<Napi::Number>();
-    sequence_t seq_next, seq_next_end;
-    bool all_ignored;
-    Napi::Array r = ProduceClaimAvailSync<Napi::Array, SyncBuffer>(
-        info.Env(), max, false, seq_next, seq_next_end, all_ignored);
+    Release();
+}
 
-    if ((r.Length() > 0) || all_ignored || !spin)
+int SnapshotTable::Release()
+{
+    if (shm_buf != MAP_FAILED)
     {
-        return r;
+        int r = munmap(shm_buf, shm_size);
+
+        if (r < 0)
+        {
+            return r; //LCOV_EXCL_LINE
+        }
+
+        shm_buf = MAP_FAILED;
     }
 
-    ProduceClaimAvailAsync(info, max);
-    return info.Env().Undefined();
+    return 0;
 }
 
-Napi::Value Disruptor::ProduceRecover(const Napi::CallbackInfo& info)
+void SnapshotTable::Release(const Napi::CallbackInfo& info)
 {
-    sequence_t seq_next = info[0].As<Napi::Number>().Int64Value();
-    sequence_t seq_next_end = info[1].As<Napi::Number>().Int64Value();
+    if (Release() < 0)
+    {
+        ThrowErrnoError(info, "Failed to unmap shared memory"); //LCOV_EXCL_LINE
+    }
+}
 
-    Napi::Array r = Napi::Array::New(info.Env());
+sequence_t* SnapshotTable::GetSlot(const Napi::CallbackInfo& info)
+{
+    uint32_t key = info[0].As<Napi::Number>();
 
-    if ((seq_next <= seq_next_end) &&
-        (__atomic_load_n(cursor, memorder) <= seq_next) &&
-        (__atomic_load_n(next, memorder) > seq_next_end))
+    if (key >= num_keys)
     {
-        ProduceGetBuffers<Napi::Array, SyncBuffer>(
-            info.Env(), seq_next, seq_next_end, false, r);
+        throw Napi::RangeError::New(info.Env(), "key out of range");
     }
 
-    return r;
+    return reinterpret_cast<sequence_t*>(
+        static_cast<uint8_t*>(shm_buf) + key * slot_size);
 }
 
-template<typename Boolean>
-Boolean Disruptor::ProduceCommitSync(const Napi::Env& env,
-                                     sequence_t seq_next,
-                                     sequence_t seq_next_end,
-                                     const bool retry)
+Napi::Value SnapshotTable::Write(const Napi::CallbackInfo& info)
 {
-    if (seq_next <= seq_next_end)
+    sequence_t *version = GetSlot(info);
+    uint8_t *value = reinterpret_cast<uint8_t*>(&version[1]);
+
+    Napi::Uint8Array data = info[1].As<Napi::Uint8Array>();
+    size_t length = std::min(data.ByteLength(), static_cast<size_t>(value_size));
+
+    // Make the version odd so readers retry while we write. Each key has
+    // only one writer, so if it's odd already the previous writer died part
+    // way through and we just carry on from there.
+    const sequence_t seq = __atomic_load_n(version, memorder) | 1;
+    __atomic_store_n(version, seq, memorder);
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(value, data.Data(), length);
+    memset(value + length, 0, value_size - length);
+
+    __atomic_store_n(version, seq + 1, memorder);
+
+    return Napi::Number::New(info.Env(), seq + 1);
+}
+
+Napi::Value SnapshotTable::Read(const Napi::CallbackInfo& info)
+{
+    sequence_t *version = GetSlot(info);
+    const uint8_t *value = reinterpret_cast<const uint8_t*>(&version[1]);
+
+    Napi::Buffer<uint8_t> r = Napi::Buffer<uint8_t>::New(info.Env(), value_size);
+    const uint32_t max_retries = (info.Length() > 1) && !info[1].IsUndefined() ?
+        info[1].As<Napi::Number>().Uint32Value() : retries;
+
+    for (uint32_t i = 0; (max_retries == 0) || (i <= max_retries); ++i)
     {
-        do
+        if (i > 0)
         {
-            sequence_t expected = seq_next;
-            if (__atomic_compare_exchange_n(cursor, &expected, seq_next_end + 1, false, memorder, memorder))
-            {
-                return Boolean::New(env, true);
-            }
+            std::this_thread::yield();
+        }
+
+        sequence_t seq = __atomic_load_n(version, memorder);
+
+        if (seq == 0)
+        {
+            // Never written
+            return info.Env().Null();
+        }
+
+        if (seq & 1)
+        {
+            // Being written
+            continue;
+        }
+
+        memcpy(r.Data(), value, value_size);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(version, memorder) == seq)
+        {
+            return r;
         }
-        while (retry);
     }
 
-    return Boolean::New(env, false);
+    // The writer is slow or died part way through
+    return info.Env().Undefined();
 }
 
-void Disruptor::UpdateSeqNext(const sequence_t seq_next,
-                              const sequence_t seq_next_end,
-                              const bool all_ignored)
+Napi::Value SnapshotTable::Version(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), __atomic_load_n(GetSlot(info), memorder));
+}
+
+Napi::Value SnapshotTable::GetNumKeys(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), num_keys);
+}
+
+Napi::Value SnapshotTable::GetValueSize(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), value_size);
+}
+
+Napi::Object SnapshotTable::Initialize(Napi::Env env, Napi::Object exports)
 {
-    pending_seq_next = seq_next;
-    pending_seq_next_end = seq_next_end;
-    all_consumers_ignoring = all_ignored;
+    exports.Set("SnapshotTable", DefineClass(env, "SnapshotTable",
+    {
+        InstanceMethod<&SnapshotTable::Write>("write"),
+        InstanceMethod<&SnapshotTable::Read>("read"),
+        InstanceMethod<&SnapshotTable::Version>("version"),
+        InstanceMethod<&SnapshotTable::Release>("release"),
+        InstanceAccessor<&SnapshotTable::GetNumKeys>("numKeys"),
+        InstanceAccessor<&SnapshotTable::GetValueSize>("valueSize")
+    }));
+
+    return exports;
 }
 
-uint32_t Disruptor::GetSeqNext(const Napi::CallbackInfo& info,
-                               sequence_t& seq_next,
-                               sequence_t& seq_next_end)
+class SelectorEntry
 {
-    if (info.Length() >= 2)
+public:
+    SelectorEntry(Disruptor *disruptor, const Napi::Object& options) :
+        disruptor(disruptor), // disruptor_ref keeps this around
+        max(GetUint32Option(options, "max", 0)),
+        weight(GetUint32Option(options, "weight", 1)),
+        priority(GetInt32Option(options, "priority", 0)),
+        disruptor_ref(Napi::Persistent(disruptor->Value()))
     {
-        seq_next = info[0].As<Napi::Number>().Int64Value();
-        seq_next_end = info[1].As<Napi::Number>().Int64Value();
-        return 2;
+        if (max == 0)
+        {
+            max = sequence_max;
+        }
+
+        if (weight == 0)
+        {
+            weight = 1;
+        }
     }
 
-    seq_next = pending_seq_next;
-    seq_next_end = pending_seq_next_end;
-    return 0;
-}
+    Disruptor *disruptor;
+    sequence_t max;
+    uint32_t weight;
+    int32_t priority;
 
-Napi::Value Disruptor::ProduceCommitSync(const Napi::CallbackInfo& info)
+private:
+    Napi::ObjectReference disruptor_ref;
+};
+
+typedef std::vector<std::shared_ptr<SelectorEntry>> SelectorEntries;
+
+class Selector : public Napi::ObjectWrap<Selector>
 {
-    sequence_t seq_next, seq_next_end;
-    GetSeqNext(info, seq_next, seq_next_end);
-    return ProduceCommitSync<Napi::Boolean>(info.Env(), seq_next, seq_next_end, spin);
-}
+public:
+    Selector(const Napi::CallbackInfo& info);
 
-class ProduceCommitAsyncWorker :
-    public DisruptorAsyncWorker<AsyncBoolean>
+    static Napi::Object Initialize(Napi::Env env, Napi::Object exports);
+
+    // Add a Disruptor to wait on
+    void Add(const Napi::CallbackInfo& info);
+
+    // Stop waiting on a Disruptor
+    void Remove(const Napi::CallbackInfo& info);
+
+    // Return unconsumed slots for Disruptors which have any
+    Napi::Value Select(const Napi::CallbackInfo& info);
+    Napi::Value SelectSync(const Napi::CallbackInfo& info);
+
+    // Stop waiting in select, which returns no slots
+    void Cancel(const Napi::CallbackInfo& info);
+
+private:
+    friend class SelectAsyncWorker;
+
+    Napi::Array SelectSync(const Napi::Env& env);
+
+    SelectorEntries entries;
+
+    // Only return Disruptors with the highest ready priority,
+    // otherwise weighted round-robin
+    bool priority;
+
+    // Maximum number of Disruptors to return from each select (0 = all)
+    uint32_t limit;
+
+    // Round-robin position and number of turns used there
+    size_t rr_pos;
+    uint32_t rr_turns;
+
+    // Longest to sleep between checks while waiting
+    uint64_t idle_ns;
+
+    // Changed to make waiting workers look at the entries again or give up
+    uint64_t entries_epoch;
+    uint64_t cancel_epoch;
+};
+
+class SelectAsyncWorker : public Napi::AsyncWorker
 {
 public:
-    ProduceCommitAsyncWorker(Disruptor *disruptor,
-                             const Napi::Function& callback,
-                             sequence_t seq_next,
-                             sequence_t seq_next_end) :
-        DisruptorAsyncWorker<AsyncBoolean>(disruptor, callback),
-        seq_next(seq_next),
-        seq_next_end(seq_next_end)
+    SelectAsyncWorker(Selector *selector,
+                      const Napi::Function& callback) :
+        Napi::AsyncWorker(callback),
+        ready(false),
+        done(false),
+        selector(selector), // selector_ref keeps this around
+        selector_ref(Napi::Persistent(selector->Value())),
+        entries(selector->entries),
+        entries_epoch(selector->entries_epoch),
+        cancel_epoch(selector->cancel_epoch)
     {
+        // Keep the memory mapped while we look at it, even if the
+        // Disruptors are released
+        for (const auto& entry : entries)
+        {
+            if (entry->disruptor->mapping)
+            {
+                mappings.push_back(entry->disruptor->mapping);
+            }
+        }
     }
 
 protected:
     void Execute() override
     {
         // Remember: don't access any V8 stuff in worker thread
-        result = disruptor->ProduceCommitSync<AsyncBoolean>(Env(), seq_next, seq_next_end, false);
-        retry = !result;
+        uint64_t delay_ns = std::min(static_cast<uint64_t>(1000), selector->idle_ns);
+
+        while ((__atomic_load_n(&selector->entries_epoch, memorder) == entries_epoch) &&
+               (__atomic_load_n(&selector->cancel_epoch, memorder) == cancel_epoch))
+        {
+            bool mapped = false;
+
+            for (const auto& entry : entries)
+            {
+                if (entry->disruptor->Ready())
+                {
+                    ready = true;
+                    return;
+                }
+
+                mapped = mapped || (entry->disruptor->shm_buf != MAP_FAILED);
+            }
+
+            if (!mapped)
+            {
+                // Everything's been released
+                done = true;
+                return;
+            }
+
+            // Back off while there's nothing to read
+            if (delay_ns > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(delay_ns));
+                delay_ns = std::min(delay_ns * 2, selector->idle_ns);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        done = __atomic_load_n(&selector->cancel_epoch, memorder) != cancel_epoch;
     }
 
-    void Retry() override
+    void OnOK() override
     {
-        (new ProduceCommitAsyncWorker(disruptor, Callback().Value(), seq_next, seq_next_end))->Queue();
+        Napi::Env env = Env();
+
+        if (ready || done)
+        {
+            // Use the current entries in case any were removed
+            Napi::Array r;
+            try
+            {
+                r = done ? Napi::Array::New(env) : selector->SelectSync(env);
+            }
+            catch (const Napi::Error& e)
+            {
+                // e.g. a handler was attached while we were waiting
+                Callback().MakeCallback(
+                    Receiver().Value(),
+                    std::initializer_list<napi_value>{ e.Value() });
+                return;
+            }
+
+            if (done || (r.Length() > 0))
+            {
+                Callback().MakeCallback(
+                    Receiver().Value(),
+                    std::initializer_list<napi_value>{ env.Null(), r });
+                return;
+            }
+        }
+
+        // Another consumer got there first or the entries changed
+        (new SelectAsyncWorker(selector, Callback().Value()))->Queue();
     }
 
 private:
-    sequence_t seq_next, seq_next_end;
+    bool ready;
+    bool done;   // cancelled or nothing left to wait on
+    Selector *selector;
+    Napi::ObjectReference selector_ref;
+    SelectorEntries entries;
+    std::vector<std::shared_ptr<SharedMapping>> mappings;
+    uint64_t entries_epoch;
+    uint64_t cancel_epoch;
 };
 
-void Disruptor::ProduceCommitAsync(const Napi::CallbackInfo& info,
-                                   sequence_t seq_next,
-                                   sequence_t seq_next_end,
-                                   uint32_t cb_arg)
+Selector::Selector(const Napi::CallbackInfo& info) :
+    Napi::ObjectWrap<Selector>(info),
+    rr_pos(0),
+    rr_turns(0),
+    entries_epoch(0),
+    cancel_epoch(0)
 {
-    (new ProduceCommitAsyncWorker(
-        this, GetCallback(info, cb_arg), seq_next, seq_next_end))->Queue();
-}
+    Napi::Object options = GetOptions(info, 0);
 
-void Disruptor::ProduceCommitAsync(const Napi::CallbackInfo& info)
-{
-    sequence_t seq_next, seq_next_end;
-    uint32_t cb_arg = GetSeqNext(info, seq_next, seq_next_end);
-    ProduceCommitAsync(info, seq_next, seq_next_end, cb_arg);
+    Napi::Value policy = options.Get("policy");
+    if (policy.IsUndefined() ||
+        (policy.ToString().Utf8Value() == "round-robin"))
+    {
+        priority = false;
+    }
+    else if (policy.ToString().Utf8Value() == "priority")
+    {
+        priority = true;
+    }
+    else
+    {
+        throw Napi::TypeError::New(info.Env(), "unknown policy");
+    }
+
+    limit = GetUint32Option(options, "limit", 0);
+    idle_ns = GetUint32Option(options, "idle", 1000) * 1000ULL;
 }
 
-Napi::Value Disruptor::ProduceCommit(const Napi::CallbackInfo& info)
+void Selector::Add(const Napi::CallbackInfo& info)
 {
-    sequence_t seq_next, seq_next_end;
-    uint32_t cb_arg = GetSeqNext(info, seq_next, seq_next_end);
+    Disruptor *disruptor = Disruptor::Unwrap(info[0].As<Napi::Object>());
 
-    Napi::Boolean r = ProduceCommitSync<Napi::Boolean>(info.Env(), seq_next, seq_next_end, false);
-    if (r || !spin)
+    // We consume and commit for it so it can't have a handler doing the same
+    disruptor->CheckNoHandler(info.Env());
+
+    for (const auto& entry : entries)
     {
-        return r;
+        if (entry->disruptor == disruptor)
+        {
+            return;
+        }
     }
 
-    ProduceCommitAsync(info, seq_next, seq_next_end, cb_arg);
-    return info.Env().Undefined();
-}
+    auto new_entry = std::make_shared<SelectorEntry>(
+        disruptor, GetOptions(info, 1));
 
-Napi::Value Disruptor::GetConsumers(const Napi::CallbackInfo&)
-{
-    return consumers_buffer_ref.Value();
+    // Copy so workers waiting on the current entries aren't affected.
+    // Keep in descending priority order, oldest first within a priority.
+    SelectorEntries new_entries(entries);
+    auto it = new_entries.begin();
+    while ((it != new_entries.end()) &&
+           ((*it)->priority >= new_entry->priority))
+    {
+        ++it;
+    }
+    new_entries.insert(it, new_entry);
+    entries = std::move(new_entries);
+    rr_turns = 0;
+    __atomic_add_fetch(&entries_epoch, 1, memorder);
 }
 
-Napi::Value Disruptor::GetCursor(const Napi::CallbackInfo& info)
+void Selector::Remove(const Napi::CallbackInfo& info)
 {
-    return Napi::Number::New(info.Env(), __atomic_load_n(cursor, memorder));
-}
+    Disruptor *disruptor = Disruptor::Unwrap(info[0].As<Napi::Object>());
 
-Napi::Value Disruptor::GetNext(const Napi::CallbackInfo& info)
-{
-    return Napi::Number::New(info.Env(), __atomic_load_n(next, memorder));
+    SelectorEntries new_entries;
+    for (const auto& entry : entries)
+    {
+        if (entry->disruptor != disruptor)
+        {
+            new_entries.push_back(entry);
+        }
+    }
+    entries = std::move(new_entries);
+    rr_turns = 0;
+    __atomic_add_fetch(&entries_epoch, 1, memorder);
 }
 
-Napi::Value Disruptor::GetElements(const Napi::CallbackInfo&)
+void Selector::Cancel(const Napi::CallbackInfo&)
 {
-    return elements_buffer_ref.Value();
+    __atomic_add_fetch(&cancel_epoch, 1, memorder);
 }
 
-Napi::Value Disruptor::GetConsumer(const Napi::CallbackInfo& info)
+Napi::Array Selector::SelectSync(const Napi::Env& env)
 {
-    return Napi::Number::New(info.Env(), __atomic_load_n(ptr_consumer, memorder));
-}
+    // A handler may have been attached since the Disruptor was added
+    for (const auto& entry : entries)
+    {
+        entry->disruptor->CheckNoHandler(env);
+    }
 
-Napi::Value Disruptor::GetPendingSeqConsumer(const Napi::CallbackInfo& info)
-{
-    return Napi::Number::New(info.Env(), pending_seq_consumer);
-}
+    // Commit previous consumes, including from Disruptors which won't
+    // get a turn this time
+    for (const auto& entry : entries)
+    {
+        if (entry->disruptor->shm_buf != MAP_FAILED)
+        {
+            entry->disruptor->ConsumeCommit();
+        }
+    }
 
-Napi::Value Disruptor::GetPendingSeqCursor(const Napi::CallbackInfo& info)
-{
-    return Napi::Number::New(info.Env(), pending_seq_cursor);
-}
+    Napi::Array r = Napi::Array::New(env);
+    uint32_t n = 0;
+    size_t num_entries = entries.size();
+    size_t first = priority || (num_entries == 0) ? 0 : rr_pos % num_entries;
+    size_t first_ready = first;
+    int32_t first_priority = 0;
 
-Napi::Value Disruptor::GetPendingSeqNext(const Napi::CallbackInfo& info)
-{
-    return Napi::Number::New(info.Env(), pending_seq_next);
-}
+    for (size_t i = 0;
+         (i < num_entries) && ((limit == 0) || (n < limit));
+         ++i)
+    {
+        size_t pos = (first + i) % num_entries;
+        SelectorEntry *entry = entries[pos].get();
 
-Napi::Value Disruptor::GetPendingSeqNextEnd(const Napi::CallbackInfo& info)
-{
-    return Napi::Number::New(info.Env(), pending_seq_next_end);
-}
+        // Lower priorities only get a look in when higher ones are idle
+        if (priority && (n > 0) && (entry->priority < first_priority))
+        {
+            break;
+        }
 
-Napi::Value Disruptor::GetAllConsumersIgnoring(const Napi::CallbackInfo& info)
-{
-    return Napi::Boolean::New(info.Env(), all_consumers_ignoring);
-}
+        if (entry->disruptor->Ready())
+        {
+            sequence_t start;
+            Napi::Array bufs = entry->disruptor->ConsumeNewSync<Napi::Array, SyncBuffer>(
+                env, false, start, entry->max);
 
-Napi::Value Disruptor::GetElementSize(const Napi::CallbackInfo& info)
-{
-    return Napi::Number::New(info.Env(), element_size);
-}
+            if (bufs.Length() > 0)
+            {
+                if (n == 0)
+                {
+                    first_ready = pos;
+                    first_priority = entry->priority;
+                }
 
-Napi::Value Disruptor::GetSpin(const Napi::CallbackInfo& info)
-{
-    return Napi::Boolean::New(info.Env(), spin);
-}
+                Napi::Object result = Napi::Object::New(env);
+                result.Set("disruptor", entry->disruptor->Value());
+                result.Set("bufs", bufs);
+                result.Set("start", Napi::Number::New(env, start));
+                r.Set(n++, result);
+            }
+        }
+    }
 
-Napi::Value Disruptor::GetStatus(const Napi::CallbackInfo& info)
-{
-    return Napi::Number::New(info.Env(), __atomic_load_n(status, memorder));
+    if (!priority && (n > 0))
+    {
+        // The first ready Disruptor goes first for weight selects in a row,
+        // then the next one gets a turn
+        if (first_ready != rr_pos)
+        {
+            rr_pos = first_ready;
+            rr_turns = 0;
+        }
+
+        if (++rr_turns >= entries[rr_pos]->weight)
+        {
+            rr_pos = (rr_pos + 1) % num_entries;
+            rr_turns = 0;
+        }
+    }
+
+    return r;
 }
 
-void Disruptor::SetStatus(const Napi::CallbackInfo&, const Napi::Value& value)
+Napi::Value Selector::SelectSync(const Napi::CallbackInfo& info)
 {
-    __atomic_store_n(status, value.As<Napi::Number>(), memorder);
+    return SelectSync(info.Env());
 }
 
-Napi::Object Disruptor::Initialize(Napi::Env env, Napi::Object exports)
+Napi::Value Selector::Select(const Napi::CallbackInfo& info)
 {
+    Napi::Array r = SelectSync(info.Env());
+
+    if ((r.Length() > 0) || entries.empty())
     {
-        std::lock_guard<std::mutex> lock(buffers_mutex);
-        if (!buffers) {
-            buffers = new std::unordered_set<uint8_t*>();
-        }
+        return r;
     }
 
-    exports.Set("Disruptor", DefineClass(env, "Disruptor",
-    {
-        InstanceMethod<&Disruptor::ProduceClaim>("produceClaim"),
-        InstanceMethod<&Disruptor::ProduceClaimSync>("produceClaimSync"),
-        InstanceMethod<&Disruptor::ProduceClaimMany>("produceClaimMany"),
-        InstanceMethod<&Disruptor::ProduceClaimManySync>("produceClaimManySync"),
-        InstanceMethod<&Disruptor::ProduceClaimAvail>("produceClaimAvail"),
-        InstanceMethod<&Disruptor::ProduceClaimAvailSync>("produceClaimAvailSync"),
-        InstanceMethod<&Disruptor::ProduceCommit>("produceCommit"),
-        InstanceMethod<&Disruptor::ProduceCommitSync>("produceCommitSync"),
-        InstanceMethod<&Disruptor::ProduceRecover>("produceRecover"),
-        InstanceMethod<&Disruptor::ConsumeNew>("consumeNew"),
-        InstanceMethod<&Disruptor::ConsumeNewSync>("consumeNewSync"),
-        InstanceMethod<&Disruptor::ConsumeCommit>("consumeCommit"),
-        InstanceMethod<&Disruptor::Release>("release"),
-        InstanceAccessor<&Disruptor::GetPendingSeqConsumer>("prevConsumeStart"),
-        InstanceAccessor<&Disruptor::GetPendingSeqNext>("prevClaimStart"),
-        InstanceAccessor<&Disruptor::GetPendingSeqNextEnd>("prevClaimEnd"),
-        InstanceAccessor<&Disruptor::GetAllConsumersIgnoring>("allConsumersIgnoring"),
-        InstanceAccessor<&Disruptor::GetElementSize>("elementSize"),
-        InstanceAccessor<&Disruptor::GetSpin>("spin"),
-        InstanceAccessor<&Disruptor::GetStatus, &Disruptor::SetStatus>("status"),
+    (new SelectAsyncWorker(this, GetCallback(info, 0)))->Queue();
+    return info.Env().Undefined();
+}
 
-        // For testing only
-        InstanceAccessor<&Disruptor::GetConsumers>("consumers"),
-        InstanceAccessor<&Disruptor::GetCursor>("cursor"),
-        InstanceAccessor<&Disruptor::GetNext>("next"),
-        InstanceAccessor<&Disruptor::GetElements>("elements"),
-        InstanceAccessor<&Disruptor::GetConsumer>("consumer"),
-        InstanceAccessor<&Disruptor::GetPendingSeqCursor>("prevConsumeNext"),
-        InstanceMethod<&Disruptor::ConsumeNewAsync>("consumeNewAsync"),
-        InstanceMethod<&Disruptor::ProduceClaimAsync>("produceClaimAsync"),
-        InstanceMethod<&Disruptor::ProduceClaimManyAsync>("produceClaimManyAsync"),
-        InstanceMethod<&Disruptor::ProduceClaimAvailAsync>("produceClaimAvailAsync"),
-        InstanceMethod<&Disruptor::ProduceCommitAsync>("produceCommitAsync")
+Napi::Object Selector::Initialize(Napi::Env env, Napi::Object exports)
+{
+    exports.Set("Selector", DefineClass(env, "Selector",
+    {
+        InstanceMethod<&Selector::Add>("add"),
+        InstanceMethod<&Selector::Remove>("remove"),
+        InstanceMethod<&Selector::Select>("select"),
+        InstanceMethod<&Selector::SelectSync>("selectSync"),
+        InstanceMethod<&Selector::Cancel>("cancel")
     }));
 
     return exports;
@@ -1452,7 +5508,9 @@ Napi::Object Disruptor::Initialize(Napi::Env env, Napi::Object exports)
 
 Napi::Object Initialize(Napi::Env env, Napi::Object exports)
 {
-    return Disruptor::Initialize(env, exports);
+    Disruptor::Initialize(env, exports);
+    SnapshotTable::Initialize(env, exports);
+    return Selector::Initialize(env, exports);
 }
 
 NODE_API_MODULE(disruptor, Initialize)
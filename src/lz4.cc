@@ -0,0 +1,222 @@
+#include <cstring>
+#include "lz4.h"
+
+namespace lz4
+{
+
+const size_t min_match = 4;
+const size_t last_literals = 5;  // last bytes of a block are always literals
+const size_t mf_limit = 12;      // last match starts at least this far from the end
+const size_t max_offset = 65535;
+const int hash_log = 12;
+
+inline uint32_t Read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t Hash(const uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - hash_log);
+}
+
+// Lengths of 15 or more continue in bytes of 255 plus a final byte
+inline uint8_t *WriteLength(uint8_t *op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+inline uint8_t *WriteLiterals(uint8_t *op,
+                              uint8_t *token,
+                              const uint8_t *anchor,
+                              const size_t length)
+{
+    if (length >= 15)
+    {
+        *token = 15 << 4;
+        op = WriteLength(op, length - 15);
+    }
+    else
+    {
+        *token = static_cast<uint8_t>(length << 4);
+    }
+
+    if (length > 0)
+    {
+        memcpy(op, anchor, length);
+    }
+    return op + length;
+}
+
+size_t Bound(const size_t n)
+{
+    return n + n / 255 + 16;
+}
+
+size_t MaxDecompressed(const size_t n)
+{
+    // Literals take a byte each and a sequence needs at least one byte
+    // for each 255 bytes its match adds
+    return n * 255;
+}
+
+size_t Compress(const uint8_t *src, const size_t n, uint8_t *dst)
+{
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *const end = src + n;
+    uint8_t *op = dst;
+    uint32_t table[1 << hash_log] = {};
+
+    if (n > mf_limit)
+    {
+        const uint8_t *const match_limit = end - mf_limit;
+        const uint8_t *const extend_limit = end - last_literals;
+
+        while (ip < match_limit)
+        {
+            const uint32_t seq = Read32(ip);
+            const uint32_t h = Hash(seq);
+            const uint8_t *ref = src + table[h];
+            table[h] = static_cast<uint32_t>(ip - src);
+
+            if ((ref >= ip) ||
+                (static_cast<size_t>(ip - ref) > max_offset) ||
+                (Read32(ref) != seq))
+            {
+                // Skip faster through data which doesn't compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            const uint8_t *mp = ip + min_match;
+            const uint8_t *rp = ref + min_match;
+            while ((mp < extend_limit) && (*mp == *rp))
+            {
+                ++mp;
+                ++rp;
+            }
+
+            uint8_t *token = op++;
+            op = WriteLiterals(op, token, anchor, ip - anchor);
+
+            const size_t offset = ip - ref;
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+
+            const size_t match_length = (mp - ip) - min_match;
+            if (match_length >= 15)
+            {
+                *token |= 15;
+                op = WriteLength(op, match_length - 15);
+            }
+            else
+            {
+                *token |= static_cast<uint8_t>(match_length);
+            }
+
+            ip = anchor = mp;
+        }
+    }
+
+    uint8_t *token = op++;
+    op = WriteLiterals(op, token, anchor, end - anchor);
+    return op - dst;
+}
+
+// Read a length continued in extra bytes
+inline bool ReadLength(const uint8_t *&ip, const uint8_t *end, size_t &length)
+{
+    uint8_t b;
+    do
+    {
+        if (ip >= end)
+        {
+            return false;
+        }
+        b = *ip++;
+        length += b;
+    }
+    while (b == 255);
+
+    return true;
+}
+
+bool Decompress(const uint8_t *src, const size_t n, uint8_t *dst, const size_t size)
+{
+    const uint8_t *ip = src;
+    const uint8_t *const end = src + n;
+    uint8_t *op = dst;
+    uint8_t *const out_end = dst + size;
+
+    while (ip < end)
+    {
+        const uint8_t token = *ip++;
+
+        size_t length = token >> 4;
+        if ((length == 15) && !ReadLength(ip, end, length))
+        {
+            return false;
+        }
+
+        if ((length > static_cast<size_t>(end - ip)) ||
+            (length > static_cast<size_t>(out_end - op)))
+        {
+            return false;
+        }
+
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
+
+        if (ip == end)
+        {
+            // Last sequence has no match
+            return op == out_end;
+        }
+
+        if (end - ip < 2)
+        {
+            return false;
+        }
+
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if ((offset == 0) || (offset > static_cast<size_t>(op - dst)))
+        {
+            return false;
+        }
+
+        length = token & 15;
+        if ((length == 15) && !ReadLength(ip, end, length))
+        {
+            return false;
+        }
+        length += min_match;
+
+        if (length > static_cast<size_t>(out_end - op))
+        {
+            return false;
+        }
+
+        // Matches can overlap the output
+        const uint8_t *ref = op - offset;
+        for (size_t i = 0; i < length; ++i)
+        {
+            op[i] = ref[i];
+        }
+        op += length;
+    }
+
+    return false;
+}
+
+}
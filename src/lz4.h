@@ -0,0 +1,32 @@
+#ifndef DISRUPTOR_LZ4_H
+#define DISRUPTOR_LZ4_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Compressor and decompressor for the LZ4 block format:
+//
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+//
+// Only whole blocks are supported (no frames, checksums or dictionaries).
+
+namespace lz4
+{
+
+// Largest compressed size of n bytes
+size_t Bound(const size_t n);
+
+// Largest size n compressed bytes can decompress to
+size_t MaxDecompressed(const size_t n);
+
+// Compress n bytes from src into dst, which must have room for Bound(n)
+// bytes. Returns the compressed size.
+size_t Compress(const uint8_t *src, const size_t n, uint8_t *dst);
+
+// Decompress n bytes from src into exactly size bytes at dst. Returns
+// false if the input is corrupt or doesn't decompress to size bytes.
+bool Decompress(const uint8_t *src, const size_t n, uint8_t *dst, const size_t size);
+
+}
+
+#endif
@@ -0,0 +1,139 @@
+let expect;
+const { Disruptor, Coalescer } = require('..');
+
+before(async function () {
+    ({ expect } = await import('chai'));
+});
+
+describe('coalescer', function () {
+    this.timeout(60000);
+
+    let p, d;
+
+    beforeEach(function () {
+        p = new Disruptor('/test_coalescer', 16, 4, 1, 0, true, false);
+        d = new Disruptor('/test_coalescer', 16, 4, 1, 0, false, false);
+    });
+
+    afterEach(function () {
+        p.release();
+        d.release();
+    });
+
+    it('should write values together when the buffer fills', function () {
+        const c = new Coalescer(p, { maxElements: 4, maxDelay: 1000000 });
+
+        expect(c.write(Buffer.from([1]))).to.be.true;
+        expect(c.write('ab')).to.be.true;
+        expect(c.pending).to.equal(2);
+        expect(d.consumeNewSync()).to.eql([]);
+
+        expect(c.write(new Uint16Array([0x0403, 0x0605, 0x0807]))).to.be.true;
+        expect(c.pending).to.equal(0);
+        expect(p.cursor).to.equal(4);
+
+        const b = Buffer.concat(d.consumeNewSync());
+        expect(b.equals(Buffer.from([1, 0, 0, 0,
+                                     0x61, 0x62, 0, 0,
+                                     3, 4, 5, 6,
+                                     7, 8, 0, 0]))).to.be.true;
+    });
+
+    it('should write on flush', function () {
+        const c = new Coalescer(p, { maxDelay: 1000000 });
+
+        expect(c.flush()).to.be.true;
+        expect(c.write(new Uint8Array([9]).buffer)).to.be.true;
+        expect(c.pending).to.equal(1);
+        expect(c.flush()).to.be.true;
+        expect(c.pending).to.equal(0);
+        expect(Buffer.concat(d.consumeNewSync()).equals(Buffer.from([9, 0, 0, 0]))).to.be.true;
+    });
+
+    it('should write after the deadline', function (done) {
+        const c = new Coalescer(p, { maxDelay: 1000 });
+
+        expect(c.write(Buffer.from([1, 2, 3, 4]))).to.be.true;
+        expect(c.pending).to.equal(1);
+
+        setTimeout(() => {
+            expect(c.pending).to.equal(0);
+            expect(Buffer.concat(d.consumeNewSync()).equals(Buffer.from([1, 2, 3, 4]))).to.be.true;
+            done();
+        }, 50);
+    });
+
+    it('should write large values directly', function () {
+        const c = new Coalescer(p, { maxElements: 2, maxDelay: 1000000 });
+
+        expect(c.write(Buffer.from([1]))).to.be.true;
+        expect(c.write(Buffer.alloc(12, 2))).to.be.true;
+        expect(c.pending).to.equal(0);
+        expect(Buffer.concat(d.consumeNewSync()).equals(Buffer.concat([
+            Buffer.from([1, 0, 0, 0]),
+            Buffer.alloc(12, 2)
+        ]))).to.be.true;
+    });
+
+    it('should keep values when the Disruptor is full', function (done) {
+        const c = new Coalescer(p, { maxElements: 4, maxDelay: 1000 });
+
+        for (let i = 0; i < 16; i += 1) {
+            expect(p.produceSync(Buffer.alloc(4))).to.be.true;
+        }
+
+        expect(c.write(Buffer.from([1]))).to.be.true;
+        expect(c.flush()).to.be.false;
+        expect(c.pending).to.equal(1);
+        expect(c.write(Buffer.alloc(16))).to.be.false;
+        expect(c.pending).to.equal(1);
+
+        setTimeout(() => {
+            // Timer keeps trying
+            expect(c.pending).to.equal(1);
+            d.consumeNewSync();
+            d.consumeCommit();
+            setTimeout(() => {
+                expect(c.pending).to.equal(0);
+                expect(Buffer.concat(d.consumeNewSync()).equals(Buffer.from([1, 0, 0, 0]))).to.be.true;
+                done();
+            }, 50);
+        }, 20);
+    });
+
+    it('should write and stop the timer on close', function (done) {
+        const c = new Coalescer(p, { maxDelay: 1000 });
+
+        expect(c.write(Buffer.from([1]))).to.be.true;
+        expect(c._timer.hasRef()).to.be.false;
+        expect(c.close()).to.be.true;
+        expect(c._timer).to.be.null;
+        expect(c.pending).to.equal(0);
+        expect(Buffer.concat(d.consumeNewSync()).equals(Buffer.from([1, 0, 0, 0]))).to.be.true;
+        d.consumeCommit();
+
+        expect(function () {
+            c.write(Buffer.from([2]));
+        }).to.throw('closed');
+
+        setTimeout(() => {
+            expect(d.consumeNewSync()).to.eql([]);
+            done();
+        }, 20);
+    });
+
+    it('should throw error if element_size is 0', function () {
+        const c = new Disruptor('/test_coalescer2', 16, 0, 1, 0, true, false, { columns: { x: 'uint32' } });
+        expect(function () {
+            new Coalescer(c);
+        }).to.throw('element_size is 0');
+        c.release();
+    });
+
+    it('should throw error if data type is wrong', function () {
+        const c = new Coalescer(p);
+        expect(function () {
+            c.write(123);
+        }).to.throw('data must be a Buffer, TypedArray, ArrayBuffer or string');
+    });
+});
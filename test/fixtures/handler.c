@@ -0,0 +1,32 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Appends each run of elements to the file named by HANDLER_OUT.
+   Stops if an element (4 bytes) starts with 0xff. */
+int on_batch(const uint8_t *ptr, size_t len, uint64_t seq)
+{
+    size_t i;
+    FILE *f;
+
+    (void) seq;
+
+    for (i = 0; i < len; i += 4)
+    {
+        if (ptr[i] == 0xff)
+        {
+            return 42;
+        }
+    }
+
+    f = fopen(getenv("HANDLER_OUT"), "ab");
+    if (!f)
+    {
+        return -1;
+    }
+
+    fwrite(ptr, 1, len, f);
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,205 @@
+const { execFileSync } = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+let expect;
+const { Disruptor, Selector } = require('..');
+
+before(async function () {
+    ({ expect } = await import('chai'));
+});
+
+describe('native handler', function () {
+    this.timeout(60000);
+
+    const lib = path.join(os.tmpdir(), `disruptor_handler_${process.pid}.so`);
+    const out = path.join(os.tmpdir(), `disruptor_handler_${process.pid}.out`);
+    let p, d;
+
+    before(function () {
+        try {
+            execFileSync('cc', ['-shared', '-fPIC', '-o', lib,
+                                path.join(__dirname, 'fixtures', 'handler.c')]);
+        } catch (ex) {
+            // No compiler
+            this.skip();
+        }
+        process.env.HANDLER_OUT = out;
+    });
+
+    after(function () {
+        fs.rmSync(lib, { force: true });
+        fs.rmSync(out, { force: true });
+    });
+
+    beforeEach(function () {
+        fs.rmSync(out, { force: true });
+        p = new Disruptor('/test_handler', 16, 4, 1, 0, true, false);
+        d = new Disruptor('/test_handler', 16, 4, 1, 0, false, false);
+    });
+
+    afterEach(function () {
+        p.release();
+        d.release();
+    });
+
+    async function until(f) {
+        while (!f()) {
+            await new Promise(resolve => setTimeout(resolve, 5));
+        }
+    }
+
+    async function produce(bufs) {
+        for (const b of bufs) {
+            while (!p.produceSync(b)) {
+                await new Promise(resolve => setImmediate(resolve));
+            }
+        }
+    }
+
+    it('should pass elements to the handler', async function () {
+        expect(d.handlerStats).to.be.null;
+        d.attachHandler(lib);
+
+        const bufs = [];
+        for (let i = 0; i < 50; i += 1) {
+            const b = Buffer.alloc(4);
+            b.writeUInt32BE(i);
+            bufs.push(b);
+        }
+        // More than the ring holds, so the handler has to keep up
+        await produce(bufs);
+        await until(() => d.handlerStats.elements === 50);
+
+        const stats = d.detachHandler();
+        expect(stats.running).to.be.false;
+        expect(stats.batches).to.be.within(1, 50);
+        expect(stats.elements).to.equal(50);
+        expect(stats.result).to.equal(0);
+        expect(d.handlerStats).to.be.null;
+        expect(d.lag).to.equal(0);
+
+        expect(fs.readFileSync(out).equals(Buffer.concat(bufs))).to.be.true;
+    });
+
+    it('should stop when the handler fails', async function () {
+        await produce([Buffer.from([1, 2, 3, 4]), Buffer.from([0xff, 0, 0, 0])]);
+        d.attachHandler(lib, 'on_batch', { idle: 0 });
+        await until(() => !d.handlerStats.running);
+
+        const stats = d.detachHandler();
+        expect(stats.result).to.equal(42);
+        expect(stats.elements).to.equal(0);
+        expect(fs.existsSync(out)).to.be.false;
+
+        // Elements are still there to be read
+        const bufs = d.consumeNewSync();
+        expect(Buffer.concat(bufs).equals(Buffer.from([1, 2, 3, 4, 0xff, 0, 0, 0]))).to.be.true;
+    });
+
+    async function wrap() {
+        // Move to near the end of the ring so the next batch wraps
+        await produce(Array.from({ length: 14 }, () => Buffer.alloc(4)));
+        expect(d.consumeNewSync().length).to.equal(1);
+        expect(d.consumeCommit()).to.be.true;
+    }
+
+    const ok = Buffer.from([1, 2, 3, 4]), bad = Buffer.from([0xff, 0, 0, 0]);
+
+    it('should commit nothing if the handler fails before a wrap', async function () {
+        await wrap();
+        await produce([bad, ok, ok, ok]);
+        d.attachHandler(lib, 'on_batch', { idle: 0 });
+        await until(() => !d.handlerStats.running);
+
+        const stats = d.detachHandler();
+        expect(stats.result).to.equal(42);
+        expect(stats.elements).to.equal(0);
+        expect(fs.existsSync(out)).to.be.false;
+        expect(d.consumers.readUInt32LE(0)).to.equal(14);
+    });
+
+    it('should commit what the handler accepted if it fails after a wrap', async function () {
+        await wrap();
+        await produce([ok, ok, bad, ok]);
+        d.attachHandler(lib, 'on_batch', { idle: 0 });
+        await until(() => !d.handlerStats.running);
+
+        const stats = d.detachHandler();
+        expect(stats.result).to.equal(42);
+        expect(stats.elements).to.equal(2);
+        expect(fs.readFileSync(out).equals(Buffer.concat([ok, ok]))).to.be.true;
+        expect(d.consumers.readUInt32LE(0)).to.equal(16);
+
+        const bufs = d.consumeNewSync();
+        expect(Buffer.concat(bufs).equals(Buffer.concat([bad, ok]))).to.be.true;
+    });
+
+    it('should drop elements the handler fails on in pool mode', async function () {
+        const pp = new Disruptor('/test_handler_pool', 16, 4, 1, 0, true, false, { pool: true });
+        const dp = new Disruptor('/test_handler_pool', 16, 4, 1, 0, false, false, { pool: true });
+        expect(pp.produceSync(Buffer.from([0xff, 0, 0, 0]))).to.be.true;
+        dp.attachHandler(lib);
+        await until(() => !dp.handlerStats.running);
+        expect(dp.detachHandler().result).to.equal(42);
+        // Other workers can't see them so they're committed anyway
+        expect(dp.consumers.readUInt32LE(0)).to.equal(1);
+        pp.release();
+        dp.release();
+    });
+
+    it('should refuse to consume while a handler is attached', async function () {
+        d.attachHandler(lib);
+        for (const f of [() => d.consumeNewSync(),
+                         () => d.consumeNew(),
+                         () => d.consumeWait(),
+                         () => d.consumeCommit(),
+                         () => d.consumeCommitUpTo(0),
+                         () => d.consumeRewind(0),
+                         () => d.consumeToSync(1),
+                         () => d.consumeDecompressSync(),
+                         () => d.consumeAggregateSync('x')]) {
+            expect(f).to.throw('handler attached');
+        }
+        let err;
+        try {
+            await d.batches().next();
+        } catch (ex) {
+            err = ex;
+        }
+        expect(err.message).to.equal('handler attached');
+        d.detachHandler();
+        expect(d.consumeNewSync()).to.eql([]);
+    });
+
+    it('should refuse to select while a handler is attached', function () {
+        const s = new Selector();
+        d.attachHandler(lib);
+        expect(() => s.add(d)).to.throw('handler attached');
+        d.detachHandler();
+
+        // Attached after being added
+        s.add(d);
+        d.attachHandler(lib);
+        expect(() => s.selectSync()).to.throw('handler attached');
+        d.detachHandler();
+        expect(s.selectSync()).to.eql([]);
+    });
+
+    it('should throw error if handler is invalid', function () {
+        expect(function () {
+            d.attachHandler(path.join(os.tmpdir(), 'does_not_exist.so'));
+        }).to.throw('does_not_exist.so');
+
+        expect(function () {
+            d.attachHandler(lib, 'on_missing');
+        }).to.throw('on_missing');
+
+        d.attachHandler(lib);
+        expect(function () {
+            d.attachHandler(lib);
+        }).to.throw('handler already attached');
+        expect(d.detachHandler().running).to.be.false;
+        expect(d.detachHandler()).to.be.null;
+    });
+});
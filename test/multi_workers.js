@@ -98,3 +98,293 @@ for (let num_producers of [1, 2, 4])
         }
     }
 }
+
+describe('multi-workers shared mapping', function ()
+{
+    this.timeout(60000);
+
+    const linux = process.platform === 'linux';
+
+    function count_mappings()
+    {
+        return require('fs').readFileSync('/proc/self/maps', 'utf8')
+            .split('\n')
+            .filter(l => l.includes('/test_share'))
+            .length;
+    }
+
+    it('should use one mapping for all workers', function (done)
+    {
+        const num_consumers = 4;
+        const num_elements_to_write = 100;
+
+        const d = new Disruptor('/test_share', 1000, 256, num_consumers, 0, true, true, { share: true });
+
+        for (let i = 0; i < num_elements_to_write; i += 1)
+        {
+            d.produceClaimSync().fill(1);
+            d.produceCommitSync();
+        }
+
+        async.times(num_consumers, function (n, next)
+        {
+            const worker = new worker_threads.Worker(`
+                const { workerData, parentPort } = require('worker_threads');
+                const fs = require('fs');
+                const { Disruptor } = require(${JSON.stringify(path.join(__dirname, '..'))});
+                const d = Disruptor.fromHandle(workerData.handle, workerData.n);
+                const mappings = fs.readFileSync('/proc/self/maps', 'utf8')
+                    .split('\n')
+                    .filter(l => l.includes('/test_share'))
+                    .length;
+                (async () => {
+                    let count = 0, sum = 0;
+                    while (count < workerData.num_elements_to_write) {
+                        const { bufs } = await d.consumeNew();
+                        for (let b of bufs) {
+                            count += b.length / 256;
+                            for (let i = 0; i < b.length; i += 1) {
+                                sum += b[i];
+                            }
+                        }
+                    }
+                    d.release();
+                    parentPort.postMessage({ sum, mappings });
+                })();
+            `, {
+                eval: true,
+                workerData: { handle: d.handle(), n, num_elements_to_write }
+            });
+
+            worker.on('message', function (msg)
+            {
+                next(null, msg);
+            });
+        }, function (err, msgs)
+        {
+            if (err) { return done(err); }
+
+            for (let { sum, mappings } of msgs)
+            {
+                expect(sum).to.equal(num_elements_to_write * 256);
+                if (linux)
+                {
+                    expect(mappings).to.equal(1);
+                }
+            }
+
+            if (linux)
+            {
+                expect(count_mappings()).to.equal(1);
+            }
+
+            d.release();
+
+            if (linux)
+            {
+                expect(count_mappings()).to.equal(0);
+            }
+
+            done();
+        });
+    });
+
+    it('should map again if initialized', function ()
+    {
+        const d = new Disruptor('/test_share', 1000, 256, 1, 0, true, false, { share: true });
+        const d2 = Disruptor.fromHandle(d.handle(), 0);
+        const d3 = new Disruptor('/test_share', 1000, 256, 1, 0, true, false, { share: true });
+        const d4 = Disruptor.fromHandle(d.handle(), 0);
+
+        d.produceClaimSync().fill(1);
+        d.produceCommitSync();
+        expect(d2.consumeNewSync().length).to.equal(1);
+        expect(d3.consumeNewSync().length).to.equal(0);
+        expect(d4.consumeNewSync().length).to.equal(0);
+
+        expect(function ()
+        {
+            new Disruptor('/test_share', 2000, 256, 1, 0, false, false, { share: true });
+        }).to.throw('Shared memory is too small');
+
+        if (linux)
+        {
+            expect(count_mappings()).to.equal(2);
+        }
+
+        for (let x of [d, d2, d3, d4])
+        {
+            x.release();
+        }
+
+        if (linux)
+        {
+            expect(count_mappings()).to.equal(0);
+        }
+    });
+});
+
+describe('multi-workers work pool', function ()
+{
+    this.timeout(60000);
+
+    it('should give each element to exactly one worker', function (done)
+    {
+        const num_workers = 4;
+        const num_elements_to_write = 10000;
+
+        const d = new Disruptor('/test_pool', 100, 4, num_workers, 0, true, false, { pool: true });
+
+        async.times(num_workers, function (n, next)
+        {
+            const worker = new worker_threads.Worker(`
+                const { workerData, parentPort } = require('worker_threads');
+                const { Disruptor } = require(${JSON.stringify(path.join(__dirname, '..'))});
+                const d = new Disruptor('/test_pool', 100, 4, workerData.num_workers, workerData.n, false, false, { pool: true, maxBatch: 7 });
+                const values = [];
+                (function loop() {
+                    const bufs = d.consumeNewSync();
+                    for (let b of bufs) {
+                        for (let i = 0; i < b.length; i += 4) {
+                            values.push(b.readUInt32LE(i));
+                        }
+                    }
+                    if ((bufs.length === 0) && (d.status === 1) && (d.lag === 0)) {
+                        d.release(true);
+                        return parentPort.postMessage(values);
+                    }
+                    setImmediate(loop);
+                })();
+            `, {
+                eval: true,
+                workerData: { n, num_workers }
+            });
+
+            worker.on('message', function (values)
+            {
+                next(null, values);
+            });
+        }, function (err, all_values)
+        {
+            if (err) { return done(err); }
+
+            const seen = new Array(num_elements_to_write).fill(0);
+            for (let values of all_values)
+            {
+                for (let i = 1; i < values.length; i += 1)
+                {
+                    // Each worker gets elements in order
+                    expect(values[i]).to.be.above(values[i - 1]);
+                }
+                for (let v of values)
+                {
+                    seen[v] += 1;
+                }
+            }
+            expect(seen.every(n => n === 1)).to.be.true;
+
+            d.release();
+            done();
+        });
+
+        let i = 0;
+
+        (function produce()
+        {
+            while (i < num_elements_to_write)
+            {
+                const b = Buffer.alloc(4);
+                b.writeUInt32LE(i);
+                if (!d.produceSync(b))
+                {
+                    return setImmediate(produce);
+                }
+                i += 1;
+            }
+
+            d.status = 1;
+        })();
+    });
+});
+
+describe('multi-workers overwrite', function ()
+{
+    this.timeout(60000);
+
+    it('should not accept slots producers have lapped before stamping', function (done)
+    {
+        const num_producers = 4;
+        const num_elements_to_write = 20000;
+
+        // A tiny ring so producers keep lapping each other between moving
+        // the cursor and stamping the slots they committed
+        const d = new Disruptor('/test_overwrite', 2, 64, 1, 0, true, false, { overwrite: true });
+
+        let finished = 0, checked = 0;
+
+        async.times(num_producers, function (n, next)
+        {
+            const worker = new worker_threads.Worker(`
+                const { workerData, parentPort } = require('worker_threads');
+                const { Disruptor } = require(${JSON.stringify(path.join(__dirname, '..'))});
+                const d = new Disruptor('/test_overwrite', 2, 64, 1, 0, false, true, { overwrite: true });
+                for (let i = 0; i < workerData.num_elements_to_write; i += 1) {
+                    const b = d.produceClaimSync();
+                    const seq = d.prevClaimStart;
+                    b.writeUInt32LE(seq, 0);
+                    b.fill(seq & 0xff, 4, 60);
+                    b.writeUInt32LE(seq, 60);
+                    d.produceCommitSync();
+                }
+                d.release();
+                parentPort.postMessage(null);
+            `, {
+                eval: true,
+                workerData: { num_elements_to_write }
+            });
+
+            worker.on('message', function ()
+            {
+                finished += 1;
+                next();
+            });
+        }, function (err)
+        {
+            if (err) { return done(err); }
+        });
+
+        (function consume()
+        {
+            const bufs = d.consumeNewSync();
+            const copies = bufs.map(b => Buffer.from(b));
+
+            // Any slot not reported as overwritten must hold the sequence
+            // it was returned for
+            if (d.consumeCheck() === 0)
+            {
+                let seq = d.prevConsumeStart;
+                for (let c of copies)
+                {
+                    for (let i = 0; i < c.length; i += 64)
+                    {
+                        expect(c.readUInt32LE(i)).to.equal(seq);
+                        expect(c.readUInt32LE(i + 60)).to.equal(seq);
+                        seq += 1;
+                        checked += 1;
+                    }
+                }
+            }
+
+            d.consumeCommit();
+
+            if ((finished < num_producers) || (bufs.length > 0))
+            {
+                return setImmediate(consume);
+            }
+
+            expect(checked).to.be.above(0);
+            d.release();
+            done();
+        })();
+    });
+});
@@ -0,0 +1,121 @@
+let expect;
+const { PartitionedDisruptor } = require('..');
+
+before(async function () {
+    ({ expect } = await import('chai'));
+});
+
+describe('partitioned', function () {
+    this.timeout(60000);
+
+    let p, c0, c1;
+
+    beforeEach(function () {
+        p = new PartitionedDisruptor('/test_partitioned', 4, 16, 4, 1, 0, true, false);
+        c0 = new PartitionedDisruptor('/test_partitioned', 4, 16, 4, 1, 0, false, false, { partitions: [0, 1] });
+        c1 = new PartitionedDisruptor('/test_partitioned', 4, 16, 4, 1, 0, false, false, { partitions: [2, 3] });
+    });
+
+    afterEach(function () {
+        p.release();
+        c0.release();
+        c1.release();
+    });
+
+    function values(r) {
+        const vs = [];
+        for (const b of r.bufs) {
+            for (let i = 0; i < b.length; i += 4) {
+                vs.push(b.readUInt32LE(i));
+            }
+        }
+        return vs;
+    }
+
+    it('should route keys to partitions', function () {
+        expect(p.disruptors.length).to.equal(4);
+        expect(p.partitions).to.eql([0, 1, 2, 3]);
+        expect(c0.partitions).to.eql([0, 1]);
+
+        expect(p.partition(0)).to.equal(0);
+        expect(p.partition(7)).to.equal(3);
+
+        const k = p.partition('hello');
+        expect(k).to.be.within(0, 3);
+        expect(p.partition('hello')).to.equal(k);
+        expect(p.partition(Buffer.from('hello'))).to.equal(k);
+        expect(c1.partition('hello')).to.equal(k);
+        expect(p.disruptor('hello')).to.equal(p.disruptors[k]);
+
+        const seen = new Set();
+        for (let i = 0; i < 100; i += 1) {
+            seen.add(p.partition(`key${i}`));
+        }
+        expect(seen.size).to.equal(4);
+    });
+
+    it('should throw error if key is invalid', function () {
+        expect(function () {
+            p.partition(-1);
+        }).to.throw('key must be a non-negative integer, string or Buffer');
+
+        expect(function () {
+            p.partition({});
+        }).to.throw('key must be a non-negative integer, string or Buffer');
+    });
+
+    it('should throw error if partition out of range', function () {
+        expect(function () {
+            new PartitionedDisruptor('/test_partitioned', 4, 16, 4, 1, 0, false, false, { partitions: [4] });
+        }).to.throw('partition out of range');
+    });
+
+    it('should give each consumer its own partitions', function () {
+        for (let i = 0; i < 8; i += 1) {
+            const b = Buffer.alloc(4);
+            b.writeUInt32LE(i);
+            expect(p.produceSync(i, b)).to.be.true;
+        }
+
+        const r0 = c0.consumeNewSync();
+        expect(r0.length).to.equal(2);
+        const vs0 = r0.map(r => [c0.disruptors.indexOf(r.disruptor), values(r)]);
+        vs0.sort((a, b) => a[0] - b[0]);
+        expect(vs0).to.eql([[0, [0, 4]], [1, [1, 5]]]);
+
+        const r1 = c1.consumeNewSync();
+        expect(r1.length).to.equal(2);
+        const vs1 = r1.map(r => [c1.disruptors.indexOf(r.disruptor), values(r)]);
+        vs1.sort((a, b) => a[0] - b[0]);
+        expect(vs1).to.eql([[2, [2, 6]], [3, [3, 7]]]);
+
+        expect(c0.consumeCommit()).to.be.true;
+        expect(c1.consumeCommit()).to.be.true;
+        expect(c0.consumeNewSync()).to.eql([]);
+        expect(c1.consumeNewSync()).to.eql([]);
+    });
+
+    it('should keep values with the same key in order', async function () {
+        const b = Buffer.alloc(4);
+        for (let i = 0; i < 10; i += 1) {
+            b.writeUInt32LE(i);
+            expect(p.produceManySync('order', [b])).to.be.true;
+        }
+
+        const c = p.partition('order') < 2 ? c0 : c1;
+        const r = await c.consumeNew();
+        expect(r.length).to.equal(1);
+        expect(r[0].disruptor).to.equal(c.disruptor('order'));
+        expect(values(r[0])).to.eql([0, 1, 2, 3, 4, 5, 6, 7, 8, 9]);
+    });
+
+    it('should only mark its own partitions as ignored', function () {
+        c0.release(true);
+        for (let i = 0; i < 4; i += 1) {
+            const b = Buffer.alloc(4);
+            b.writeUInt32LE(i);
+            expect(p.produceSync(i, b)).to.equal(i >= 2);
+        }
+        c0 = new PartitionedDisruptor('/test_partitioned', 4, 16, 4, 1, 0, false, false, { partitions: [] });
+    });
+});
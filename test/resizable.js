@@ -0,0 +1,176 @@
+let expect;
+const fs = require('fs');
+const { Disruptor, ResizableDisruptor } = require('..');
+
+before(async function () {
+    ({ expect } = await import('chai'));
+});
+
+describe('resizable', function () {
+    this.timeout(60000);
+
+    let p, c;
+
+    beforeEach(function () {
+        p = new ResizableDisruptor('/test_resizable', 4, 4, 1, 0, true, false);
+        c = new ResizableDisruptor('/test_resizable', 4, 4, 1, 0, false, false);
+    });
+
+    afterEach(function () {
+        p.release();
+        c.release();
+    });
+
+    function values(bufs) {
+        const vs = [];
+        for (const b of bufs) {
+            for (let i = 0; i < b.length; i += 4) {
+                vs.push(b.readUInt32LE(i));
+            }
+        }
+        return vs;
+    }
+
+    function produce(d, from, to) {
+        for (let i = from; i < to; i += 1) {
+            const b = Buffer.alloc(4);
+            b.writeUInt32LE(i);
+            if (!d.produceSync(b)) {
+                return i;
+            }
+        }
+        return to;
+    }
+
+    it('should grow without losing or reordering values', function () {
+        expect(produce(p, 0, 10)).to.equal(4);
+        expect(values(c.consumeNewSync(2))).to.eql([0, 1]);
+
+        expect(p.resize(8)).to.be.true;
+        expect(p.producerGeneration).to.equal(1);
+        expect(p.consumerGeneration).to.equal(0);
+        expect(p.consumer.forward).to.eql({ generation: 1, numElements: 8, boundary: 4 });
+        expect(produce(p, 4, 20)).to.equal(12);
+
+        const vs = [];
+        let bufs;
+        while ((bufs = c.consumeNewSync()).length > 0) {
+            vs.push(...values(bufs));
+        }
+        expect(vs).to.eql([2, 3, 4, 5, 6, 7, 8, 9, 10, 11]);
+        expect(c.consumerGeneration).to.equal(1);
+        expect(c.consumer.forward).to.be.null;
+    });
+
+    it('should shrink and move other producers over', function () {
+        const p2 = new ResizableDisruptor('/test_resizable', 4, 4, 1, 0, false, false);
+        expect(produce(p2, 0, 1)).to.equal(1);
+
+        expect(p.resize(2)).to.be.true;
+        expect(produce(p2, 1, 10)).to.equal(3);
+        expect(p2.producerGeneration).to.equal(1);
+
+        expect(values(c.consumeNewSync())).to.eql([0]);
+        expect(values(c.consumeNewSync())).to.eql([1, 2]);
+        expect(c.consumeNewSync()).to.eql([]);
+
+        p2.release();
+    });
+
+    it('should only let one object resize a generation', function () {
+        const d = new Disruptor('/test_resizable', 4, 4, 1, 0, false, false, { resizable: true });
+        expect(d.setForward(1, 8)).to.be.true;
+        expect(p.resize(16)).to.be.false;
+        expect(d.seal()).to.equal(0);
+        d.release();
+    });
+
+    it('should follow more than one resize', async function () {
+        expect(produce(p, 0, 2)).to.equal(2);
+        expect(p.resize(8)).to.be.true;
+        expect(produce(p, 2, 4)).to.equal(4);
+        expect(p.resize(16)).to.be.true;
+        expect(p.producerGeneration).to.equal(2);
+        expect(produce(p, 4, 6)).to.equal(6);
+
+        const vs = [];
+        while (vs.length < 6) {
+            vs.push(...values((await c.consumeNew()).bufs));
+        }
+        expect(vs).to.eql([0, 1, 2, 3, 4, 5]);
+        expect(c.consumerGeneration).to.equal(2);
+    });
+
+    it('should follow resizes when compressing', function () {
+        expect(p.produceCompressSync('a')).to.be.true;
+        expect(p.resize(8)).to.be.true;
+        // Each record takes 3 elements
+        expect(p.produceCompressSync('b')).to.be.true;
+        expect(p.produceCompressSync('c')).to.be.true;
+        expect(p.producerGeneration).to.equal(1);
+
+        const vs = [];
+        let bufs;
+        while ((bufs = c.consumeDecompressSync()).length > 0) {
+            vs.push(...bufs.map(b => b.toString()));
+        }
+        expect(vs).to.eql(['a', 'b', 'c']);
+        expect(c.consumerGeneration).to.equal(1);
+    });
+
+    it('should unlink generations once they have been read', function () {
+        // Linux keeps POSIX shared memory objects in /dev/shm
+        const linux = process.platform === 'linux';
+        function exists(name) {
+            return !linux || fs.existsSync(`/dev/shm${name}`);
+        }
+        function gone(name) {
+            return !linux || !fs.existsSync(`/dev/shm${name}`);
+        }
+
+        expect(produce(p, 0, 2)).to.equal(2);
+        expect(p.resize(8)).to.be.true;
+
+        // The consumer hasn't read generation 0 yet
+        expect(p.consumer.drained).to.be.false;
+        expect(exists('/test_resizable')).to.be.true;
+        expect(values(c.consumeNewSync())).to.eql([0, 1]);
+        expect(c.consumeNewSync()).to.eql([]);
+        expect(c.consumerGeneration).to.equal(1);
+        expect(gone('/test_resizable')).to.be.true;
+
+        // Nothing to read in generation 1 so it goes straight away
+        expect(p.resize(4)).to.be.true;
+        expect(gone('/test_resizable.1')).to.be.true;
+        expect(exists('/test_resizable.2')).to.be.true;
+
+        // Late joiners open the current generation
+        const p2 = new ResizableDisruptor('/test_resizable', 4, 4, 1, 0, false, false,
+                                          { generation: p.producerGeneration });
+        expect(p2.producerGeneration).to.equal(2);
+        expect(produce(p2, 2, 3)).to.equal(3);
+        expect(values(c.consumeNewSync())).to.eql([2]);
+        expect(c.consumerGeneration).to.equal(2);
+        p2.release();
+
+        expect(Disruptor.unlink('/test_resizable_none')).to.be.false;
+    });
+
+    it('should throw error if generation is out of range', function () {
+        expect(function () {
+            p.producer.setForward(2 ** 32, 8);
+        }).to.throw('invalid generation or size');
+    });
+
+    it('should throw error if not resizable', function () {
+        const d = new Disruptor('/test_resizable2', 4, 4, 1, 0, true, false);
+        expect(d.forward).to.be.null;
+        expect(function () {
+            d.setForward(1, 8);
+        }).to.throw('not resizable');
+        expect(function () {
+            d.seal();
+        }).to.throw('forward not set');
+        d.release();
+    });
+});
@@ -0,0 +1,234 @@
+let expect;
+const { Disruptor, Selector } = require('..');
+
+before(async function () {
+    ({ expect } = await import('chai'));
+});
+
+describe('selector', function () {
+    this.timeout(60000);
+
+    let ds, ps, s;
+
+    beforeEach(function () {
+        ds = [];
+        ps = [];
+        for (let i = 0; i < 3; i += 1) {
+            ds.push(new Disruptor(`/test_selector${i}`, 16, 4, 1, 0, true, false));
+            ps.push(new Disruptor(`/test_selector${i}`, 16, 4, 1, 0, false, false));
+        }
+        s = new Selector();
+        for (const d of ds) {
+            s.add(d);
+        }
+    });
+
+    afterEach(function () {
+        for (const d of ds.concat(ps)) {
+            d.release();
+        }
+    });
+
+    function produce(p, v) {
+        const { buf, claimStart, claimEnd } = p.produceClaimSync();
+        buf.writeUInt32LE(v);
+        expect(p.produceCommitSync(claimStart, claimEnd)).to.be.true;
+    }
+
+    it('should return nothing if no data', function () {
+        expect(s.selectSync()).to.eql([]);
+    });
+
+    it('should return data from rings which have it', function () {
+        produce(ps[0], 10);
+        produce(ps[2], 20);
+        produce(ps[2], 21);
+
+        const r = s.selectSync();
+        expect(r.length).to.equal(2);
+        expect(r[0].disruptor).to.equal(ds[0]);
+        expect(r[0].start).to.equal(0);
+        expect(Buffer.concat(r[0].bufs).readUInt32LE()).to.equal(10);
+        expect(r[1].disruptor).to.equal(ds[2]);
+        expect(r[1].start).to.equal(0);
+        const b = Buffer.concat(r[1].bufs);
+        expect(b.length).to.equal(8);
+        expect(b.readUInt32LE(0)).to.equal(20);
+        expect(b.readUInt32LE(4)).to.equal(21);
+
+        // Previous data is committed
+        expect(s.selectSync()).to.eql([]);
+        expect(ds[0].consumeNewSync()).to.eql([]);
+    });
+
+    it('should ignore duplicates and support removal', function () {
+        s.add(ds[1]);
+        produce(ps[1], 1);
+        expect(s.selectSync().length).to.equal(1);
+
+        s.remove(ds[1]);
+        produce(ps[1], 2);
+        expect(s.selectSync()).to.eql([]);
+
+        s.add(ds[1]);
+        const r = s.selectSync();
+        expect(r.length).to.equal(1);
+        expect(r[0].disruptor).to.equal(ds[1]);
+        expect(r[0].start).to.equal(1);
+    });
+
+    it('should skip released disruptors', async function () {
+        produce(ps[0], 1);
+        produce(ps[1], 2);
+        ds[0].release();
+        const r = await s.select();
+        expect(r.length).to.equal(1);
+        expect(r[0].disruptor).to.equal(ds[1]);
+    });
+
+    it('should stop waiting when cancelled', async function () {
+        const r = s.select();
+        setTimeout(() => s.cancel(), 100);
+        expect(await r).to.eql([]);
+
+        // Waits again afterwards
+        setTimeout(() => produce(ps[1], 1), 100);
+        expect((await s.select())[0].disruptor).to.equal(ds[1]);
+    });
+
+    it('should stop waiting when all disruptors are released', async function () {
+        const r = s.select();
+        setTimeout(() => {
+            for (const d of ds) {
+                d.release();
+            }
+        }, 100);
+        expect(await r).to.eql([]);
+    });
+
+    it('should wait on disruptors added while waiting', async function () {
+        const d = new Disruptor('/test_selector3', 16, 4, 1, 0, true, false);
+        const r = s.select();
+        setTimeout(() => {
+            s.add(d);
+            produce(d, 3);
+        }, 100);
+        expect((await r)[0].disruptor).to.equal(d);
+        d.release();
+    });
+
+    it('should return immediately if empty', async function () {
+        expect(await new Selector().select()).to.eql([]);
+    });
+
+    it('should wait for data', function (done) {
+        s.select(function (err, r) {
+            if (err) { return done(err); }
+            expect(r.length).to.equal(1);
+            expect(r[0].disruptor).to.equal(ds[1]);
+            expect(Buffer.concat(r[0].bufs).readUInt32LE()).to.equal(42);
+
+            // select commits previous data before waiting again
+            s.select(function (err, r) {
+                if (err) { return done(err); }
+                expect(r.length).to.equal(1);
+                expect(r[0].disruptor).to.equal(ds[2]);
+                expect(r[0].start).to.equal(0);
+                expect(ds[1].consumeNewSync()).to.eql([]);
+                done();
+            });
+
+            setTimeout(() => produce(ps[2], 43), 100);
+        });
+
+        setTimeout(() => produce(ps[1], 42), 100);
+    });
+
+    it('should limit number of elements returned', function () {
+        for (let i = 0; i < 5; i += 1) {
+            produce(ps[0], i);
+        }
+
+        let b = Buffer.concat(ds[0].consumeNewSync(2));
+        expect(b.length).to.equal(8);
+        expect(b.readUInt32LE(4)).to.equal(1);
+
+        const s2 = new Selector();
+        s2.add(ds[0], { max: 2 });
+        for (const expected of [[2, 3], [4]]) {
+            const r = s2.selectSync();
+            expect(r.length).to.equal(1);
+            b = Buffer.concat(r[0].bufs);
+            expect(b.length).to.equal(expected.length * 4);
+            for (let i = 0; i < expected.length; i += 1) {
+                expect(b.readUInt32LE(i * 4)).to.equal(expected[i]);
+            }
+            expect(r[0].start).to.equal(expected[0]);
+        }
+        expect(s2.selectSync()).to.eql([]);
+    });
+
+    it('should take turns by weight', function () {
+        for (let i = 0; i < 8; i += 1) {
+            produce(ps[0], i);
+            produce(ps[2], i);
+        }
+        produce(ps[1], 0);
+        produce(ps[1], 1);
+
+        const s2 = new Selector({ policy: 'round-robin', limit: 1 });
+        s2.add(ds[0], { max: 1, weight: 2 });
+        s2.add(ds[1], { max: 1 });
+        s2.add(ds[2], { max: 1, weight: 0 });
+
+        const order = [];
+        for (let i = 0; i < 8; i += 1) {
+            const r = s2.selectSync();
+            expect(r.length).to.equal(1);
+            order.push(ds.indexOf(r[0].disruptor));
+        }
+        expect(order).to.eql([0, 0, 1, 2, 0, 0, 1, 2]);
+
+        // Idle disruptors don't use up turns
+        order.length = 0;
+        for (let i = 0; i < 4; i += 1) {
+            order.push(ds.indexOf(s2.selectSync()[0].disruptor));
+        }
+        expect(order).to.eql([0, 0, 2, 0]);
+    });
+
+    it('should prefer higher priorities', async function () {
+        for (const p of ps) {
+            produce(p, 1);
+        }
+
+        const s2 = new Selector({ policy: 'priority' });
+        s2.add(ds[0]);
+        s2.add(ds[1], { priority: 5 });
+        s2.add(ds[2], { priority: 5 });
+
+        let r = s2.selectSync();
+        expect(r.map(x => ds.indexOf(x.disruptor))).to.eql([1, 2]);
+
+        r = await s2.select();
+        expect(r.map(x => ds.indexOf(x.disruptor))).to.eql([0]);
+
+        produce(ps[2], 2);
+        r = await s2.select();
+        expect(r.map(x => ds.indexOf(x.disruptor))).to.eql([2]);
+        expect(r[0].start).to.equal(1);
+    });
+
+    it('should throw error for unknown policy', function () {
+        expect(function () {
+            new Selector({ policy: 'foo' });
+        }).to.throw('unknown policy');
+    });
+
+    it('should wait using promises', async function () {
+        setTimeout(() => produce(ps[0], 7), 100);
+        const r = await s.select();
+        expect(r.length).to.equal(1);
+        expect(Buffer.concat(r[0].bufs).readUInt32LE()).to.equal(7);
+    });
+});
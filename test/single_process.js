@@ -1130,6 +1130,2027 @@ tests(true, '');
 tests(true, 'Async');
 tests(true, null);
 
+describe('consume batching', function ()
+{
+    let p, d;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 256, 4, 1, 0, true, false);
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        d.release();
+    });
+
+    function produce(n)
+    {
+        for (let i = 0; i < n; i += 1)
+        {
+            expect(p.produceSync(Buffer.alloc(4))).to.be.true;
+        }
+    }
+
+    function count(bufs)
+    {
+        return bufs.reduce((n, b) => n + b.length / 4, 0);
+    }
+
+    function busy(ms)
+    {
+        const end = Date.now() + ms;
+        while (Date.now() < end);
+    }
+
+    it('should limit batch size', function ()
+    {
+        d = new Disruptor('/test', 256, 4, 1, 0, false, false, { maxBatch: 4 });
+        expect(d.batchLimit).to.equal(4);
+        produce(10);
+        expect(d.lag).to.equal(10);
+        expect(count(d.consumeNewSync())).to.equal(4);
+        expect(count(d.consumeNewSync())).to.equal(4);
+        expect(d.consumer).to.equal(4);
+        expect(d.lag).to.equal(6);
+        expect(count(d.consumeNewSync(1))).to.equal(1);
+        expect(count(d.consumeNewSync())).to.equal(1);
+        expect(count(d.consumeNewSync())).to.equal(0);
+        expect(d.lag).to.equal(0);
+    });
+
+    it('should have no limit by default', function ()
+    {
+        d = new Disruptor('/test', 256, 4, 1, 0, false, false);
+        expect(d.batchLimit).to.equal(Infinity);
+        produce(10);
+        expect(count(d.consumeNewSync())).to.equal(10);
+    });
+
+    it('should wait for minimum batch size', function (done)
+    {
+        d = new Disruptor('/test', 256, 4, 1, 0, false, false, { minBatch: 3, minWait: 50000 });
+        produce(1);
+        expect(count(d.consumeNewSync())).to.equal(0);
+        produce(1);
+        expect(count(d.consumeNewSync())).to.equal(0);
+        setTimeout(function ()
+        {
+            expect(count(d.consumeNewSync())).to.equal(2);
+            produce(3);
+            expect(count(d.consumeNewSync())).to.equal(3);
+            done();
+        }, 100);
+    });
+
+    it('should wait asynchronously for minimum batch size', async function ()
+    {
+        d = new Disruptor('/test', 256, 4, 1, 0, false, true, { minBatch: 3, minWait: 50000 });
+        produce(1);
+        const start = Date.now();
+        const { bufs } = await d.consumeNew();
+        expect(count(bufs)).to.equal(1);
+        expect(Date.now() - start).to.be.at.least(40);
+    });
+
+    it('should adapt batch size to processing time', function ()
+    {
+        d = new Disruptor('/test', 256, 4, 1, 0, false, false, { adaptive: true, maxBatch: 100, targetLatency: 1000 });
+        expect(d.batchLimit).to.equal(100);
+
+        produce(20);
+        expect(count(d.consumeNewSync())).to.equal(20);
+        busy(20);
+        expect(d.consumeCommit()).to.be.true;
+        expect(d.batchLimit).to.equal(1);
+
+        produce(10);
+        expect(count(d.consumeNewSync())).to.equal(1);
+
+        for (let i = 0; i < 100; i += 1)
+        {
+            produce(1);
+            d.consumeNewSync();
+            d.consumeCommit();
+        }
+        expect(d.batchLimit).to.be.above(1);
+        expect(d.batchLimit).to.be.at.most(100);
+    });
+});
+
+describe('partial commit', function ()
+{
+    let d;
+
+    beforeEach(function ()
+    {
+        d = new Disruptor('/test', 8, 4, 1, 0, true, false);
+    });
+
+    afterEach(function ()
+    {
+        d.release();
+    });
+
+    it('should commit part of a batch', function ()
+    {
+        expect(d.produceManySync(['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'])).to.be.true;
+        expect(d.produceSync('i')).to.be.false;
+
+        expect(Buffer.concat(d.consumeNewSync()).length).to.equal(32);
+        expect(d.prevConsumeStart).to.equal(0);
+
+        expect(d.consumeCommitUpTo(0)).to.be.true;
+        expect(d.consumer).to.equal(0);
+
+        expect(d.consumeCommitUpTo(3)).to.be.true;
+        expect(d.consumer).to.equal(3);
+        expect(d.prevConsumeStart).to.equal(3);
+        expect(d.produceManySync(['i', 'j', 'k'])).to.be.true;
+        expect(d.produceSync('l')).to.be.false;
+
+        // Already committed
+        expect(d.consumeCommitUpTo(2)).to.be.true;
+        expect(d.consumer).to.equal(3);
+
+        expect(function ()
+        {
+            d.consumeCommitUpTo(9);
+        }).to.throw('sequence not consumed');
+
+        expect(d.consumeCommitUpTo(5)).to.be.true;
+        expect(d.consumer).to.equal(5);
+
+        expect(d.consumeCommit()).to.be.true;
+        expect(d.consumer).to.equal(8);
+
+        const bufs = d.consumeNewSync();
+        expect(Buffer.concat(bufs).toString()).to.equal('i\0\0\0j\0\0\0k\0\0\0');
+        expect(d.consumeCommitUpTo(11)).to.be.true;
+        expect(d.consumer).to.equal(11);
+        expect(d.consumeCommit()).to.be.true;
+        expect(d.consumer).to.equal(11);
+
+        expect(d.consumeCommitUpTo(11)).to.be.true;
+        expect(function ()
+        {
+            d.consumeCommitUpTo(12);
+        }).to.throw('sequence not consumed');
+    });
+
+    it('should return false if consumer moved', function ()
+    {
+        const d2 = new Disruptor('/test', 8, 4, 1, 0, false, false);
+        expect(d.produceManySync(['a', 'b', 'c'])).to.be.true;
+        expect(d.consumeNewSync().length).to.equal(1);
+        expect(d2.consumeNewSync().length).to.equal(1);
+        expect(d2.consumeCommitUpTo(1)).to.be.true;
+        expect(d.consumeCommitUpTo(2)).to.be.false;
+        expect(d.consumeCommit()).to.be.true;
+        expect(d.consumer).to.equal(1);
+        d2.release();
+    });
+});
+
+describe('work pool', function ()
+{
+    let p, ws;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 16, 4, 3, 0, true, false, { pool: true });
+        ws = [];
+        for (let i = 0; i < 3; i += 1)
+        {
+            ws.push(new Disruptor('/test', 16, 4, 3, i, false, false, { pool: true }));
+        }
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        for (let w of ws)
+        {
+            w.release();
+        }
+    });
+
+    function produce(start, n)
+    {
+        const values = [];
+        for (let i = 0; i < n; i += 1)
+        {
+            const b = Buffer.alloc(4);
+            b.writeUInt32LE(start + i);
+            values.push(b);
+        }
+        return p.produceManySync(values);
+    }
+
+    function values(bufs)
+    {
+        let r = [];
+        for (let b of bufs)
+        {
+            for (let i = 0; i < b.length; i += 4)
+            {
+                r.push(b.readUInt32LE(i));
+            }
+        }
+        return r;
+    }
+
+    it('should give each element to one worker', function ()
+    {
+        expect(produce(0, 10)).to.be.true;
+        expect(ws[0].lag).to.equal(10);
+
+        expect(values(ws[0].consumeNewSync(4))).to.eql([0, 1, 2, 3]);
+        expect(ws[0].prevConsumeStart).to.equal(0);
+        expect(ws[1].lag).to.equal(6);
+        expect(values(ws[1].consumeNewSync(4))).to.eql([4, 5, 6, 7]);
+        expect(ws[1].prevConsumeStart).to.equal(4);
+        expect(values(ws[2].consumeNewSync())).to.eql([8, 9]);
+        expect(values(ws[2].consumeNewSync())).to.eql([]);
+        expect(ws[2].lag).to.equal(0);
+
+        // Producers wait for the slowest worker
+        expect(produce(10, 6)).to.be.true;
+        expect(produce(16, 1)).to.be.false;
+        expect(ws[1].consumeCommit()).to.be.true;
+        expect(produce(16, 1)).to.be.false;
+        expect(ws[0].consumeCommitUpTo(2)).to.be.true;
+        expect(produce(16, 2)).to.be.true;
+        expect(produce(18, 1)).to.be.false;
+
+        expect(values(ws[1].consumeNewSync())).to.eql([10, 11, 12, 13, 14, 15, 16, 17]);
+        expect(values(ws[0].consumeNewSync())).to.eql([]);
+        expect(values(ws[2].consumeNewSync())).to.eql([]);
+        expect(ws[1].consumeCommit()).to.be.true;
+        expect(produce(18, 16)).to.be.true;
+    });
+
+    it('should work with a selector', function ()
+    {
+        const { Selector } = require('..');
+        const s = new Selector();
+        s.add(ws[0]);
+        expect(s.selectSync()).to.eql([]);
+        expect(produce(0, 2)).to.be.true;
+        expect(values(ws[1].consumeNewSync(1))).to.eql([0]);
+        const r = s.selectSync();
+        expect(r.length).to.equal(1);
+        expect(values(r[0].bufs)).to.eql([1]);
+    });
+
+    it('should not rewind', function ()
+    {
+        expect(function ()
+        {
+            ws[0].consumeRewind(1);
+        }).to.throw("can't rewind in pool mode");
+    });
+
+    it('should not allow overwrite', function ()
+    {
+        expect(function ()
+        {
+            new Disruptor('/test', 16, 4, 3, 0, false, false, { pool: true, overwrite: true });
+        }).to.throw("overwrite and pool can't be used together");
+    });
+});
+
+describe('timeouts and backpressure', function ()
+{
+    let p, c;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 4, 4, 2, 0, true, true, { timeout: 20000 });
+        c = new Disruptor('/test', 4, 4, 2, 1, false, true, { timeout: 20000 });
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        c.release();
+    });
+
+    it('should time out claiming when full', function ()
+    {
+        expect(p.timeout).to.equal(20000);
+        expect(p.produceClaimManySync(4).length).to.equal(1);
+        expect(p.produceCommitSync()).to.be.true;
+
+        let start = Date.now();
+        expect(p.produceClaimSync().length).to.equal(0);
+        expect(Date.now() - start).to.be.at.least(19);
+
+        start = Date.now();
+        expect(p.produceClaimManySync(1)).to.eql([]);
+        expect(p.produceClaimAvailSync(1)).to.eql([]);
+        expect(p.produceSync(Buffer.alloc(4))).to.be.false;
+        expect(Date.now() - start).to.be.at.least(59);
+        expect(p.prevClaimStart).to.equal(1);
+        expect(p.prevClaimEnd).to.equal(0);
+    });
+
+    it('should time out waiting for other producers to commit', function ()
+    {
+        const p2 = new Disruptor('/test', 4, 4, 2, 0, false, true, { timeout: 20000 });
+        expect(p2.produceClaimSync().length).to.equal(4);
+
+        const start = Date.now();
+        expect(function ()
+        {
+            p.produceSync(Buffer.alloc(4));
+        }).to.throw('timed out waiting for other producers to commit');
+        expect(Date.now() - start).to.be.at.least(19);
+
+        // Left for produceCommit
+        expect(p.prevClaimStart).to.equal(1);
+        expect(p2.produceCommitSync()).to.be.true;
+        expect(p.produceCommitSync()).to.be.true;
+        expect(p.cursor).to.equal(2);
+        p2.release();
+    });
+
+    it('should time out consuming when empty', function ()
+    {
+        const start = Date.now();
+        expect(c.consumeNewSync()).to.eql([]);
+        expect(Date.now() - start).to.be.at.least(19);
+    });
+
+    it('should time out asynchronously', async function ()
+    {
+        expect(p.produceClaimManySync(4).length).to.equal(1);
+        expect(p.produceCommitSync()).to.be.true;
+
+        let start = Date.now();
+        expect((await p.produceClaim()).buf.length).to.equal(0);
+        expect((await p.produceClaimMany(1)).bufs).to.eql([]);
+        expect((await p.produceClaimAvail(1)).bufs).to.eql([]);
+        expect(Date.now() - start).to.be.at.least(59);
+
+        const c2 = new Disruptor('/test', 4, 4, 2, 1, false, true, { timeout: 20000 });
+        expect((await c2.consumeNew()).bufs.length).to.equal(1);
+        c2.consumeCommit();
+        start = Date.now();
+        expect((await c2.consumeNew()).bufs).to.eql([]);
+        expect(Date.now() - start).to.be.at.least(19);
+        c2.release();
+    });
+
+    it('should change timeout', function ()
+    {
+        p.timeout = 1000;
+        expect(p.timeout).to.equal(1000);
+        p.produceClaimManySync(4);
+        p.produceCommitSync();
+        const start = Date.now();
+        expect(p.produceClaimSync().length).to.equal(0);
+        expect(Date.now() - start).to.be.below(19);
+    });
+
+    it('should report fill level', function ()
+    {
+        expect(p.fill).to.equal(0);
+        expect(p.produceSync(Buffer.alloc(4))).to.be.true;
+        expect(p.produceSync(Buffer.alloc(4))).to.be.true;
+        expect(p.fill).to.equal(2);
+
+        expect(c.consumeNewSync(1).length).to.equal(1);
+        expect(c.consumeCommit()).to.be.true;
+        // Consumer 0 hasn't read anything
+        expect(p.fill).to.equal(2);
+
+        expect(p.consumeNewSync().length).to.equal(1);
+        expect(p.consumeCommit()).to.be.true;
+        expect(p.fill).to.equal(1);
+
+        // Claimed elements count too
+        expect(p.produceClaimSync().length).to.equal(4);
+        expect(p.fill).to.equal(2);
+        expect(p.produceCommitSync()).to.be.true;
+    });
+
+    it('should call back at watermarks', function (done)
+    {
+        const calls = [];
+
+        p.watermarks({ high: 3, low: 1, interval: 1 }, (high, fill) =>
+        {
+            calls.push([high, fill]);
+
+            if (high)
+            {
+                expect(fill).to.be.at.least(3);
+                p.consumeNewSync();
+                c.consumeNewSync();
+                p.consumeCommit();
+                c.consumeCommit();
+            }
+            else
+            {
+                expect(calls).to.eql([[true, 3], [false, 0]]);
+                p.watermarks();
+                done();
+            }
+        });
+
+        for (let i = 0; i < 3; i += 1)
+        {
+            expect(p.produceSync(Buffer.alloc(4))).to.be.true;
+        }
+    });
+});
+
+describe('file descriptors', function ()
+{
+    const fs = require('fs');
+    const os = require('os');
+    const path = require('path');
+
+    let d, dir;
+
+    beforeEach(function ()
+    {
+        d = new Disruptor('/test', 16, 4, 1, 0, true, false);
+        dir = fs.mkdtempSync(path.join(os.tmpdir(), 'disruptor-'));
+    });
+
+    afterEach(function ()
+    {
+        d.release();
+        fs.rmSync(dir, { recursive: true });
+    });
+
+    function tmp(name, data)
+    {
+        const file = path.join(dir, name);
+        fs.writeFileSync(file, data);
+        return file;
+    }
+
+    it('should read from a file into the Disruptor', function ()
+    {
+        const data = crypto.randomBytes(80);
+        const fd = fs.openSync(tmp('in', data), 'r');
+
+        expect(d.produceFromSync(fd, 10)).to.equal(40);
+        expect(d.produceFromSync(fd)).to.equal(24);
+        // Full
+        expect(d.produceFromSync(fd)).to.equal(-1);
+
+        expect(Buffer.concat(d.consumeNewSync()).equals(data.subarray(0, 64))).to.be.true;
+        d.consumeCommit();
+
+        expect(d.produceFromSync(fd)).to.equal(16);
+        expect(Buffer.concat(d.consumeNewSync()).equals(data.subarray(64))).to.be.true;
+        d.consumeCommit();
+
+        // End of file
+        expect(d.produceFromSync(fd)).to.equal(0);
+        expect(d.consumeNewSync()).to.eql([]);
+        fs.closeSync(fd);
+    });
+
+    it('should zero the rest of a partly read element', function ()
+    {
+        const fd = fs.openSync(tmp('in', Buffer.from([1, 2, 3, 4, 5, 6])), 'r');
+        expect(d.produceFromSync(fd)).to.equal(6);
+        expect(Buffer.concat(d.consumeNewSync()).equals(
+            Buffer.from([1, 2, 3, 4, 5, 6, 0, 0]))).to.be.true;
+        fs.closeSync(fd);
+    });
+
+    it('should leave a partly read element claimed if there is no more data', function ()
+    {
+        const fifo = path.join(dir, 'fifo');
+        require('child_process').execFileSync('mkfifo', [fifo]);
+        const fd = fs.openSync(fifo, fs.constants.O_RDONLY | fs.constants.O_NONBLOCK);
+        const wfd = fs.openSync(fifo, 'w');
+
+        // No data, all elements given back
+        expect(d.produceFromSync(fd)).to.equal(-1);
+        expect(d.prevClaimStart).to.be.above(d.prevClaimEnd);
+
+        fs.writeSync(wfd, Buffer.from([1, 2, 3, 4, 5, 6]));
+        expect(d.produceFromSync(fd)).to.equal(6);
+        expect(d.prevClaimStart).to.equal(1);
+        expect(d.prevClaimEnd).to.equal(1);
+
+        // Only the filled element was committed
+        expect(Buffer.concat(d.consumeNewSync()).equals(
+            Buffer.from([1, 2, 3, 4]))).to.be.true;
+        d.consumeCommit();
+
+        expect(function ()
+        {
+            d.produceFromSync(fd);
+        }).to.throw('claim pending');
+
+        fs.writeSync(wfd, Buffer.from([7, 8]));
+        const bufs = d.produceRecover(d.prevClaimStart, d.prevClaimEnd);
+        expect(fs.readSync(fd, bufs[0], 2, 2)).to.equal(2);
+        expect(d.produceCommitSync()).to.be.true;
+        expect(Buffer.concat(d.consumeNewSync()).equals(
+            Buffer.from([5, 6, 7, 8]))).to.be.true;
+
+        fs.closeSync(wfd);
+        fs.closeSync(fd);
+    });
+
+    it('should wrap around the end of the ring', function ()
+    {
+        for (let i = 0; i < 12; i += 1)
+        {
+            expect(d.produceSync(Buffer.alloc(4))).to.be.true;
+        }
+        d.consumeNewSync();
+        d.consumeCommit();
+
+        const data = crypto.randomBytes(64);
+        const fd = fs.openSync(tmp('in', data), 'r');
+        expect(d.produceFromSync(fd)).to.equal(64);
+        const bufs = d.readAt(12, 16);
+        expect(bufs.length).to.equal(2);
+        expect(Buffer.concat(bufs).equals(data)).to.be.true;
+        fs.closeSync(fd);
+
+        const out = path.join(dir, 'out');
+        const fd2 = fs.openSync(out, 'w');
+        expect(d.consumeToSync(fd2)).to.equal(64);
+        expect(d.consumeToSync(fd2)).to.equal(0);
+        fs.closeSync(fd2);
+        expect(fs.readFileSync(out).equals(data)).to.be.true;
+    });
+
+    it('should write from the Disruptor to a file', function ()
+    {
+        const data = crypto.randomBytes(40);
+        expect(d.produceSync(data)).to.be.true;
+
+        const out = path.join(dir, 'out');
+        const fd = fs.openSync(out, 'w');
+        expect(d.consumeToSync(fd, 3)).to.equal(12);
+        expect(d.lag).to.equal(7);
+        expect(d.consumeToSync(fd)).to.equal(28);
+        expect(d.lag).to.equal(0);
+        expect(d.consumeToSync(fd)).to.equal(0);
+        fs.closeSync(fd);
+
+        expect(fs.readFileSync(out).equals(data)).to.be.true;
+    });
+
+    it('should throw error if read or write fails', function ()
+    {
+        const fd = fs.openSync(tmp('in', 'hello'), 'r');
+
+        expect(function ()
+        {
+            d.produceFromSync(-1);
+        }).to.throw('Failed to read');
+
+        // Elements were given back
+        expect(d.produceFromSync(fd)).to.equal(5);
+
+        expect(function ()
+        {
+            d.consumeToSync(fd);
+        }).to.throw('Failed to write');
+
+        // Elements will be returned again
+        expect(d.lag).to.equal(2);
+        expect(Buffer.concat(d.consumeNewSync()).toString()).to.equal('hello\0\0\0');
+        fs.closeSync(fd);
+    });
+});
+
+describe('promises', function ()
+{
+    let d;
+
+    beforeEach(function ()
+    {
+        d = new Disruptor('/test', 4, 4, 1, 0, true, true);
+    });
+
+    afterEach(function ()
+    {
+        d.release();
+    });
+
+    it('should resolve to result objects', async function ()
+    {
+        let p = d.produceClaim();
+        expect(p).to.be.an.instanceof(Promise);
+        const r = await p;
+        expect(Object.keys(r)).to.eql(['buf', 'claimStart', 'claimEnd', 'allConsumersIgnoring']);
+        expect(r.buf.length).to.equal(4);
+        expect(r.claimStart).to.equal(0);
+        expect(r.claimEnd).to.equal(0);
+        expect(r.allConsumersIgnoring).to.equal(false);
+        expect(await d.produceCommit(r.claimStart, r.claimEnd)).to.be.true;
+
+        const r2 = await d.produceClaimMany(2);
+        expect(Object.keys(r2)).to.eql(['bufs', 'claimStart', 'claimEnd', 'allConsumersIgnoring']);
+        expect(r2.claimStart).to.equal(1);
+        expect(r2.claimEnd).to.equal(2);
+        expect(await d.produceCommit()).to.be.true;
+
+        const r3 = await d.produceClaimAvail(10);
+        expect(r3.claimStart).to.equal(3);
+        expect(r3.claimEnd).to.equal(3);
+        expect(await d.produceCommit()).to.be.true;
+
+        const r4 = await d.consumeNew();
+        expect(Object.keys(r4)).to.eql(['bufs', 'start']);
+        expect(r4.start).to.equal(0);
+        expect(Buffer.concat(r4.bufs).length).to.equal(16);
+    });
+
+    it('should resolve once the worker finishes', async function ()
+    {
+        const p = d.consumeNew();
+        expect(p).to.be.an.instanceof(Promise);
+        setTimeout(() => {
+            expect(d.produceSync(Buffer.alloc(4, 1))).to.be.true;
+        }, 50);
+        const { bufs, start } = await p;
+        expect(start).to.equal(0);
+        expect(Buffer.concat(bufs).equals(Buffer.alloc(4, 1))).to.be.true;
+        d.consumeCommit();
+
+        for (let i = 0; i < 4; i += 1)
+        {
+            expect(d.produceSync(Buffer.alloc(4))).to.be.true;
+        }
+        const p2 = d.produceClaim();
+        setTimeout(() => {
+            d.consumeNewSync();
+            d.consumeCommit();
+        }, 50);
+        const { buf, claimStart, claimEnd, allConsumersIgnoring } = await p2;
+        expect(buf.length).to.equal(4);
+        expect(claimStart).to.equal(5);
+        expect(claimEnd).to.equal(5);
+        expect(allConsumersIgnoring).to.equal(false);
+        expect(await d.produceCommit()).to.be.true;
+    });
+});
+
+describe('async iterator', function ()
+{
+    let p, d;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 16, 4, 1, 0, true, false);
+        d = new Disruptor('/test', 16, 4, 1, 0, false, true);
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        d.release();
+    });
+
+    function produce(start, n)
+    {
+        for (let i = start; i < start + n; i += 1)
+        {
+            const b = Buffer.alloc(4);
+            b.writeUInt32LE(i);
+            expect(p.produceSync(b)).to.be.true;
+        }
+    }
+
+    function values(bufs)
+    {
+        let r = [];
+        for (let b of bufs)
+        {
+            for (let i = 0; i < b.length; i += 4)
+            {
+                r.push(b.readUInt32LE(i));
+            }
+        }
+        return r;
+    }
+
+    it('should yield batches and commit them', async function ()
+    {
+        produce(0, 3);
+        setTimeout(() => produce(3, 2), 50);
+
+        const seen = [];
+        for await (const { bufs, start } of d)
+        {
+            expect(start).to.equal(seen.length);
+            seen.push(...values(bufs));
+            // Previous batches are committed
+            expect(d.consumers.readUInt32LE(0)).to.equal(start);
+            if (seen.length === 5)
+            {
+                break;
+            }
+        }
+
+        expect(seen).to.eql([0, 1, 2, 3, 4]);
+        // Last batch committed on leaving the loop
+        expect(d.lag).to.equal(0);
+    });
+
+    it('should limit batch size', async function ()
+    {
+        produce(0, 10);
+
+        const batches = [];
+        for await (const { bufs } of d.batches(4))
+        {
+            batches.push(values(bufs));
+            if (batches.length === 3)
+            {
+                break;
+            }
+        }
+
+        expect(batches).to.eql([[0, 1, 2, 3], [4, 5, 6, 7], [8, 9]]);
+    });
+
+    it('should wait for the next batch while processing', async function ()
+    {
+        produce(0, 1);
+
+        let first = true;
+        for await (const { bufs } of d)
+        {
+            if (first)
+            {
+                expect(values(bufs)).to.eql([0]);
+                // Produce while we're still processing this batch
+                produce(1, 1);
+                await new Promise(resolve => setTimeout(resolve, 20));
+                first = false;
+            }
+            else
+            {
+                expect(values(bufs)).to.eql([1]);
+                break;
+            }
+        }
+    });
+
+    it('should resolve consumeWait', async function ()
+    {
+        const w = d.consumeWait();
+        setTimeout(() => produce(0, 1), 20);
+        expect(await w).to.be.true;
+        expect(values(d.consumeNewSync())).to.eql([0]);
+
+        // Waits for data after the pending batch
+        const w2 = d.consumeWait();
+        d.consumeWaitCancel();
+        expect(await w2).to.be.false;
+
+        // Doesn't spin when told not to
+        d.consumeCommit();
+        expect(d.consumeNewSync(0, false)).to.eql([]);
+    });
+
+    it('should not commit a batch when thrown into', async function ()
+    {
+        produce(0, 2);
+
+        const it = d.batches();
+        expect(values((await it.next()).value.bufs)).to.eql([0, 1]);
+        let err;
+        try
+        {
+            await it.throw(new Error('failed'));
+        }
+        catch (ex)
+        {
+            err = ex;
+        }
+        expect(err.message).to.equal('failed');
+        expect(d.lag).to.equal(2);
+
+        d.consumeRewind(0);
+        expect(values(d.consumeNewSync())).to.eql([0, 1]);
+    });
+
+    it('should wait for minimum batch size without spinning', async function ()
+    {
+        const d2 = new Disruptor('/test', 16, 4, 1, 0, false, false, { minBatch: 3, minWait: 50000 });
+        produce(0, 1);
+
+        let ticks = 0;
+        let ticking = true;
+        (async function ()
+        {
+            while (ticking)
+            {
+                ticks += 1;
+                await new Promise(resolve => setImmediate(resolve));
+            }
+        })();
+
+        const start = Date.now();
+        for await (const { bufs } of d2)
+        {
+            expect(values(bufs)).to.eql([0]);
+            break;
+        }
+        ticking = false;
+        expect(Date.now() - start).to.be.at.least(40);
+        // The event loop wasn't starved while waiting
+        expect(ticks).to.be.above(1);
+        d2.release();
+    });
+
+    it('should end when released', async function ()
+    {
+        const d2 = new Disruptor('/test', 16, 4, 1, 0, false, false);
+        setTimeout(() => d2.release(), 20);
+        let n = 0;
+        for await (const b of d2)
+        {
+            n += b.bufs.length;
+        }
+        expect(n).to.equal(0);
+    });
+});
+
+describe('columnar layout', function ()
+{
+    const columns = { price: 'float64', qty: 'uint32', side: 'int8' };
+    let p, d;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 8, 0, 1, 0, true, false, { columns });
+        d = new Disruptor('/test', 8, 0, 1, 0, false, false, { columns });
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        d.release();
+    });
+
+    function produce(start, n)
+    {
+        const bufs = p.produceClaimManySync(n);
+        expect(bufs.length).to.equal(n);
+        const cols = p.columnsAt(p.prevClaimStart, n);
+        let v = start;
+        for (let i = 0; i < cols.price.length; i += 1)
+        {
+            for (let j = 0; j < cols.price[i].length; j += 1)
+            {
+                cols.price[i][j] = v + 0.5;
+                cols.qty[i][j] = v * 10;
+                cols.side[i][j] = v % 2 ? -1 : 1;
+                v += 1;
+            }
+        }
+        expect(p.produceCommitSync(p.prevClaimStart, p.prevClaimEnd)).to.be.true;
+    }
+
+    function values(cols)
+    {
+        const r = { price: [], qty: [], side: [] };
+        for (const name of Object.keys(r))
+        {
+            for (const a of cols[name])
+            {
+                r[name].push(...a);
+            }
+        }
+        return r;
+    }
+
+    it('should expose typed arrays over each column', function ()
+    {
+        const cols = d.columns;
+        expect(Object.keys(cols)).to.eql(['price', 'qty', 'side']);
+        expect(cols.price).to.be.an.instanceof(Float64Array);
+        expect(cols.qty).to.be.an.instanceof(Uint32Array);
+        expect(cols.side).to.be.an.instanceof(Int8Array);
+        for (const name of Object.keys(cols))
+        {
+            expect(cols[name].length).to.equal(8);
+            expect(cols[name].byteOffset % 64).to.equal(cols.price.byteOffset % 64);
+        }
+
+        const d2 = new Disruptor('/test', 8, 0, 1, 0, false, false);
+        expect(d2.columns).to.eql({});
+        d2.release();
+    });
+
+    it('should read fields of consumed elements', function ()
+    {
+        produce(0, 3);
+        const bufs = d.consumeNewSync();
+        expect(bufs.length).to.equal(3);
+        expect(values(d.columnsAt(d.prevConsumeStart, bufs.length))).to.eql({
+            price: [0.5, 1.5, 2.5],
+            qty: [0, 10, 20],
+            side: [1, -1, 1]
+        });
+        expect(d.consumeCommit()).to.be.true;
+    });
+
+    it('should wrap around the end of the ring', function ()
+    {
+        produce(0, 6);
+        d.consumeNewSync();
+        d.consumeCommit();
+
+        produce(6, 5);
+        const bufs = d.consumeNewSync();
+        expect(bufs.length).to.equal(5);
+        const cols = d.columnsAt(d.prevConsumeStart, bufs.length);
+        expect(cols.qty.length).to.equal(2);
+        expect(cols.qty[0].length).to.equal(2);
+        expect(cols.qty[1].length).to.equal(3);
+        expect(values(cols).qty).to.eql([60, 70, 80, 90, 100]);
+        expect(d.columns.qty[0]).to.equal(80);
+    });
+
+    it('should throw error if column type is unknown', function ()
+    {
+        expect(function ()
+        {
+            new Disruptor('/test', 8, 0, 1, 0, true, false, { columns: { x: 'int128' } });
+        }).to.throw('unknown column type: int128');
+
+        expect(function ()
+        {
+            new Disruptor('/test', 8, 0, 1, 0, true, false, { columns: 'price' });
+        }).to.throw('columns must be an object');
+    });
+
+    it('should throw error if columns are in a different order', function ()
+    {
+        expect(function ()
+        {
+            new Disruptor('/test', 8, 0, 1, 0, false, false, { columns: { qty: 'uint32', price: 'float64', side: 'int8' } });
+        }).to.throw("columns don't match");
+    });
+
+    it('should throw error copying bytes when element_size is 0', function ()
+    {
+        expect(function ()
+        {
+            p.produceSync(Buffer.alloc(4));
+        }).to.throw('element_size is 0');
+        expect(function ()
+        {
+            p.produceManySync([Buffer.alloc(4)]);
+        }).to.throw('element_size is 0');
+        expect(function ()
+        {
+            p.produceFromSync(0);
+        }).to.throw('element_size is 0');
+        expect(function ()
+        {
+            d.consumeToSync(1);
+        }).to.throw('element_size is 0');
+        expect(function ()
+        {
+            p.produceCompressSync(Buffer.alloc(4));
+        }).to.throw('element_size is 0');
+        expect(function ()
+        {
+            d.consumeDecompressSync();
+        }).to.throw('element_size is 0');
+    });
+});
+
+describe('aggregate kernels', function ()
+{
+    let p, d;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 16, 16, 1, 0, true, false, { columns: { px: 'float32' } });
+        d = new Disruptor('/test', 16, 16, 1, 0, false, false, { columns: { px: 'float32' } });
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        d.release();
+    });
+
+    // Each element holds an int16 at 0, a uint32 at 4 and a biguint64 at 8
+    function produce(values)
+    {
+        const bufs = p.produceClaimManySync(values.length);
+        const cols = p.columnsAt(p.prevClaimStart, values.length);
+        let i = 0;
+        for (let b = 0; b < bufs.length; b += 1)
+        {
+            for (let j = 0; j < bufs[b].length; j += 16, i += 1)
+            {
+                bufs[b].writeInt16LE(values[i] - 5, j);
+                bufs[b].writeUInt32LE(values[i], j + 4);
+                bufs[b].writeBigUInt64LE(BigInt(values[i]) * 1000000000000n, j + 8);
+            }
+        }
+        i = 0;
+        for (const a of cols.px)
+        {
+            for (let j = 0; j < a.length; j += 1, i += 1)
+            {
+                a[j] = values[i] / 2;
+            }
+        }
+        expect(p.produceCommitSync(p.prevClaimStart, p.prevClaimEnd)).to.be.true;
+    }
+
+    it('should aggregate consumed elements', function ()
+    {
+        produce([3, 1, 4, 1, 5]);
+        expect(d.consumeNewSync().length).to.equal(1);
+
+        expect(d.aggregate({ offset: 4, type: 'uint32' })).to.eql({
+            elements: 5, count: 5, sum: 14, min: 1, max: 5
+        });
+        expect(d.aggregate({ type: 'int16' })).to.eql({
+            elements: 5, count: 5, sum: -11, min: -4, max: 0
+        });
+        expect(d.aggregate({ offset: 8, type: 'biguint64' })).to.eql({
+            elements: 5, count: 5, sum: 14000000000000n, min: 1000000000000n, max: 5000000000000n
+        });
+        expect(d.aggregate('px')).to.eql({
+            elements: 5, count: 5, sum: 7, min: 0.5, max: 2.5
+        });
+    });
+
+    it('should filter values', function ()
+    {
+        produce([3, 1, 4, 1, 5]);
+        d.consumeNewSync();
+
+        const field = { offset: 4, type: 'uint32' };
+        expect(d.aggregate(field, { op: 'eq', value: 1 })).to.eql({
+            elements: 5, count: 2, sum: 2, min: 1, max: 1
+        });
+        expect(d.aggregate(field, { op: 'gt', value: 3 })).to.eql({
+            elements: 5, count: 2, sum: 9, min: 4, max: 5
+        });
+        expect(d.aggregate(field, { op: 'ge', value: 3 }).count).to.equal(3);
+        expect(d.aggregate(field, { op: 'lt', value: 3 }).count).to.equal(2);
+        expect(d.aggregate(field, { op: 'le', value: 3 }).count).to.equal(3);
+        expect(d.aggregate(field, { op: 'ne', value: 1 }).count).to.equal(3);
+        expect(d.aggregate(field, { op: 'gt', value: 5 })).to.eql({
+            elements: 5, count: 0, sum: 0, min: null, max: null
+        });
+        expect(d.aggregate({ offset: 8, type: 'biguint64' },
+                           { op: 'lt', value: 2000000000000n }).count).to.equal(2);
+    });
+
+    it('should consume without buffers across the wrap', function ()
+    {
+        const values = [];
+        for (let i = 0; i < 12; i += 1)
+        {
+            values.push(i);
+        }
+        produce(values);
+        expect(d.consumeAggregateSync('px', undefined, 10).elements).to.equal(10);
+        expect(d.consumeCommit()).to.be.true;
+
+        // Slots 12..19 wrap around the end of the ring
+        produce([12, 13, 14, 15, 16, 17, 18, 19]);
+        const r = d.consumeAggregateSync({ offset: 4, type: 'uint32' });
+        expect(r).to.eql({ elements: 10, count: 10, sum: 145, min: 10, max: 19 });
+        expect(d.prevConsumeStart).to.equal(10);
+        expect(d.aggregate('px').sum).to.equal(72.5);
+
+        // Committed by the next call
+        expect(d.consumeAggregateSync('px')).to.eql({
+            elements: 0, count: 0, sum: 0, min: null, max: null
+        });
+        expect(d.lag).to.equal(0);
+    });
+
+    it('should throw error if field or filter is invalid', function ()
+    {
+        expect(function ()
+        {
+            d.aggregate({ offset: 14, type: 'uint32' });
+        }).to.throw('field out of range');
+
+        expect(function ()
+        {
+            d.aggregate({ type: 'int128' });
+        }).to.throw('unknown field type: int128');
+
+        expect(function ()
+        {
+            d.aggregate('qty');
+        }).to.throw('unknown column: qty');
+
+        expect(function ()
+        {
+            d.aggregate('px', { op: 'like', value: 1 });
+        }).to.throw('unknown filter op: like');
+
+        expect(function ()
+        {
+            d.aggregate({ type: 'uint8' }, { op: 'eq', value: 256 });
+        }).to.throw('filter value out of range');
+
+        expect(function ()
+        {
+            d.aggregate({ type: 'bigint64' }, { op: 'eq', value: 1 });
+        }).to.throw('filter value out of range');
+    });
+});
+
+describe('compression', function ()
+{
+    let p, d;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 32, 64, 1, 0, true, false);
+        d = new Disruptor('/test', 32, 64, 1, 0, false, false);
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        d.release();
+    });
+
+    function json(n)
+    {
+        const r = [];
+        for (let i = 0; i < n; i += 1)
+        {
+            r.push({ id: i, name: 'widget', price: 1.5, tags: ['a', 'b'] });
+        }
+        return Buffer.from(JSON.stringify(r));
+    }
+
+    it('should compress and decompress records', function ()
+    {
+        const records = [json(40), crypto.randomBytes(100), Buffer.alloc(0), 'hello'];
+        expect(records[0].length).to.be.above(32 * 64);
+
+        for (const r of records)
+        {
+            expect(p.produceCompressSync(r)).to.be.true;
+        }
+        // Incompressible data is stored as it is
+        expect(p.next).to.be.below(16);
+
+        const bufs = d.consumeDecompressSync();
+        expect(bufs.length).to.equal(4);
+        expect(bufs[0].equals(records[0])).to.be.true;
+        expect(bufs[1].equals(records[1])).to.be.true;
+        expect(bufs[2].length).to.equal(0);
+        expect(bufs[3].toString()).to.equal('hello');
+
+        // Committed straight away
+        expect(d.lag).to.equal(0);
+        expect(d.consumeDecompressSync()).to.eql([]);
+    });
+
+    it('should decompress records which wrap around', function ()
+    {
+        for (let i = 0; i < 20; i += 1)
+        {
+            const records = [json(i), crypto.randomBytes(i * 10), json(i * 2)];
+            for (const r of records)
+            {
+                expect(p.produceCompressSync(r)).to.be.true;
+            }
+            const bufs = d.consumeDecompressSync();
+            expect(bufs.length).to.equal(3);
+            for (let j = 0; j < 3; j += 1)
+            {
+                expect(bufs[j].equals(records[j])).to.be.true;
+            }
+        }
+        expect(p.next).to.be.above(32);
+    });
+
+    it('should read whole records even if they go over the limit', function ()
+    {
+        const data = crypto.randomBytes(100);
+        expect(p.produceCompressSync(data)).to.be.true;
+        expect(p.produceCompressSync('hello')).to.be.true;
+        expect(p.next).to.equal(3);
+
+        let bufs = d.consumeDecompressSync(1);
+        expect(bufs.length).to.equal(1);
+        expect(bufs[0].equals(data)).to.be.true;
+        expect(d.lag).to.equal(1);
+
+        bufs = d.consumeDecompressSync(1);
+        expect(bufs.length).to.equal(1);
+        expect(bufs[0].toString()).to.equal('hello');
+        expect(d.lag).to.equal(0);
+    });
+
+    it('should give each pool worker whole records', function ()
+    {
+        const w1 = new Disruptor('/test_pool', 32, 64, 2, 0, true, false, { pool: true, maxBatch: 1 });
+        const w2 = new Disruptor('/test_pool', 32, 64, 2, 1, false, false, { pool: true, maxBatch: 1 });
+        const data = crypto.randomBytes(100);
+        expect(w1.produceCompressSync(data)).to.be.true;
+        expect(w1.produceCompressSync('hello')).to.be.true;
+
+        const bufs = w1.consumeDecompressSync();
+        expect(bufs.length).to.equal(1);
+        expect(bufs[0].equals(data)).to.be.true;
+        expect(w2.consumeDecompressSync()[0].toString()).to.equal('hello');
+        expect(w1.corruptRecords + w2.corruptRecords).to.equal(0);
+
+        w1.release();
+        w2.release();
+    });
+
+    it('should throw error if data is too large', function ()
+    {
+        expect(function ()
+        {
+            p.produceCompressSync(crypto.randomBytes(32 * 64));
+        }).to.throw('data too large');
+    });
+
+    it('should count corrupt records and return the others', function ()
+    {
+        expect(p.produceCompressSync('hello')).to.be.true;
+        const b = crypto.randomBytes(64);
+        b.writeUInt32LE(50, 0);
+        b.writeUInt32LE(1000, 4);
+        b[8] = 0;
+        expect(p.produceSync(b)).to.be.true;
+        expect(p.produceCompressSync('lost')).to.be.true;
+
+        const bufs = d.consumeDecompressSync();
+        expect(bufs.length).to.equal(1);
+        expect(bufs[0].toString()).to.equal('hello');
+        expect(d.corruptRecords).to.equal(1);
+
+        // The rest of the batch is skipped
+        expect(d.lag).to.equal(0);
+        expect(p.produceCompressSync('world')).to.be.true;
+        expect(d.consumeDecompressSync()[0].toString()).to.equal('world');
+    });
+
+    it('should count records too big for their stored bytes as corrupt', function ()
+    {
+        const b = Buffer.alloc(64);
+        b.writeUInt32LE(10, 0);
+        b.writeUInt32LE(0xffffffff, 4);
+        expect(p.produceSync(b)).to.be.true;
+
+        expect(d.consumeDecompressSync()).to.eql([]);
+        expect(d.corruptRecords).to.equal(1);
+    });
+
+    it('should limit record size', function ()
+    {
+        const p2 = new Disruptor('/test', 32, 64, 1, 0, false, false, { maxRecordSize: 4 });
+        const d2 = new Disruptor('/test', 32, 64, 1, 0, false, false, { maxRecordSize: 4 });
+
+        expect(function ()
+        {
+            p2.produceCompressSync('hello');
+        }).to.throw('data too large');
+        expect(p2.produceCompressSync('hi')).to.be.true;
+        expect(p.produceCompressSync('hello')).to.be.true;
+
+        const bufs = d2.consumeDecompressSync();
+        expect(bufs.length).to.equal(1);
+        expect(bufs[0].toString()).to.equal('hi');
+        expect(d2.corruptRecords).to.equal(1);
+
+        p2.release();
+        d2.release();
+    });
+});
+
+describe('checksums', function ()
+{
+    let p, d;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 8, 8, 1, 0, true, false, { checksum: true });
+        d = new Disruptor('/test', 8, 8, 1, 0, false, false, { checksum: true });
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        d.release();
+    });
+
+    it('should verify data on consume', function ()
+    {
+        for (let i = 0; i < 12; i += 1)
+        {
+            expect(p.produceSync(Buffer.from(`value${i}`))).to.be.true;
+            if (i === 5)
+            {
+                expect(d.consumeNewSync().length).to.equal(1);
+                expect(d.verifyChecksums()).to.equal(0);
+                expect(d.consumeCommit()).to.be.true;
+            }
+        }
+
+        // Slots wrap around
+        expect(d.consumeNewSync().length).to.equal(2);
+        expect(d.verifyChecksums()).to.equal(0);
+        expect(d.checksumErrors).to.equal(0);
+    });
+
+    it('should count corrupt slots', function ()
+    {
+        for (let i = 0; i < 4; i += 1)
+        {
+            expect(p.produceSync(Buffer.from(`value${i}`))).to.be.true;
+        }
+
+        // Overwrite slot 2 without updating its checksum
+        p.elements[2 * 8] ^= 1;
+
+        expect(d.consumeNewSync().length).to.equal(1);
+        expect(d.checksumErrors).to.equal(1);
+        expect(d.verifyChecksums()).to.equal(1);
+        expect(d.verifyChecksums(1)).to.equal(0);
+        expect(d.verifyChecksums(2)).to.equal(1);
+        expect(d.verifyChecksums(0, 4)).to.equal(1);
+
+        // Fixed by producing again
+        d.consumeCommit();
+        expect(p.produceSync(Buffer.alloc(8 * 8))).to.be.true;
+        expect(d.consumeNewSync().length).to.equal(2);
+        expect(d.checksumErrors).to.equal(1);
+    });
+
+    it('should cover columns', function ()
+    {
+        const columns = { qty: 'uint32' };
+        const p2 = new Disruptor('/test2', 8, 0, 1, 0, true, false, { checksum: true, columns });
+        const d2 = new Disruptor('/test2', 8, 0, 1, 0, false, false, { checksum: true, columns });
+
+        expect(p2.produceClaimManySync(2).length).to.equal(2);
+        p2.columns.qty[0] = 10;
+        p2.columns.qty[1] = 20;
+        expect(p2.produceCommitSync()).to.be.true;
+        expect(d2.verifyChecksums(0, 2)).to.equal(0);
+
+        p2.columns.qty[1] = 21;
+        expect(d2.consumeNewSync().length).to.equal(2);
+        expect(d2.checksumErrors).to.equal(1);
+
+        p2.release();
+        d2.release();
+    });
+
+    it('should throw error if checksums not enabled or slots not available', function ()
+    {
+        expect(function ()
+        {
+            d.verifyChecksums(4);
+        }).to.throw('slots not available');
+
+        const d2 = new Disruptor('/test2', 8, 8, 1, 0, true, false);
+        expect(function ()
+        {
+            d2.verifyChecksums();
+        }).to.throw('checksums not enabled');
+        d2.release();
+    });
+});
+
+describe('reclaim', function ()
+{
+    let p, d;
+
+    beforeEach(function ()
+    {
+        p = new Disruptor('/test', 64, 4096, 1, 0, true, false, { reclaim: true, reclaimInterval: 10000, reclaimDistance: 16 });
+        d = new Disruptor('/test', 64, 4096, 1, 0, false, false);
+    });
+
+    afterEach(function ()
+    {
+        p.release();
+        d.release();
+    });
+
+    async function reclaimed(n)
+    {
+        while (p.reclaimed < n)
+        {
+            await new Promise(resolve => setTimeout(resolve, 10));
+        }
+    }
+
+    it('should give back free slots far from next', async function ()
+    {
+        this.timeout(10000);
+
+        for (let i = 0; i < 64; i += 1)
+        {
+            expect(p.produceSync(Buffer.alloc(4096, i))).to.be.true;
+        }
+
+        // Nothing is free until the consumer has read it
+        await new Promise(resolve => setTimeout(resolve, 50));
+        expect(p.reclaimed).to.equal(0);
+
+        expect(d.consumeNewSync().length).to.equal(1);
+        expect(d.consumeCommit()).to.be.true;
+
+        // All but the 16 slots after next, in whole pages
+        await reclaimed(1);
+        expect(p.reclaimed).to.be.at.most(48 * 4096);
+        expect(p.elements.readUInt8(16 * 4096)).to.equal(16);
+        expect(p.elements.readUInt8(62 * 4096)).to.equal(0);
+
+        // Reclaimed slots can be used again
+        for (let i = 0; i < 64; i += 1)
+        {
+            expect(p.produceSync(Buffer.alloc(4096, 100 + i))).to.be.true;
+        }
+        const bufs = d.consumeNewSync();
+        expect(bufs.length).to.equal(1);
+        for (let i = 0; i < 64; i += 1)
+        {
+            expect(bufs[0].readUInt8(i * 4096)).to.equal(100 + i);
+            expect(bufs[0].readUInt8(i * 4096 + 4095)).to.equal(100 + i);
+        }
+    });
+
+    it('should not rewind onto reclaimed slots', async function ()
+    {
+        this.timeout(10000);
+
+        for (let i = 0; i < 64; i += 1)
+        {
+            expect(p.produceSync(Buffer.alloc(4096, i))).to.be.true;
+        }
+        expect(d.consumeNewSync().length).to.equal(1);
+        expect(d.consumeCommit()).to.be.true;
+
+        await reclaimed(1);
+        expect(d.consumeRewind(64)).to.equal(64);
+        expect(d.consumeNewSync()).to.eql([]);
+    });
+
+    it('should not read reclaimed slots', async function ()
+    {
+        this.timeout(10000);
+
+        const c = new Disruptor('/test_reclaim_sum', 64, 4096, 1, 0, true, false, { reclaim: true, reclaimInterval: 10000, reclaimDistance: 16, checksum: true });
+
+        for (let i = 0; i < 64; i += 1)
+        {
+            expect(c.produceSync(Buffer.alloc(4096, i))).to.be.true;
+        }
+        expect(c.consumeNewSync().length).to.equal(1);
+        expect(c.consumeCommit()).to.be.true;
+
+        while (c.reclaimed === 0)
+        {
+            await new Promise(resolve => setTimeout(resolve, 10));
+        }
+
+        // Slots up to the end of the reclaimed range aren't available
+        expect(c.readAt(16)).to.eql([]);
+        expect(c.readAt(63)).to.eql([]);
+        expect(function ()
+        {
+            c.verifyChecksums(16, 1);
+        }).to.throw('slots not available');
+
+        // New data is
+        expect(c.produceSync(Buffer.alloc(4096, 64))).to.be.true;
+        expect(c.readAt(64)[0].readUInt8(0)).to.equal(64);
+        expect(c.verifyChecksums(64, 1)).to.equal(0);
+
+        c.release();
+    });
+
+    it('should have nothing reclaimed if not enabled', function ()
+    {
+        expect(d.reclaimed).to.equal(0);
+    });
+
+    it('should throw error if used with overwrite', function ()
+    {
+        expect(function ()
+        {
+            new Disruptor('/test2', 64, 4096, 1, 0, true, false, { reclaim: true, overwrite: true });
+        }).to.throw("overwrite and reclaim can't be used together");
+    });
+});
+
+describe('produce data', function ()
+{
+    let d;
+
+    beforeEach(function ()
+    {
+        d = new Disruptor('/test', 4, 4, 1, 0, true, false);
+    });
+
+    afterEach(function ()
+    {
+        d.release();
+    });
+
+    it('should write different types of data', function ()
+    {
+        expect(d.produceSync(Buffer.from([1, 2, 3, 4]))).to.be.true;
+        expect(d.produceSync(new Uint16Array([0x0605, 0x0807, 0x0a09]).subarray(1))).to.be.true;
+        expect(d.produceSync(new Uint8Array([11]).buffer)).to.be.true;
+        expect(d.cursor).to.equal(3);
+        expect(d.next).to.equal(3);
+        expect(Buffer.concat(d.consumeNewSync()).equals(Buffer.from(
+            [1, 2, 3, 4, 7, 8, 9, 10, 11, 0, 0, 0]))).to.be.true;
+        d.consumeCommit();
+
+        // wraps around
+        expect(d.produceSync('hello')).to.be.true;
+        expect(d.cursor).to.equal(5);
+        expect(Buffer.concat(d.consumeNewSync()).toString()).to.equal('hello\0\0\0');
+        d.consumeCommit();
+
+        expect(d.produceSync('')).to.be.true;
+        expect(Buffer.concat(d.consumeNewSync()).equals(Buffer.alloc(4))).to.be.true;
+    });
+
+    it('should write many values at once', function ()
+    {
+        expect(d.produceManySync([])).to.be.true;
+        expect(d.next).to.equal(0);
+
+        expect(d.produceManySync(['ab', Buffer.from('cdefg'), 'h'])).to.be.true;
+        expect(d.cursor).to.equal(4);
+        expect(Buffer.concat(d.consumeNewSync()).toString()).to.equal('ab\0\0cdefg\0\0\0h\0\0\0');
+        expect(d.prevClaimStart).to.equal(1);
+        expect(d.prevClaimEnd).to.equal(0);
+    });
+
+    it('should return false if full', function ()
+    {
+        expect(d.produceManySync(['a', 'b', 'c'])).to.be.true;
+        expect(d.produceManySync(['d', 'e'])).to.be.false;
+        expect(d.produceSync('fghij')).to.be.false;
+        expect(d.produceSync('f')).to.be.true;
+        expect(d.produceSync('g')).to.be.false;
+        expect(d.cursor).to.equal(4);
+        expect(d.next).to.equal(4);
+        expect(Buffer.concat(d.consumeNewSync()).toString()).to.equal('a\0\0\0b\0\0\0c\0\0\0f\0\0\0');
+    });
+
+    it('should throw error if data is too large or of the wrong type', function ()
+    {
+        expect(function ()
+        {
+            d.produceSync(Buffer.alloc(17));
+        }).to.throw('data too large');
+
+        expect(function ()
+        {
+            d.produceManySync(['a', 'b', 'c', 'd', 'e']);
+        }).to.throw('data too large');
+
+        expect(function ()
+        {
+            d.produceSync(42);
+        }).to.throw('data must be a Buffer, TypedArray, ArrayBuffer or string');
+
+        expect(d.next).to.equal(0);
+    });
+
+    it('should return false if all consumers are ignoring', function ()
+    {
+        const d2 = new Disruptor('/test', 4, 4, 1, 0, false, false);
+        d2.release(true);
+        expect(d.produceSync('a')).to.be.false;
+        expect(d.allConsumersIgnoring).to.be.true;
+    });
+
+    it('should throw error if a claim is pending', function ()
+    {
+        expect(d.produceClaimSync().length).to.equal(4);
+        expect(function ()
+        {
+            d.produceSync('a');
+        }).to.throw('claim pending');
+        expect(d.produceCommitSync()).to.be.true;
+        expect(d.produceSync('a')).to.be.true;
+        expect(d.cursor).to.equal(2);
+    });
+});
+
+describe('sequences view', function ()
+{
+    let d, d2;
+
+    beforeEach(function ()
+    {
+        d = new Disruptor('/test', 16, 4, 2, 0, true, false);
+        d2 = new Disruptor('/test', 16, 4, 2, 1, false, false);
+    });
+
+    afterEach(function ()
+    {
+        d.release();
+        d2.release();
+    });
+
+    function js_consume(d, c)
+    {
+        const seqs = d.sequences;
+        const cursor = Atomics.load(seqs, 2);
+        let r = [];
+        for (let seq = Atomics.load(seqs, c); seq < cursor; seq += 1n)
+        {
+            r.push(d.elements.readUInt32LE(Number(seq % 16n) * 4));
+        }
+        Atomics.store(seqs, c, cursor);
+        return r;
+    }
+
+    function js_produce(d, values)
+    {
+        const seqs = d.sequences;
+        const count = BigInt(values.length);
+        let n;
+        do
+        {
+            n = Atomics.load(seqs, 3);
+            for (let c = 0; c < 2; c += 1)
+            {
+                expect(n + count - Atomics.load(seqs, c) <= 16n).to.be.true;
+            }
+        }
+        while (Atomics.compareExchange(seqs, 3, n, n + count) !== n);
+        for (let i = 0; i < values.length; i += 1)
+        {
+            d.elements.writeUInt32LE(values[i], Number((n + BigInt(i)) % 16n) * 4);
+        }
+        expect(Atomics.load(seqs, 2)).to.equal(n);
+        Atomics.store(seqs, 2, n + count);
+    }
+
+    it('should expose sequence numbers', function ()
+    {
+        const seqs = d.sequences;
+        expect(seqs).to.be.an.instanceof(BigUint64Array);
+        expect(seqs.length).to.equal(4);
+        expect(Array.from(seqs)).to.eql([0n, 0n, 0n, 0n]);
+
+        const bufs = d.produceClaimManySync(5);
+        expect(Array.from(seqs)).to.eql([0n, 0n, 0n, 5n]);
+        bufs[0].writeUInt32LE(42);
+        expect(d.produceCommitSync()).to.be.true;
+        expect(Array.from(seqs)).to.eql([0n, 0n, 5n, 5n]);
+
+        expect(d2.consumeNewSync().length).to.equal(1);
+        expect(d2.consumeCommit()).to.be.true;
+        expect(Array.from(d2.sequences)).to.eql([0n, 5n, 5n, 5n]);
+    });
+
+    it('should consume from JavaScript', function ()
+    {
+        for (let i = 0; i < 16; i += 1)
+        {
+            d.produceClaimSync().writeUInt32LE(i);
+            expect(d.produceCommitSync()).to.be.true;
+        }
+        expect(d.produceClaimSync().length).to.equal(0);
+
+        let expected = [];
+        for (let i = 0; i < 16; i += 1)
+        {
+            expected.push(i);
+        }
+        expect(js_consume(d, 0)).to.eql(expected);
+        expect(js_consume(d2, 1)).to.eql(expected);
+        expect(js_consume(d, 0)).to.eql([]);
+        expect(d.consumer).to.equal(16);
+
+        expect(d.produceClaimManySync(16).length).to.be.above(0);
+    });
+
+    it('should produce from JavaScript', function ()
+    {
+        js_produce(d, [1, 2, 3]);
+        js_produce(d2, [4, 5]);
+        expect(d.cursor).to.equal(5);
+        expect(d.next).to.equal(5);
+        expect(Buffer.concat(d2.consumeNewSync()).equals(Buffer.from([1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4, 0, 0, 0, 5, 0, 0, 0]))).to.be.true;
+    });
+
+    it('should stay aligned when mapping is reused', function ()
+    {
+        for (let i = 0; i < 20; i += 1)
+        {
+            const d3 = new Disruptor('/test', 16, 4, 2, 0, false, false);
+            expect(d3.sequences.byteOffset % 8).to.equal(0);
+            expect(d3.sequences.length).to.equal(4);
+            d3.release();
+        }
+    });
+});
+
+describe('random access', function ()
+{
+    let d, d2;
+
+    beforeEach(function ()
+    {
+        d = new Disruptor('/test', 16, 4, 2, 0, true, false);
+        d2 = new Disruptor('/test', 16, 4, 2, 1, false, false);
+    });
+
+    afterEach(function ()
+    {
+        d.release();
+        d2.release();
+    });
+
+    function produce(n)
+    {
+        let seq = d.next;
+        for (let b of d.produceClaimManySync(n))
+        {
+            for (let i = 0; i < b.length; i += 4)
+            {
+                b.writeUInt32LE(seq++, i, true);
+            }
+        }
+        expect(d.produceCommitSync()).to.be.true;
+    }
+
+    function values(bufs)
+    {
+        let r = [];
+        for (let b of bufs)
+        {
+            for (let i = 0; i < b.length; i += 4)
+            {
+                r.push(b.readUInt32LE(i, true));
+            }
+        }
+        return r;
+    }
+
+    function consumeAll(d)
+    {
+        d.consumeNewSync();
+        expect(d.consumeCommit()).to.be.true;
+    }
+
+    it('should read at sequence', function ()
+    {
+        expect(d.readAt(0)).to.eql([]);
+
+        produce(10);
+
+        expect(values(d.readAt(0, 10))).to.eql([0, 1, 2, 3, 4, 5, 6, 7, 8, 9]);
+        expect(values(d.readAt(3, 2))).to.eql([3, 4]);
+        expect(values(d.readAt(9))).to.eql([9]);
+        expect(d.readAt(10)).to.eql([]);
+        expect(d.readAt(5, 6)).to.eql([]);
+        expect(d.readAt(5, 0)).to.eql([]);
+        expect(d.readAt(0, 17)).to.eql([]);
+
+        // Reading doesn't consume
+        expect(d.consumer).to.equal(0);
+
+        consumeAll(d);
+        consumeAll(d2);
+        produce(10);
+
+        expect(d.readAt(3)).to.eql([]);
+        let bufs = d.readAt(4, 16);
+        expect(bufs.length).to.equal(2);
+        expect(bufs[0].length).to.equal(12 * 4);
+        expect(bufs[1].length).to.equal(4 * 4);
+        expect(values(bufs)).to.eql([4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19]);
+        expect(values(d.readAt(14, 4))).to.eql([14, 15, 16, 17]);
+        expect(values(d.readAt(16, 4))).to.eql([16, 17, 18, 19]);
+    });
+
+    it('should rewind consumer', function ()
+    {
+        produce(10);
+        consumeAll(d);
+        expect(d.consumer).to.equal(10);
+
+        expect(d.consumeRewind(4)).to.equal(6);
+        expect(d.consumer).to.equal(6);
+        expect(values(d.consumeNewSync())).to.eql([6, 7, 8, 9]);
+        expect(d.prevConsumeStart).to.equal(6);
+        expect(d.consumeCommit()).to.be.true;
+
+        // Consumer 1 hasn't read anything so we can go back to the start
+        expect(d.consumeRewind(100)).to.equal(0);
+        expect(d.consumer).to.equal(0);
+
+        // Data returned before rewinding isn't committed
+        d.consumeNewSync();
+        expect(d.consumeRewind(1)).to.equal(0);
+        expect(d.consumeCommit()).to.be.true;
+        expect(d.consumer).to.equal(0);
+
+        // Can't go back past consumer 1 but don't skip unread data
+        consumeAll(d2);
+        expect(d.consumeRewind(100)).to.equal(0);
+        consumeAll(d);
+        expect(d.consumer).to.equal(10);
+        expect(d.consumeRewind(100)).to.equal(10);
+        expect(d.consumeRewind(0)).to.equal(10);
+
+        // Ignored consumer can re-attach
+        produce(10);
+        consumeAll(d);
+        consumeAll(d2);
+        d.release(true);
+        expect(d2.consumeRewind(100)).to.equal(4);
+        d = new Disruptor('/test', 16, 4, 2, 0, false, false);
+        expect(d.consumeRewind(100)).to.equal(4);
+        expect(values(d.consumeNewSync())).to.eql([4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19]);
+    });
+
+    it('should rewind to slowest other consumer', function ()
+    {
+        const ds = [0, 1, 2].map(i => new Disruptor('/test2', 16, 4, 3, i, i === 0, false));
+
+        let seq = 0;
+        for (let b of ds[0].produceClaimManySync(10))
+        {
+            for (let i = 0; i < b.length; i += 4)
+            {
+                b.writeUInt32LE(seq++, i, true);
+            }
+        }
+        expect(ds[0].produceCommitSync()).to.be.true;
+
+        ds[0].consumeNewSync();
+        expect(ds[0].consumeCommit()).to.be.true;
+        ds[1].consumeNewSync(4);
+        expect(ds[1].consumeCommit()).to.be.true;
+        ds[2].consumeNewSync(8);
+        expect(ds[2].consumeCommit()).to.be.true;
+
+        expect(ds[0].consumeRewind(100)).to.equal(4);
+        expect(values(ds[0].consumeNewSync())).to.eql([4, 5, 6, 7, 8, 9]);
+
+        for (const d of ds)
+        {
+            d.release();
+        }
+    });
+});
+
+describe('overwrite mode', function ()
+{
+    let d;
+
+    beforeEach(function ()
+    {
+        d = new Disruptor('/test', 16, 4, 1, 0, true, false, { overwrite: true });
+    });
+
+    afterEach(function ()
+    {
+        d.release();
+    });
+
+    function produce(n)
+    {
+        let seq = d.next;
+        for (let b of d.produceClaimManySync(n))
+        {
+            for (let i = 0; i < b.length; i += 4)
+            {
+                b.writeUInt32LE(seq++, i, true);
+            }
+        }
+        expect(d.produceCommitSync()).to.be.true;
+    }
+
+    function values(bufs)
+    {
+        let r = [];
+        for (let b of bufs)
+        {
+            for (let i = 0; i < b.length; i += 4)
+            {
+                r.push(b.readUInt32LE(i, true));
+            }
+        }
+        return r;
+    }
+
+    it('should rewind a consumer producers have lapped', function ()
+    {
+        produce(10);
+        expect(values(d.consumeNewSync()).length).to.equal(10);
+        expect(d.consumeCommit()).to.be.true;
+
+        for (let i = 0; i < 4; i += 1)
+        {
+            produce(10);
+        }
+
+        // Overwritten data is skipped and counted as dropped
+        expect(d.consumeRewind(5)).to.equal(45);
+        expect(d.dropped).to.equal(35);
+        expect(values(d.consumeNewSync())).to.eql([45, 46, 47, 48, 49]);
+    });
+
+    it('should not wait for consumers', function ()
+    {
+        produce(10);
+        expect(values(d.consumeNewSync())).to.eql([0, 1, 2, 3, 4, 5, 6, 7, 8, 9]);
+        expect(d.consumeCheck()).to.equal(0);
+        expect(d.consumeCommit()).to.be.true;
+        expect(d.dropped).to.equal(0);
+
+        for (let i = 0; i < 4; i += 1)
+        {
+            produce(10);
+        }
+        expect(d.cursor).to.equal(50);
+        expect(d.allConsumersIgnoring).to.be.false;
+
+        let bufs = d.consumeNewSync();
+        expect(bufs.length).to.equal(2);
+        expect(values(bufs)).to.eql([34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49]);
+        expect(d.prevConsumeStart).to.equal(34);
+        expect(d.dropped).to.equal(24);
+        expect(d.consumeCheck()).to.equal(0);
+
+        // Overwriting while we're reading should be detected
+        expect(d.produceClaimSync().length).to.equal(4);
+        expect(d.prevClaimStart).to.equal(50);
+        expect(d.consumeCheck()).to.equal(1);
+        expect(d.produceCommitSync()).to.be.true;
+        expect(d.consumeCheck()).to.equal(1);
+        expect(d.consumeCommit()).to.be.true;
+        expect(d.consumer).to.equal(50);
+
+        expect(d.readAt(34)).to.eql([]);
+        expect(values(d.readAt(40, 5))).to.eql([40, 41, 42, 43, 44]);
+
+        // Can't overwrite slots other producers haven't committed
+        expect(d.produceClaimManySync(100).length).to.equal(2);
+        expect(d.prevClaimStart).to.equal(51);
+        expect(d.prevClaimEnd).to.equal(66);
+        expect(d.produceClaimSync().length).to.equal(0);
+        expect(d.produceClaimAvailSync(100).length).to.equal(0);
+        expect(d.produceCommitSync(51, 66)).to.be.true;
+        expect(d.produceClaimAvailSync(100).length).to.equal(2);
+        expect(d.prevClaimStart).to.equal(67);
+        expect(d.prevClaimEnd).to.equal(82);
+
+        // Slots being overwritten are skipped
+        expect(values(d.consumeNewSync())).to.eql([]);
+        expect(d.dropped).to.equal(24 + 17);
+        expect(d.consumer).to.equal(67);
+        expect(d.produceCommitSync()).to.be.true;
+        expect(d.consumeNewSync().length).to.equal(2);
+        expect(d.prevConsumeStart).to.equal(67);
+        expect(d.dropped).to.equal(24 + 17);
+    });
+
+    it('should check layout matches', function ()
+    {
+        if (process.platform === 'darwin')
+        {
+            // shm sizes are rounded up to the page size
+            return this.skip();
+        }
+
+        expect(function ()
+        {
+            new Disruptor('/test', 16, 4, 2, 0, false, false, { overwrite: true });
+        }).to.throw('Shared memory is too small');
+    });
+});
+
 describe('async spin', function ()
 {
     this.timeout(60000);
@@ -0,0 +1,130 @@
+const { Worker } = require('worker_threads');
+const path = require('path');
+let expect;
+const { SnapshotTable, Disruptor } = require('..');
+
+before(async function () {
+    ({ expect } = await import('chai'));
+});
+
+describe('snapshot table', function () {
+    this.timeout(60000);
+
+    let t;
+
+    beforeEach(function () {
+        t = new SnapshotTable('/test_snapshot', 10, 12, true);
+    });
+
+    afterEach(function () {
+        t.release();
+    });
+
+    it('should read and write values', function () {
+        expect(t.numKeys).to.equal(10);
+        expect(t.valueSize).to.equal(12);
+
+        for (let i = 0; i < 10; i += 1) {
+            expect(t.version(i)).to.equal(0);
+            expect(t.read(i)).to.be.null;
+        }
+
+        expect(t.write(3, Buffer.from('hello'))).to.equal(2);
+        expect(t.version(3)).to.equal(2);
+        expect(t.read(3).equals(Buffer.concat([Buffer.from('hello'), Buffer.alloc(7)]))).to.be.true;
+
+        expect(t.write(3, Buffer.from('hello there world'))).to.equal(4);
+        expect(t.read(3).toString()).to.equal('hello there ');
+
+        expect(t.write(9, new Uint8Array([1, 2, 3]))).to.equal(2);
+        expect(t.read(9).equals(Buffer.from([1, 2, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0]))).to.be.true;
+
+        expect(t.read(0)).to.be.null;
+    });
+
+    it('should share values', function () {
+        const t2 = new SnapshotTable('/test_snapshot', 10, 12, false);
+        t.write(5, Buffer.from('foo'));
+        expect(t2.version(5)).to.equal(2);
+        expect(t2.read(5).toString()).to.equal('foo\0\0\0\0\0\0\0\0\0');
+        t2.write(5, Buffer.from('bar'));
+        expect(t.version(5)).to.equal(4);
+        expect(t.read(5).toString()).to.equal('bar\0\0\0\0\0\0\0\0\0');
+        t2.release();
+    });
+
+    it('should throw error if key out of range', function () {
+        expect(function () {
+            t.read(10);
+        }).to.throw('key out of range');
+
+        expect(function () {
+            t.write(10, Buffer.alloc(1));
+        }).to.throw('key out of range');
+
+        expect(function () {
+            t.version(10);
+        }).to.throw('key out of range');
+    });
+
+    it('should recover if a writer died part way through', function () {
+        // Map the same memory so we can make key 0's version odd
+        const d = new Disruptor('/test_snapshot_dead', 1, 64, 1, 0, true, false);
+        const t2 = new SnapshotTable('/test_snapshot_dead', 1, 12, false, { retries: 10 });
+        d.consumers.writeUInt32LE(3, 0);
+
+        expect(t2.version(0)).to.equal(3);
+        expect(t2.read(0)).to.be.undefined;
+        expect(t2.read(0, 1)).to.be.undefined;
+
+        // The next write carries on without waiting
+        expect(t2.write(0, Buffer.from('foo'))).to.equal(4);
+        expect(t2.read(0).toString()).to.equal('foo\0\0\0\0\0\0\0\0\0');
+        expect(t2.write(0, Buffer.from('bar'))).to.equal(6);
+
+        t2.release();
+        d.release();
+    });
+
+    it('should read consistent values while another thread writes', function (done) {
+        const worker = new Worker(`
+            const { SnapshotTable } = require(${JSON.stringify(path.join(__dirname, '..'))});
+            const t = new SnapshotTable('/test_snapshot', 10, 12, false);
+            for (let i = 0; i < 100000; i += 1) {
+                t.write(0, Buffer.alloc(12, i % 256));
+            }
+            t.release();
+        `, { eval: true });
+
+        let reads = 0, finished = false;
+
+        function check() {
+            const v = t.read(0);
+            if (v) {
+                for (let i = 1; i < v.length; i += 1) {
+                    expect(v[i]).to.equal(v[0]);
+                }
+                reads += 1;
+            }
+        }
+
+        worker.on('exit', function () {
+            finished = true;
+            check();
+            expect(t.version(0)).to.equal(200000);
+            expect(t.read(0).equals(Buffer.alloc(12, 99999 % 256))).to.be.true;
+            expect(reads).to.be.above(0);
+            done();
+        });
+
+        (function loop() {
+            if (finished) {
+                return;
+            }
+            for (let i = 0; i < 1000; i += 1) {
+                check();
+            }
+            setImmediate(loop);
+        })();
+    });
+});